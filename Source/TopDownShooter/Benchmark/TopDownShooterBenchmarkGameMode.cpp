@@ -0,0 +1,360 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterBenchmarkGameMode.h"
+#include "Character/TopDownShooterCharacter.h"
+#include "Character/TopDownShooterInventorComponent.h"
+#include "Game/TopDownShooterGameInstance.h"
+#include "AIController.h"
+#include "Engine/World.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/App.h"
+#include "Misc/DateTime.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "UObject/UObjectGlobals.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterMemory.h"
+
+ATopDownShooterBenchmarkGameMode::ATopDownShooterBenchmarkGameMode()
+{
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = true;
+	//bots do the fighting, the local player only watches
+	bStartPlayersAsSpectators = true;
+
+	BotClass = DefaultPawnClass.Get();
+	if (!BotClass)
+		BotClass = ATopDownShooterCharacter::StaticClass();
+}
+
+void ATopDownShooterBenchmarkGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	NumBots = FMath::Max(UGameplayStatics::GetIntOption(Options, TEXT("Bots"), NumBots), 1);
+	BenchSeconds = FMath::Max((float)UGameplayStatics::GetIntOption(Options, TEXT("Seconds"), (int32)BenchSeconds), 1.0f);
+	WarmupSeconds = FMath::Max((float)UGameplayStatics::GetIntOption(Options, TEXT("Warmup"), (int32)WarmupSeconds), 0.0f);
+	SwitchInterval = (float)UGameplayStatics::GetIntOption(Options, TEXT("SwitchInterval"), (int32)SwitchInterval);
+	ArenaRadius = (float)UGameplayStatics::GetIntOption(Options, TEXT("Radius"), (int32)ArenaRadius);
+	Seed = UGameplayStatics::GetIntOption(Options, TEXT("Seed"), Seed);
+	bExitWhenDone = !UGameplayStatics::HasOption(Options, TEXT("NoExit"));
+
+	CsvPath = UGameplayStatics::ParseOption(Options, TEXT("Csv"));
+	if (CsvPath.IsEmpty())
+		CsvPath = FPaths::ProjectSavedDir() / TEXT("Benchmark") / TEXT("TopDownShooterBenchmark.csv");
+}
+
+void ATopDownShooterBenchmarkGameMode::StartPlay()
+{
+	//same simulated frames on every machine, wall time per frame is what gets measured
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / 60.0);
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+
+	WarmupFrames = FMath::RoundToInt(WarmupSeconds * 60.0f);
+	MeasuredFrames = FMath::RoundToInt(BenchSeconds * 60.0f);
+	FrameMs.Reserve(MeasuredFrames);
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &ATopDownShooterBenchmarkGameMode::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &ATopDownShooterBenchmarkGameMode::OnPostGarbageCollect);
+
+	Super::StartPlay();
+
+	SpawnBots();
+	UE_LOG(LogTopDownShooter, Log, TEXT("ATopDownShooterBenchmarkGameMode::StartPlay - %d bots, %.0f s warmup, %.0f s measured"), Bots.Num(), WarmupSeconds, BenchSeconds);
+}
+
+void ATopDownShooterBenchmarkGameMode::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+	FApp::SetUseFixedTimeStep(false);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ATopDownShooterBenchmarkGameMode::SpawnBots()
+{
+	UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetGameInstance());
+	if (!myGI || !myGI->WeaponInfoTable || !BotClass)
+	{
+		UE_LOG(LogTopDownShooter, Error, TEXT("ATopDownShooterBenchmarkGameMode::SpawnBots - no weapon table or bot class"));
+		return;
+	}
+
+	const TArray<FName> WeaponNames = myGI->WeaponInfoTable->GetRowNames();
+	if (WeaponNames.Num() == 0)
+		return;
+
+	AActor* myStart = FindPlayerStart(nullptr);
+	ArenaCenter = myStart ? myStart->GetActorLocation() : FVector::ZeroVector;
+
+	//ammo of every type, topped up each frame, reloads still happen because clips run dry
+	//(inventory reload math is int8, so stay below 128)
+	TArray<FAmmoSlot> myAmmoSlots;
+	for (uint8 Type = (uint8)EWeaponType::RifleType; Type <= (uint8)EWeaponType::GrenadeLauncherType; Type++)
+	{
+		FAmmoSlot myAmmo;
+		myAmmo.WeaponType = (EWeaponType)Type;
+		myAmmo.Cout = 120;
+		myAmmo.MaxCout = 120;
+		myAmmoSlots.Add(myAmmo);
+	}
+
+	for (int32 i = 0; i < NumBots; i++)
+	{
+		//ring around the start, everybody facing the middle
+		const float Angle = 2.0f * PI * i / NumBots;
+		const FVector Location = ArenaCenter + FVector(FMath::Cos(Angle), FMath::Sin(Angle), 0.0f) * ArenaRadius;
+		const FTransform SpawnTransform((ArenaCenter - Location).Rotation(), Location);
+
+		ATopDownShooterCharacter* myBot = GetWorld()->SpawnActorDeferred<ATopDownShooterCharacter>(BotClass, SpawnTransform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn);
+		if (!myBot)
+			continue;
+
+		//the bot's own weapon first, the rest of the table to switch through
+		myBot->InventoryComponent->WeaponSlots.Reset();
+		for (int32 j = 0; j < WeaponNames.Num(); j++)
+		{
+			FWeaponSlot mySlot;
+			mySlot.NameItem = WeaponNames[(i + j) % WeaponNames.Num()];
+			myBot->InventoryComponent->WeaponSlots.Add(mySlot);
+		}
+		myBot->InventoryComponent->AmmoSlots = myAmmoSlots;
+		myBot->InventoryComponent->MarkPickupEligibilityDirty();
+		myBot->AIControllerClass = AAIController::StaticClass();
+		myBot->AutoPossessAI = EAutoPossessAI::Disabled;
+
+		UGameplayStatics::FinishSpawningActor(myBot, SpawnTransform);
+		myBot->SpawnDefaultController();
+
+		Bots.Add(myBot);
+		BotSwitchDirection.Add(1);
+		BotSwitchCount.Add(0);
+		SeedBotWeapon(Bots.Num() - 1);
+		myBot->AttackCharEvent(true);
+	}
+}
+
+void ATopDownShooterBenchmarkGameMode::SeedBotWeapon(int32 BotIndex)
+{
+	AWeaponDefault* myWeapon = Bots[BotIndex] ? Bots[BotIndex]->GetCurrentWeapon() : nullptr;
+	if (myWeapon)
+		myWeapon->WeaponRandomStream.Initialize(int32(HashCombine(uint32(Seed), HashCombine(uint32(BotIndex), uint32(BotSwitchCount[BotIndex])))));
+}
+
+void ATopDownShooterBenchmarkGameMode::SwitchBotWeapon(int32 BotIndex)
+{
+	ATopDownShooterCharacter* myBot = Bots[BotIndex];
+	const int32 NumSlots = myBot->InventoryComponent->WeaponSlots.Num();
+	if (NumSlots < 2)
+		return;
+
+	//walk back and forth through the slots, switching also cancels reloads in flight
+	if (myBot->CurrentIndexWeapon + BotSwitchDirection[BotIndex] >= NumSlots || myBot->CurrentIndexWeapon + BotSwitchDirection[BotIndex] < 0)
+		BotSwitchDirection[BotIndex] = -BotSwitchDirection[BotIndex];
+
+	if (BotSwitchDirection[BotIndex] > 0)
+		myBot->TrySwicthNextWeapon();
+	else
+		myBot->TrySwitchPreviosWeapon();
+
+	BotSwitchCount[BotIndex]++;
+	SeedBotWeapon(BotIndex);
+	myBot->AttackCharEvent(true);
+}
+
+void ATopDownShooterBenchmarkGameMode::UpdateBots()
+{
+	const float Time = FramesSimulated / 60.0f;
+	const int32 SwitchFrames = SwitchInterval > 0.0f ? FMath::Max(FMath::RoundToInt(SwitchInterval * 60.0f), 1) : 0;
+
+	for (int32 i = 0; i < Bots.Num(); i++)
+	{
+		ATopDownShooterCharacter* myBot = Bots[i];
+		if (!myBot)
+			continue;
+
+		for (FAmmoSlot& myAmmo : myBot->InventoryComponent->AmmoSlots)
+		{
+			myAmmo.Cout = myAmmo.MaxCout;
+		}
+
+		//sweep the aim around the middle so shots spread over characters and floor
+		const float Phase = Time * 0.7f + i;
+		myBot->SetAimOverride(ArenaCenter + FVector(FMath::Cos(Phase), FMath::Sin(Phase), 0.0f) * ArenaRadius * 0.5f);
+
+		//staggered so not every bot switches on the same frame
+		if (SwitchFrames > 0 && (FramesSimulated + i * 7) % SwitchFrames == 0)
+			SwitchBotWeapon(i);
+	}
+}
+
+void ATopDownShooterBenchmarkGameMode::Tick(float DeltaSeconds)
+{
+	Super::Tick(DeltaSeconds);
+
+	if (bFinished)
+		return;
+
+	UpdateBots();
+	SampleFrame();
+	FramesSimulated++;
+
+	if (FramesSimulated >= WarmupFrames + MeasuredFrames)
+		FinishBenchmark();
+}
+
+void ATopDownShooterBenchmarkGameMode::SampleFrame()
+{
+	const double Now = FPlatformTime::Seconds();
+	const double FrameSeconds = LastFrameSeconds > 0.0 ? Now - LastFrameSeconds : 0.0;
+	LastFrameSeconds = Now;
+
+	const int32 TracesThisFrame = FTopDownShooterCounters::Traces - TracesAtLastFrame;
+	TracesAtLastFrame = FTopDownShooterCounters::Traces;
+
+	if (FramesSimulated < WarmupFrames)
+		return;
+
+	if (FramesSimulated == WarmupFrames)
+	{
+		ShotsAtStart = FTopDownShooterCounters::ShotsFired;
+		LLMBytesAtStart.Reset();
+		for (int32 i = 0; i < int32(ETopDownShooterLLMTag::Count); i++)
+			LLMBytesAtStart.Add(FTopDownShooterMemory::GetTrackedBytes(ETopDownShooterLLMTag(i)));
+		GCTotalMs = 0.0;
+		GCMaxMs = 0.0;
+		GCCount = 0;
+		return;
+	}
+
+	FrameMs.Add(float(FrameSeconds * 1000.0));
+	TracesTotal += TracesThisFrame;
+	MaxTracesPerFrame = FMath::Max(MaxTracesPerFrame, TracesThisFrame);
+	ProjectilesAliveSum += FTopDownShooterCounters::LiveProjectiles;
+	ProjectilesAliveMax = FMath::Max(ProjectilesAliveMax, FTopDownShooterCounters::LiveProjectiles);
+	DebrisSum += FTopDownShooterCounters::DebrisActors;
+	DebrisMax = FMath::Max(DebrisMax, FTopDownShooterCounters::DebrisActors);
+}
+
+void ATopDownShooterBenchmarkGameMode::OnPreGarbageCollect()
+{
+	GCStartSeconds = FPlatformTime::Seconds();
+}
+
+void ATopDownShooterBenchmarkGameMode::OnPostGarbageCollect()
+{
+	if (GCStartSeconds <= 0.0)
+		return;
+
+	const double Ms = (FPlatformTime::Seconds() - GCStartSeconds) * 1000.0;
+	GCStartSeconds = 0.0;
+	GCTotalMs += Ms;
+	GCMaxMs = FMath::Max(GCMaxMs, Ms);
+	GCCount++;
+}
+
+void ATopDownShooterBenchmarkGameMode::FinishBenchmark()
+{
+	bFinished = true;
+
+	for (ATopDownShooterCharacter* myBot : Bots)
+	{
+		if (myBot)
+			myBot->AttackCharEvent(false);
+	}
+
+	if (WriteCsv())
+		UE_LOG(LogTopDownShooter, Log, TEXT("ATopDownShooterBenchmarkGameMode::FinishBenchmark - results appended to %s"), *CsvPath);
+
+	if (bExitWhenDone)
+		FPlatformMisc::RequestExit(false);
+}
+
+bool ATopDownShooterBenchmarkGameMode::WriteCsv() const
+{
+	if (FrameMs.Num() == 0)
+		return false;
+
+	TArray<float> Sorted = FrameMs;
+	Sorted.Sort();
+	auto Percentile = [&Sorted](float P)
+	{
+		return Sorted[FMath::Clamp(FMath::CeilToInt(P * Sorted.Num()) - 1, 0, Sorted.Num() - 1)];
+	};
+
+	double SumMs = 0.0;
+	for (float Ms : Sorted)
+	{
+		SumMs += Ms;
+	}
+
+	const int32 NumFrames = FrameMs.Num();
+	const float SimSeconds = NumFrames / 60.0f;
+
+	//columns never move, new ones go at the end so old files stay comparable
+	//LLM KB per tag at the end and growth over the measured frames, -1 without -llm
+	FString MemoryHeader;
+	FString MemoryColumns;
+	for (int32 i = 0; i < int32(ETopDownShooterLLMTag::Count); i++)
+	{
+		const ETopDownShooterLLMTag Tag = ETopDownShooterLLMTag(i);
+		const int64 EndBytes = FTopDownShooterMemory::GetTrackedBytes(Tag);
+		const int64 StartBytes = LLMBytesAtStart.IsValidIndex(i) ? LLMBytesAtStart[i] : -1;
+		MemoryHeader += FString::Printf(TEXT(",%sKB,%sGrowthKB"), FTopDownShooterMemory::GetTagName(Tag), FTopDownShooterMemory::GetTagName(Tag));
+		if (EndBytes >= 0 && StartBytes >= 0)
+			MemoryColumns += FString::Printf(TEXT(",%.1f,%.1f"), EndBytes / 1024.0, (EndBytes - StartBytes) / 1024.0);
+		else
+			MemoryColumns += TEXT(",-1,-1");
+	}
+
+	const FString Header = TEXT("Date,Build,Map,Bots,Frames,FrameMsAvg,FrameMsP50,FrameMsP90,FrameMsP95,FrameMsP99,FrameMsMax,ShotsPerSecond,ProjectilesAliveAvg,ProjectilesAliveMax,DebrisAvg,DebrisMax,TracesPerFrameAvg,TracesPerFrameMax,GCCount,GCMsTotal,GCMsMax") + MemoryHeader;
+
+	//a file written with other columns is left alone, rows go to a file named after this column set
+	FString myCsvPath = CsvPath;
+	FString Existing;
+	if (FFileHelper::LoadFileToString(Existing, *myCsvPath))
+	{
+		FString ExistingHeader = Existing;
+		Existing.Split(TEXT("\n"), &ExistingHeader, nullptr);
+		if (ExistingHeader.TrimEnd() != Header)
+			myCsvPath = FPaths::GetPath(CsvPath) / FString::Printf(TEXT("%s_%08X.%s"), *FPaths::GetBaseFilename(CsvPath), FCrc::StrCrc32(*Header), *FPaths::GetExtension(CsvPath));
+	}
+
+	FString Csv;
+	if (!FPlatformFileManager::Get().GetPlatformFile().FileExists(*myCsvPath))
+		Csv += Header + TEXT("\n");
+
+	Csv += FString::Printf(TEXT("%s,%s,%s,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%.1f,%d,%.1f,%d,%.2f,%d,%d,%.2f,%.2f%s\n"),
+		*FDateTime::UtcNow().ToIso8601(),
+		FApp::GetBuildVersion(),
+		*GetWorld()->GetMapName(),
+		Bots.Num(),
+		NumFrames,
+		SumMs / NumFrames,
+		Percentile(0.5f),
+		Percentile(0.9f),
+		Percentile(0.95f),
+		Percentile(0.99f),
+		Sorted.Last(),
+		(FTopDownShooterCounters::ShotsFired - ShotsAtStart) / SimSeconds,
+		double(ProjectilesAliveSum) / NumFrames,
+		ProjectilesAliveMax,
+		double(DebrisSum) / NumFrames,
+		DebrisMax,
+		double(TracesTotal) / NumFrames,
+		MaxTracesPerFrame,
+		GCCount,
+		GCTotalMs,
+		GCMaxMs,
+		*MemoryColumns);
+
+	if (myCsvPath != CsvPath)
+		UE_LOG(LogTemp, Warning, TEXT("ATopDownShooterBenchmarkGameMode::WriteCsv - %s has other columns, writing to %s"), *CsvPath, *myCsvPath);
+	return FFileHelper::SaveStringToFile(Csv, *myCsvPath, FFileHelper::EEncodingOptions::ForceAnsi, &IFileManager::Get(), FILEWRITE_Append);
+}
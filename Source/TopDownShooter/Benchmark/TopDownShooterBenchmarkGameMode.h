@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Game/TopDownShooterGameMode.h"
+#include "TopDownShooterBenchmarkGameMode.generated.h"
+
+class ATopDownShooterCharacter;
+
+/**
+ * Headless combat stress test. Spawns armed bots (one per DT_WeaponInfo row, repeated up to Bots), lets them
+ * fire, reload and switch through the real weapon and inventory code at a fixed timestep, and appends one row
+ * of frame time percentiles and gameplay counters to a CSV when done.
+ * UE4Editor TopDownShooter.uproject TopDownExampleMap?game=/Script/TopDownShooter.TopDownShooterBenchmarkGameMode?Bots=64?Seconds=60 -game -nullrhi
+ * Options: Bots, Seconds, Warmup, SwitchInterval, Radius, Seed, Csv, NoExit
+ */
+UCLASS()
+class ATopDownShooterBenchmarkGameMode : public ATopDownShooterGameMode
+{
+	GENERATED_BODY()
+
+public:
+	ATopDownShooterBenchmarkGameMode();
+
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void Tick(float DeltaSeconds) override;
+
+protected:
+	void SpawnBots();
+	void UpdateBots();
+	void SwitchBotWeapon(int32 BotIndex);
+	void SeedBotWeapon(int32 BotIndex);
+	void SampleFrame();
+	void FinishBenchmark();
+	bool WriteCsv() const;
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	UPROPERTY()
+	TArray<ATopDownShooterCharacter*> Bots;
+	TArray<int8> BotSwitchDirection;
+	TArray<int32> BotSwitchCount;
+
+	TSubclassOf<ATopDownShooterCharacter> BotClass;
+	FVector ArenaCenter = FVector::ZeroVector;
+
+	//options
+	int32 NumBots = 32;
+	float BenchSeconds = 60.0f;
+	float WarmupSeconds = 5.0f;
+	float SwitchInterval = 4.0f;
+	float ArenaRadius = 1200.0f;
+	int32 Seed = 1;
+	FString CsvPath;
+	bool bExitWhenDone = true;
+
+	//measurement, frames are counted at the fixed step so every build simulates the same game
+	int32 FramesSimulated = 0;
+	int32 WarmupFrames = 0;
+	int32 MeasuredFrames = 0;
+	double LastFrameSeconds = 0.0;
+	bool bFinished = false;
+
+	TArray<float> FrameMs;
+	int32 ShotsAtStart = 0;
+	int32 TracesAtLastFrame = 0;
+	int64 TracesTotal = 0;
+	int32 MaxTracesPerFrame = 0;
+	int64 ProjectilesAliveSum = 0;
+	int32 ProjectilesAliveMax = 0;
+	int64 DebrisSum = 0;
+	int32 DebrisMax = 0;
+	//LLM bytes per ETopDownShooterLLMTag when measuring starts, -1 without -llm
+	TArray<int64> LLMBytesAtStart;
+
+	double GCStartSeconds = 0.0;
+	double GCTotalMs = 0.0;
+	double GCMaxMs = 0.0;
+	int32 GCCount = 0;
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
@@ -0,0 +1,397 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CoreMinimal.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/PlatformTLS.h"
+#include "Math/RandomStream.h"
+#include "Misc/OutputDevice.h"
+#include "Misc/AutomationTest.h"
+#include "FuncLibrary/Types.h"
+#include "FuncLibrary/WeaponLogic.h"
+#include "FuncLibrary/SpreadGenerator.h"
+#include "FuncLibrary/InventoryLogic.h"
+#include "Game/TopDownShooterGameInstance.h"
+
+#if !UE_BUILD_SHIPPING
+
+namespace MicroBench
+{
+	//Forwards everything to the real allocator, counts allocations made by the bench thread while enabled
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner) {}
+
+		void Begin() { Count = 0; ThreadId = FPlatformTLS::GetCurrentThreadId(); bEnabled = true; }
+		uint64 End() { bEnabled = false; return Count; }
+
+		FMalloc* GetInner() const { return Inner; }
+
+		//every virtual goes to Inner, the base versions would bypass it
+		virtual void* Malloc(SIZE_T Size, uint32 Alignment) override { Tick(); return Inner->Malloc(Size, Alignment); }
+		virtual void* TryMalloc(SIZE_T Size, uint32 Alignment) override { Tick(); return Inner->TryMalloc(Size, Alignment); }
+		virtual void* Realloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override { Tick(); return Inner->Realloc(Ptr, NewSize, Alignment); }
+		virtual void* TryRealloc(void* Ptr, SIZE_T NewSize, uint32 Alignment) override { Tick(); return Inner->TryRealloc(Ptr, NewSize, Alignment); }
+		virtual void Free(void* Ptr) override { Inner->Free(Ptr); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual const TCHAR* GetDescriptiveName() override { return Inner->GetDescriptiveName(); }
+		virtual bool Exec(UWorld* InWorld, const TCHAR* Cmd, FOutputDevice& Ar) override { return Inner->Exec(InWorld, Cmd, Ar); }
+
+	private:
+		void Tick()
+		{
+			if (bEnabled && FPlatformTLS::GetCurrentThreadId() == ThreadId)
+				Count++;
+		}
+
+		FMalloc* Inner;
+		volatile bool bEnabled = false;
+		uint32 ThreadId = 0;
+		uint64 Count = 0;
+	};
+
+	//Created once and never deleted, another thread may still be inside it after it is uninstalled
+	FCountingMalloc* CountingMallocInstance = nullptr;
+	//in GMalloc only while TPS.MicroBench runs
+	FCountingMalloc* InstalledCountingMalloc = nullptr;
+
+	struct FScopedCountingMalloc
+	{
+		FScopedCountingMalloc()
+		{
+			if (!GMalloc)
+				return;
+			if (!CountingMallocInstance)
+				CountingMallocInstance = new FCountingMalloc(GMalloc);
+			//someone else wrapped the allocator since, counting would skip their proxy
+			if (CountingMallocInstance->GetInner() != GMalloc)
+				return;
+
+			GMalloc = CountingMallocInstance;
+			InstalledCountingMalloc = CountingMallocInstance;
+		}
+
+		~FScopedCountingMalloc()
+		{
+			if (!InstalledCountingMalloc)
+				return;
+			//allocations made meanwhile are freed by the inner allocator directly, the proxy adds nothing to them
+			if (GMalloc == InstalledCountingMalloc)
+				GMalloc = InstalledCountingMalloc->GetInner();
+			InstalledCountingMalloc = nullptr;
+		}
+	};
+
+	//keeps the optimizer from dropping the measured work
+	volatile float SinkFloat = 0.0f;
+	volatile int32 SinkInt = 0;
+
+	struct FCaseResult
+	{
+		double MeanNs = 0.0;
+		double MedianNs = 0.0;
+		double MinNs = 0.0;
+		double StdDevNs = 0.0;
+		double AllocsPerOp = 0.0;
+	};
+
+	//Body runs Iterations times per repetition, each repetition is one timing sample
+	FCaseResult Run(int32 Iterations, int32 Repetitions, TFunctionRef<void(int32)> Body)
+	{
+		FCountingMalloc* CountingMalloc = InstalledCountingMalloc;
+
+		//warm caches and lazily built tables
+		Body(FMath::Max(1, Iterations / 10));
+
+		TArray<double> Samples;
+		Samples.Reserve(Repetitions);
+		uint64 Allocs = 0;
+		for (int32 i = 0; i < Repetitions; i++)
+		{
+			if (CountingMalloc)
+				CountingMalloc->Begin();
+			const double StartTime = FPlatformTime::Seconds();
+			Body(Iterations);
+			const double Elapsed = FPlatformTime::Seconds() - StartTime;
+			if (CountingMalloc)
+				Allocs += CountingMalloc->End();
+			Samples.Add(Elapsed * 1.0e9 / Iterations);
+		}
+
+		FCaseResult Result;
+		Samples.Sort();
+		double Sum = 0.0;
+		for (double Sample : Samples)
+			Sum += Sample;
+		Result.MeanNs = Sum / Samples.Num();
+		Result.MedianNs = Samples[Samples.Num() / 2];
+		Result.MinNs = Samples[0];
+		double Variance = 0.0;
+		for (double Sample : Samples)
+			Variance += FMath::Square(Sample - Result.MeanNs);
+		Result.StdDevNs = FMath::Sqrt(Variance / Samples.Num());
+		Result.AllocsPerOp = double(Allocs) / (double(Iterations) * Repetitions);
+		return Result;
+	}
+
+	void Report(FOutputDevice& Ar, const TCHAR* Name, const FCaseResult& Result)
+	{
+		const double CV = Result.MeanNs > 0.0 ? Result.StdDevNs / Result.MeanNs * 100.0 : 0.0;
+		Ar.Logf(TEXT("%-32s mean %9.1f ns  median %9.1f ns  min %9.1f ns  stddev %7.1f ns (%4.1f%%)  allocs/op %.3f"),
+			Name, Result.MeanNs, Result.MedianNs, Result.MinNs, Result.StdDevNs, CV, Result.AllocsPerOp);
+	}
+
+	void BuildInventory(TArray<FWeaponSlot>& WeaponSlots, TArray<FAmmoSlot>& AmmoSlots, TMap<FName, EWeaponType>& WeaponTypes)
+	{
+		static const EWeaponType Types[] = { EWeaponType::RifleType, EWeaponType::AK47Type, EWeaponType::ShotGunType, EWeaponType::GrenadeLauncherType };
+		for (int32 i = 0; i < 8; i++)
+		{
+			FWeaponSlot Slot;
+			Slot.NameItem = FName(*FString::Printf(TEXT("BenchWeapon_%d"), i));
+			//every other slot is empty so the switch has to walk
+			Slot.AdditionalInfo.Round = (i % 2) ? 0 : 10;
+			WeaponSlots.Add(Slot);
+			WeaponTypes.Add(Slot.NameItem, Types[i % ARRAY_COUNT(Types)]);
+		}
+		for (EWeaponType Type : Types)
+		{
+			FAmmoSlot AmmoSlot;
+			AmmoSlot.WeaponType = Type;
+			AmmoSlot.Cout = (Type == EWeaponType::ShotGunType) ? 0 : 30;
+			AmmoSlots.Add(AmmoSlot);
+		}
+	}
+
+	void RunAll(const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		const FString Filter = Args.Num() > 0 ? Args[0] : FString();
+		const int32 Iterations = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 100000;
+		const int32 Repetitions = 15;
+
+		auto ShouldRun = [&Filter](const TCHAR* Name) { return Filter.IsEmpty() || Filter == TEXT("*") || FString(Name).Contains(Filter); };
+		FScopedCountingMalloc ScopedCountingMalloc;
+
+		Ar.Logf(TEXT("TPS.MicroBench - %d iterations x %d repetitions%s"), Iterations, Repetitions, InstalledCountingMalloc ? TEXT("") : TEXT(" (allocation counting unavailable)"));
+
+		if (ShouldRun(TEXT("EvaluateDispersion")))
+		{
+			Report(Ar, TEXT("EvaluateDispersion"), Run(Iterations, Repetitions, [](int32 Num)
+			{
+				float Current = 1.0f;
+				for (int32 i = 0; i < Num; i++)
+					Current = WeaponLogic::EvaluateDispersion(Current, (i & 15) * 0.01f, 0.5f, 4.0f, 6.0f, false, (i & 7) == 0, (i & 1) == 0);
+				SinkFloat = Current;
+			}));
+		}
+
+		if (ShouldRun(TEXT("ApplyDispersionToShoot")))
+		{
+			Report(Ar, TEXT("ApplyDispersionToShoot"), Run(Iterations, Repetitions, [](int32 Num)
+			{
+				FRandomStream Stream(1);
+				FVector Sum = FVector::ZeroVector;
+				for (int32 i = 0; i < Num; i++)
+					Sum += WeaponLogic::ApplyDispersionToShoot(FVector::ForwardVector, 2.0f, Stream);
+				SinkFloat = Sum.X;
+			}));
+		}
+
+		if (ShouldRun(TEXT("SpreadGenerator")))
+		{
+			//per shot of 8 pellets
+			FShotSpread Spread;
+			Report(Ar, TEXT("SpreadGenerator x8"), Run(Iterations, Repetitions, [&Spread](int32 Num)
+			{
+				FRandomStream Stream(1);
+				float Sum = 0.0f;
+				for (int32 i = 0; i < Num; i++)
+				{
+					SpreadGenerator::Generate(FVector::ForwardVector, 1.0f, 2.0f, 8, Stream, nullptr, Spread);
+					Sum += Spread.DirX[i & 7];
+				}
+				SinkFloat = Sum;
+			}));
+		}
+
+		if (ShouldRun(TEXT("ComputeReload")))
+		{
+			Report(Ar, TEXT("ComputeReload"), Run(Iterations, Repetitions, [](int32 Num)
+			{
+				int32 Total = 0;
+				for (int32 i = 0; i < Num; i++)
+				{
+					int32 Round = 0;
+					int32 Taken = 0;
+					WeaponLogic::ComputeReload(30, i % 30, i % 45, Round, Taken);
+					Total += Round + Taken;
+				}
+				SinkInt = Total;
+			}));
+		}
+
+		TArray<FWeaponSlot> WeaponSlots;
+		TArray<FAmmoSlot> AmmoSlots;
+		TMap<FName, EWeaponType> WeaponTypes;
+		BuildInventory(WeaponSlots, AmmoSlots, WeaponTypes);
+		auto GetWeaponType = [&WeaponTypes](FName WeaponName, EWeaponType& OutType)
+		{
+			if (const EWeaponType* Type = WeaponTypes.Find(WeaponName))
+			{
+				OutType = *Type;
+				return true;
+			}
+			return false;
+		};
+
+		if (ShouldRun(TEXT("FindSwitchIndex")))
+		{
+			Report(Ar, TEXT("FindSwitchIndex"), Run(Iterations, Repetitions, [&](int32 Num)
+			{
+				int32 Total = 0;
+				const int32 NumSlots = WeaponSlots.Num();
+				for (int32 i = 0; i < Num; i++)
+				{
+					const int32 OldIndex = i % NumSlots;
+					const bool bForward = (i & 1) == 0;
+					Total += InventoryLogic::FindSwitchIndex(WeaponSlots, AmmoSlots, bForward ? OldIndex + 1 : OldIndex - 1, OldIndex, bForward, GetWeaponType);
+				}
+				SinkInt = Total;
+			}));
+		}
+
+		if (ShouldRun(TEXT("FindAmmoForWeapon")))
+		{
+			Report(Ar, TEXT("FindAmmoForWeapon"), Run(Iterations, Repetitions, [&](int32 Num)
+			{
+				int32 Total = 0;
+				for (int32 i = 0; i < Num; i++)
+				{
+					int32 Aviable = 0;
+					if (InventoryLogic::FindAmmoForWeapon(AmmoSlots, EWeaponType(i & 3), Aviable))
+						Total += Aviable;
+				}
+				SinkInt = Total;
+			}));
+		}
+
+		//data table lookups need the game instance tables
+		UTopDownShooterGameInstance* myGI = World ? Cast<UTopDownShooterGameInstance>(World->GetGameInstance()) : nullptr;
+		if (!myGI || !myGI->WeaponInfoTable)
+		{
+			if (ShouldRun(TEXT("GetWeaponInfoByName")) || ShouldRun(TEXT("GetDropItemInfoByWeaponName")))
+				Ar.Logf(TEXT("TPS.MicroBench - no game instance tables, skipping data table cases"));
+			return;
+		}
+
+		const TArray<FName> RowNames = myGI->WeaponInfoTable->GetRowNames();
+		if (RowNames.Num() == 0)
+			return;
+
+		if (ShouldRun(TEXT("GetWeaponInfoByName")))
+		{
+			Report(Ar, TEXT("GetWeaponInfoByName"), Run(Iterations, Repetitions, [&](int32 Num)
+			{
+				int32 Total = 0;
+				FWeaponInfos Info;
+				for (int32 i = 0; i < Num; i++)
+				{
+					if (myGI->GetWeaponInfoByName(RowNames[i % RowNames.Num()], Info))
+						Total += Info.MaxRound;
+				}
+				SinkInt = Total;
+			}));
+		}
+
+		if (ShouldRun(TEXT("GetDropItemInfoByWeaponName")) && myGI->DropItemInfoTable)
+		{
+			Report(Ar, TEXT("GetDropItemInfoByWeaponName"), Run(Iterations, Repetitions, [&](int32 Num)
+			{
+				int32 Total = 0;
+				FDropItem Info;
+				for (int32 i = 0; i < Num; i++)
+				{
+					if (myGI->GetDropItemInfoByWeaponName(RowNames[i % RowNames.Num()], Info))
+						Total++;
+				}
+				SinkInt = Total;
+			}));
+		}
+	}
+}
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace MicroBench
+{
+	//one automation test per case, the name is also the filter passed to RunAll
+	static const TCHAR* CaseNames[] = { TEXT("EvaluateDispersion"), TEXT("ApplyDispersionToShoot"), TEXT("SpreadGenerator"), TEXT("ComputeReload"),
+		TEXT("FindSwitchIndex"), TEXT("FindAmmoForWeapon"), TEXT("GetWeaponInfoByName"), TEXT("GetDropItemInfoByWeaponName") };
+
+	//Report lines go to the automation log
+	class FAutomationOutput : public FOutputDevice
+	{
+	public:
+		explicit FAutomationOutput(FAutomationTestBase& InTest) : Test(InTest) {}
+
+		virtual void Serialize(const TCHAR* V, ELogVerbosity::Type Verbosity, const FName& Category) override { Test.AddInfo(V); }
+
+	private:
+		FAutomationTestBase& Test;
+	};
+
+	//the data table cases need a running game instance, the others run anywhere
+	UWorld* FindGameWorld()
+	{
+		if (!GEngine)
+			return nullptr;
+		for (const FWorldContext& Context : GEngine->GetWorldContexts())
+		{
+			if ((Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE) && Context.World())
+				return Context.World();
+		}
+		return nullptr;
+	}
+}
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FTopDownShooterMicroBenchTest, "TopDownShooter.MicroBench", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::PerfFilter)
+
+void FTopDownShooterMicroBenchTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const TCHAR* Name : MicroBench::CaseNames)
+	{
+		OutBeautifiedNames.Add(Name);
+		OutTestCommands.Add(Name);
+	}
+}
+
+bool FTopDownShooterMicroBenchTest::RunTest(const FString& Parameters)
+{
+	TArray<FString> Args;
+	Args.Add(Parameters);
+	MicroBench::FAutomationOutput Output(*this);
+	MicroBench::RunAll(Args, MicroBench::FindGameWorld(), Output);
+	return true;
+}
+
+#endif
+
+//same cases from the console, with a filter and iteration count
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMicroBench(TEXT("TPS.MicroBench"),
+	TEXT("TPS.MicroBench [Filter] [Iterations] - time the weapon and inventory logic, ns/op and allocations/op"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateStatic(&MicroBench::RunAll));
+
+#endif
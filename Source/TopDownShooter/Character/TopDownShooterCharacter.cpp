@@ -18,6 +18,28 @@
 #include "Components/SkeletalMeshComponent.h" 
 #include "Game/TopDownShooterGameInstance.h"
 #include "Character/TopDownShooterInventorComponent.h"
+#include "Character/TopDownShooterHealthComponent.h"
+#include "Game/TopDownShooterLagCompensation.h"
+#include "Character/TopDownShooterCharacterTickManager.h"
+#include "FuncLibrary/CosmeticLibrary.h"
+#include "Game/TopDownShooterInputReplay.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterTrace.h"
+#include "TopDownShooterMemory.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character MovementTick"), STAT_TPS_MovementTick, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Character InitWeapon"), STAT_TPS_InitWeapon, STATGROUP_TopDownShooter);
+
+//input replay that records or drives this character, null for everyone else
+static UTopDownShooterInputReplay* GetActiveInputReplay(ATopDownShooterCharacter* Character, bool bDrivenOnly = true)
+{
+	UGameInstance* myGI = Character->GetGameInstance();
+	UTopDownShooterInputReplay* myInputReplay = myGI ? myGI->GetSubsystem<UTopDownShooterInputReplay>() : nullptr;
+	if (myInputReplay && (myInputReplay->IsRecording() || myInputReplay->IsReplaying()) && (!bDrivenOnly || myInputReplay->IsDrivenCharacter(Character)))
+		return myInputReplay;
+	return nullptr;
+}
 
 ATopDownShooterCharacter::ATopDownShooterCharacter()
 {
@@ -54,6 +76,10 @@ ATopDownShooterCharacter::ATopDownShooterCharacter()
 	{
 		InventoryComponent->OnSwitchWeapon.AddDynamic(this, &ATopDownShooterCharacter::InitWeapon);
 	}
+
+	HealthComponent = CreateDefaultSubobject<UTopDownShooterHealthComponent>(TEXT("HealthComponent"));
+	//the character Blueprint still has its own health component bound to the same damage, on once it is migrated
+	HealthComponent->bTakeOwnerDamage = false;
 	
 	// Activate ticking in order to update the cursor every frame.
 	PrimaryActorTick.bCanEverTick = true;
@@ -67,8 +93,37 @@ void ATopDownShooterCharacter::BeginPlay()
 
 	if (CursorMaterial)
 	{
-		CurrentCursor = UGameplayStatics::SpawnDecalAtLocation(GetWorld(), CursorMaterial, CursorSize, FVector(0));
+		CurrentCursor = UCosmeticLibrary::SpawnDecalAtLocation(this, CursorMaterial, CursorSize, FVector(0), FRotator(-90.0f, 0.0f, 0.0f));
+	}
+
+	if (UTopDownShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UTopDownShooterLagCompensation>())
+	{
+		LagCompensation->RegisterCharacter(this);
+	}
+
+	if (UTopDownShooterCharacterTickManager* myTickManager = GetWorld()->GetSubsystem<UTopDownShooterCharacterTickManager>())
+	{
+		bMovementTickBatched = myTickManager->RegisterCharacter(this);
+		if (bMovementTickBatched)
+			myTickManager->AddWeaponPrerequisite(CurrentWeapon);
+	}
+}
+
+void ATopDownShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UTopDownShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UTopDownShooterLagCompensation>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	if (bMovementTickBatched)
+	{
+		if (UTopDownShooterCharacterTickManager* myTickManager = GetWorld()->GetSubsystem<UTopDownShooterCharacterTickManager>())
+			myTickManager->UnregisterCharacter(this);
+		bMovementTickBatched = false;
 	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 void ATopDownShooterCharacter::Tick(float DeltaSeconds)
@@ -82,6 +137,7 @@ void ATopDownShooterCharacter::Tick(float DeltaSeconds)
 		{
 			FHitResult TraceHitResult;
 			myPC->GetHitResultUnderCursor(ECC_Visibility, true, TraceHitResult);
+			TPS_COUNT_TRACES(CursorTraces, 1);
 			FVector CursorFV = TraceHitResult.ImpactNormal;
 			FRotator CursorR = CursorFV.Rotation();
 
@@ -90,7 +146,14 @@ void ATopDownShooterCharacter::Tick(float DeltaSeconds)
 		}
 	}
 
-	MovementTick(DeltaSeconds);
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+	{
+		myInputReplay->ApplyFrame(this);
+		myInputReplay->RecordAxis(AxisX, AxisY);
+	}
+
+	if (!bMovementTickBatched)
+		MovementTick(DeltaSeconds);
 }
 
 void ATopDownShooterCharacter::SetupPlayerInputComponent(UInputComponent* NewInputComponent)
@@ -102,10 +165,10 @@ void ATopDownShooterCharacter::SetupPlayerInputComponent(UInputComponent* NewInp
 
 	NewInputComponent->BindAction(TEXT("FireEvent"), EInputEvent::IE_Pressed, this, &ATopDownShooterCharacter::InputAttackPressed);
 	NewInputComponent->BindAction(TEXT("FireEvent"), EInputEvent::IE_Released, this, &ATopDownShooterCharacter::InputAttackReleased);
-	NewInputComponent->BindAction(TEXT("ReloadEvent"), EInputEvent::IE_Released, this, &ATopDownShooterCharacter::TryReloadWeapon);
+	NewInputComponent->BindAction(TEXT("ReloadEvent"), EInputEvent::IE_Released, this, &ATopDownShooterCharacter::InputReloadReleased);
 
-	NewInputComponent->BindAction(TEXT("SwitchNextWeapon"), EInputEvent::IE_Pressed, this, &ATopDownShooterCharacter::TrySwicthNextWeapon);
-	NewInputComponent->BindAction(TEXT("SwitchPreviosWeapon"), EInputEvent::IE_Pressed, this, &ATopDownShooterCharacter::TrySwitchPreviosWeapon);
+	NewInputComponent->BindAction(TEXT("SwitchNextWeapon"), EInputEvent::IE_Pressed, this, &ATopDownShooterCharacter::InputSwitchNextPressed);
+	NewInputComponent->BindAction(TEXT("SwitchPreviosWeapon"), EInputEvent::IE_Pressed, this, &ATopDownShooterCharacter::InputSwitchPreviosPressed);
 
 }
 
@@ -121,14 +184,39 @@ void ATopDownShooterCharacter::InputAxisY(float value)
 
 void ATopDownShooterCharacter::InputAttackPressed()
 {
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+		myInputReplay->RecordAction(EInputReplayAction::FirePressed);
 	AttackCharEvent(true);
 }
 
 void ATopDownShooterCharacter::InputAttackReleased()
 {
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+		myInputReplay->RecordAction(EInputReplayAction::FireReleased);
 	AttackCharEvent(false);
 }
 
+void ATopDownShooterCharacter::InputReloadReleased()
+{
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+		myInputReplay->RecordAction(EInputReplayAction::Reload);
+	TryReloadWeapon();
+}
+
+void ATopDownShooterCharacter::InputSwitchNextPressed()
+{
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+		myInputReplay->RecordAction(EInputReplayAction::SwitchNext);
+	TrySwicthNextWeapon();
+}
+
+void ATopDownShooterCharacter::InputSwitchPreviosPressed()
+{
+	if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this))
+		myInputReplay->RecordAction(EInputReplayAction::SwitchPrevios);
+	TrySwitchPreviosWeapon();
+}
+
 void ATopDownShooterCharacter::AttackCharEvent(bool bIsFiring)
 {
 	AWeaponDefault* myWeapon = nullptr;
@@ -144,6 +232,9 @@ void ATopDownShooterCharacter::AttackCharEvent(bool bIsFiring)
 
 void ATopDownShooterCharacter::MovementTick(float DeltaTime)
 {
+	SCOPE_CYCLE_COUNTER(STAT_TPS_MovementTick);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, MovementTick);
+
 	AddMovementInput(FVector(1.0f, 0.0f, 0.0f), AxisX);
 	AddMovementInput(FVector(0.0f, 1.0f, 0.0f), AxisY);
 
@@ -155,14 +246,10 @@ void ATopDownShooterCharacter::MovementTick(float DeltaTime)
 	}
 	else
 	{
-		APlayerController* myController = UGameplayStatics::GetPlayerController(GetWorld(), 0);
-		if (myController)
+		FVector myAimLocation;
+		if (GetCursorAimLocation(myAimLocation))
 		{
-			FHitResult ResultHit;
-			//myController->GetHitResultUnderCursorByChannel(ETraceTypeQuery::TraceTypeQuery6, false, ResultHit);// bug was here Config\DefaultEngine.Ini
-			myController->GetHitResultUnderCursor(ECC_GameTraceChannel1, true, ResultHit);
-
-			float FindRotaterResultYaw = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), ResultHit.Location).Yaw;
+			float FindRotaterResultYaw = UKismetMathLibrary::FindLookAtRotation(GetActorLocation(), myAimLocation).Yaw;
 			SetActorRotation(FQuat(FRotator(0.0f, FindRotaterResultYaw, 0.0f)));
 
 			if (CurrentWeapon)
@@ -172,19 +259,19 @@ void ATopDownShooterCharacter::MovementTick(float DeltaTime)
 				{
 				case EMovementState::Aim_State:
 					Displacement = FVector(0.0f, 0.0f, 160.0f);
-					CurrentWeapon->ShouldReduceDispersion = true;
+					CurrentWeapon->SetShouldReduceDispersion(true);
 					break;
 				case EMovementState::AimWalk_State:
-					CurrentWeapon->ShouldReduceDispersion = true;
+					CurrentWeapon->SetShouldReduceDispersion(true);
 					Displacement = FVector(0.0f, 0.0f, 160.0f);
 					break;
 				case EMovementState::Walk_State:
 					Displacement = FVector(0.0f, 0.0f, 120.0f);
-					CurrentWeapon->ShouldReduceDispersion = false;
+					CurrentWeapon->SetShouldReduceDispersion(false);
 					break;
 				case EMovementState::Run_State:
 					Displacement = FVector(0.0f, 0.0f, 120.0f);
-					CurrentWeapon->ShouldReduceDispersion = false;
+					CurrentWeapon->SetShouldReduceDispersion(false);
 					break;
 				case EMovementState::SprintRun_State:
 					break;
@@ -192,13 +279,40 @@ void ATopDownShooterCharacter::MovementTick(float DeltaTime)
 					break;
 				}
 
-				CurrentWeapon->ShootEndLocation = ResultHit.Location + Displacement;
+				CurrentWeapon->ShootEndLocation = myAimLocation + Displacement;
 				//aim cursor like 3d Widget?
 			}
 		}
 	}
 }
 
+bool ATopDownShooterCharacter::GetCursorAimLocation(FVector& OutLocation)
+{
+	if (bHasAimOverride)
+	{
+		OutLocation = AimOverrideLocation;
+		return true;
+	}
+
+	UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this);
+	if (myInputReplay && myInputReplay->IsReplaying())
+		return myInputReplay->GetReplayCursorHit(OutLocation);
+
+	APlayerController* myController = UGameplayStatics::GetPlayerController(GetWorld(), 0);
+	if (!myController)
+		return false;
+
+	FHitResult ResultHit;
+	//myController->GetHitResultUnderCursorByChannel(ETraceTypeQuery::TraceTypeQuery6, false, ResultHit);// bug was here Config\DefaultEngine.Ini
+	myController->GetHitResultUnderCursor(ECC_GameTraceChannel1, true, ResultHit);
+	TPS_COUNT_TRACES(CursorTraces, 1);
+	OutLocation = ResultHit.Location;
+
+	if (myInputReplay)
+		myInputReplay->RecordCursorHit(OutLocation);
+	return true;
+}
+
 void ATopDownShooterCharacter::CharacterUpdate()
 {
 	float ResSpeed = MovementSpeedInfo.RunSpeedNormal;
@@ -224,11 +338,39 @@ void ATopDownShooterCharacter::CharacterUpdate()
 		break;
 	}
 
-	GetCharacterMovement()->MaxWalkSpeed = ResSpeed;
+	GetCharacterMovement()->MaxWalkSpeed = ResSpeed * StatusModifiers.MoveSpeed;
+}
+
+void ATopDownShooterCharacter::SetStatusModifiers(const FStatusEffectModifiers& Modifiers)
+{
+	StatusModifiers = Modifiers;
+	CharacterUpdate();
+
+	AWeaponDefault* myWeapon = GetCurrentWeapon();
+	if (myWeapon)
+	{
+		myWeapon->StatusModifiers = Modifiers;
+		myWeapon->UpdateStateWeapon(MovementState);
+	}
+}
+
+void ATopDownShooterCharacter::OnRep_StatusModifiers()
+{
+	SetStatusModifiers(StatusModifiers);
+}
+
+void ATopDownShooterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(ATopDownShooterCharacter, StatusModifiers, COND_OwnerOnly);
 }
 
 void ATopDownShooterCharacter::ChangeMovementState()
 {
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		ServerChangeMovementState(WalkEnabled, SprintRunEnabled, AimEnabled);
+
 	if (!WalkEnabled && !SprintRunEnabled && !AimEnabled)
 	{
 		MovementState = EMovementState::Run_State;
@@ -267,6 +409,9 @@ void ATopDownShooterCharacter::ChangeMovementState()
 	if (myWeapon)
 	{
 		myWeapon->UpdateStateWeapon(MovementState);
+		//remote players have no cursor here, MovementTick never sets it for them
+		if (!IsLocallyControlled())
+			myWeapon->SetShouldReduceDispersion(MovementState == EMovementState::Aim_State || MovementState == EMovementState::AimWalk_State);
 	}
 }
 
@@ -277,6 +422,9 @@ AWeaponDefault * ATopDownShooterCharacter::GetCurrentWeapon()
 
 void ATopDownShooterCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponInfos WeaponAdditionalInfo, int32 NewCurrentIndexWeapon)
 {
+	SCOPE_CYCLE_COUNTER(STAT_TPS_InitWeapon);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, InitWeapon);
+
 	if (CurrentWeapon)
 	{
 		CurrentWeapon->Destroy();
@@ -293,28 +441,46 @@ void ATopDownShooterCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponI
 		{
 			if (myWeaponInfos.WeaponClass)
 			{
+				TPS_LLM_SCOPE(Weapons);
 				FVector SpawnLocation = FVector(0);
 				FRotator SpawnRotation = FRotator(0);
 
-				FActorSpawnParameters SpawnParams;
-				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-				SpawnParams.Owner = GetOwner();
-				SpawnParams.Instigator = GetInstigator();
+				const FTransform SpawnTransform(SpawnRotation, SpawnLocation);
 
-				AWeaponDefault* myWeapon = Cast<AWeaponDefault>(GetWorld()->SpawnActor(myWeaponInfos.WeaponClass, &SpawnLocation, &SpawnRotation, SpawnParams));
+				//deferred, WeaponInit in BeginPlay already sees the WeaponSetting
+				AWeaponDefault* myWeapon = GetWorld()->SpawnActorDeferred<AWeaponDefault>(myWeaponInfos.WeaponClass, SpawnTransform, GetOwner(), GetInstigator(), ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+				TPS_COUNT_SPAWNS(WeaponSpawns, 1);
 				if (myWeapon)
 				{
+					{
+						TPS_LLM_SCOPE(WeaponData);
+						myWeapon->WeaponSetting = myWeaponInfos;
+					}
+					myWeapon->FinishSpawning(SpawnTransform);
+
 					FAttachmentTransformRules Rule(EAttachmentRule::SnapToTarget, false);
 					myWeapon->AttachToComponent(GetMesh(), Rule, FName("WeaponSocketRightHand"));
 					CurrentWeapon = myWeapon;
+					if (bMovementTickBatched)
+					{
+						if (UTopDownShooterCharacterTickManager* myTickManager = GetWorld()->GetSubsystem<UTopDownShooterCharacterTickManager>())
+							myTickManager->AddWeaponPrerequisite(myWeapon);
+					}
 
-					myWeapon->WeaponSetting = myWeaponInfos;
 					//myWeapon->WeaponInfos.Round = myWeaponInfos.MaxRound;
 					//Remove !!! Debug
 					myWeapon->ReloadTime = myWeaponInfos.ReloadTime;
+					myWeapon->StatusModifiers = StatusModifiers;
 					myWeapon->UpdateStateWeapon(MovementState);
+					if (!IsLocallyControlled())
+						myWeapon->SetShouldReduceDispersion(MovementState == EMovementState::Aim_State || MovementState == EMovementState::AimWalk_State);
 
 					myWeapon->WeaponAdditionalInfos = WeaponAdditionalInfo;
+					myWeapon->WeaponSlotIndex = NewCurrentIndexWeapon;
+					TPS_TRACE(WeaponSwitched(this, myWeapon, NewCurrentIndexWeapon));
+					//recorded sessions hand out reproducible spread seeds, also to weapons spawned before possession
+					if (UTopDownShooterInputReplay* myInputReplay = GetActiveInputReplay(this, false))
+						myWeapon->WeaponRandomStream.Initialize(myInputReplay->GetWeaponSeed());
 					
 
 					myWeapon->OnWeaponReloadStart.AddDynamic(this, &ATopDownShooterCharacter::WeaponReloadStart);
@@ -339,6 +505,9 @@ void ATopDownShooterCharacter::InitWeapon(FName IdWeaponName, FAdditionalWeaponI
 
 void ATopDownShooterCharacter::TryReloadWeapon()
 {
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		ServerReloadWeapon();
+
 	if (CurrentWeapon && !CurrentWeapon->WeaponReloading)
 	{
 		if (CurrentWeapon->GetWeaponRound() <= CurrentWeapon->WeaponSetting.MaxRound)
@@ -366,6 +535,70 @@ void ATopDownShooterCharacter::WeaponFireStart_BP_Implementation(UAnimMontage* A
 	// in BP
 }
 
+bool ATopDownShooterCharacter::ServerWeaponFire_Validate(const FWeaponFireEvent& FireEvent)
+{
+	//a slot the inventory never had is not a late event, the client is tampering
+	return InventoryComponent && InventoryComponent->WeaponSlots.IsValidIndex(FireEvent.WeaponSlot);
+}
+
+void ATopDownShooterCharacter::ServerWeaponFire_Implementation(const FWeaponFireEvent& FireEvent)
+{
+	//everyone else gets the shot the server resolved, dispersion clamped and quantized again
+	FWeaponFireEvent AcceptedEvent;
+	if (CurrentWeapon && CurrentWeapon->WeaponSlotIndex == FireEvent.WeaponSlot && CurrentWeapon->FireFromRemoteEvent(FireEvent, AcceptedEvent))
+	{
+		MulticastWeaponFire(AcceptedEvent);
+	}
+}
+
+bool ATopDownShooterCharacter::ServerSwitchWeapon_Validate(bool bIsForward)
+{
+	//both directions are valid, an empty inventory just does nothing
+	return true;
+}
+
+void ATopDownShooterCharacter::ServerSwitchWeapon_Implementation(bool bIsForward)
+{
+	if (bIsForward)
+		TrySwicthNextWeapon();
+	else
+		TrySwitchPreviosWeapon();
+}
+
+bool ATopDownShooterCharacter::ServerReloadWeapon_Validate()
+{
+	return true;
+}
+
+void ATopDownShooterCharacter::ServerReloadWeapon_Implementation()
+{
+	TryReloadWeapon();
+}
+
+bool ATopDownShooterCharacter::ServerChangeMovementState_Validate(bool bWalkEnabled, bool bSprintRunEnabled, bool bAimEnabled)
+{
+	//ChangeMovementState resolves any combination
+	return true;
+}
+
+void ATopDownShooterCharacter::ServerChangeMovementState_Implementation(bool bWalkEnabled, bool bSprintRunEnabled, bool bAimEnabled)
+{
+	WalkEnabled = bWalkEnabled;
+	SprintRunEnabled = bSprintRunEnabled;
+	AimEnabled = bAimEnabled;
+	ChangeMovementState();
+}
+
+void ATopDownShooterCharacter::MulticastWeaponFire_Implementation(const FWeaponFireEvent& FireEvent)
+{
+	//server and the shooting client already handled this shot
+	if (HasAuthority() || IsLocallyControlled())
+		return;
+
+	if (CurrentWeapon)
+		CurrentWeapon->SimulateFireEvent(FireEvent);
+}
+
 void ATopDownShooterCharacter::WeaponReloadStart_BP_Implementation(UAnimMontage * Anim)
 {
 	// in BP
@@ -383,6 +616,9 @@ UDecalComponent * ATopDownShooterCharacter::GetCursorToWorld()
 
 void ATopDownShooterCharacter::TrySwicthNextWeapon()
 {
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		ServerSwitchWeapon(true);
+
 	if (InventoryComponent->WeaponSlots.Num() > 1)
 	{
 		//We have more then one weapon go switch
@@ -408,6 +644,9 @@ void ATopDownShooterCharacter::TrySwicthNextWeapon()
 
 void ATopDownShooterCharacter::TrySwitchPreviosWeapon()
 {
+	if (GetLocalRole() == ROLE_AutonomousProxy)
+		ServerSwitchWeapon(false);
+
 	if (InventoryComponent->WeaponSlots.Num() > 1)
 	{
 		//We have more then one weapon go switch
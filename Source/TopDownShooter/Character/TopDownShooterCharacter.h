@@ -25,6 +25,7 @@ class ATopDownShooterCharacter : public ACharacter
 protected:
 
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 
@@ -35,6 +36,8 @@ public:
 
 	virtual void SetupPlayerInputComponent(class UInputComponent* NewInputComponent);
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 	/** Returns TopDownCameraComponent subobject **/
 	FORCEINLINE class UCameraComponent* GetTopDownCameraComponent() const { return TopDownCameraComponent; }
 	/** Returns CameraBoom subobject **/
@@ -42,6 +45,8 @@ public:
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	class UTopDownShooterInventorComponent* InventoryComponent;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Health, meta = (AllowPrivateAccess = "true"))
+	class UTopDownShooterHealthComponent* HealthComponent;
 private:
 	/** Top down camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -78,7 +83,12 @@ public:
 	void InputAttackPressed();
 	UFUNCTION()
 	void InputAttackReleased();
-
+	UFUNCTION()
+	void InputReloadReleased();
+	UFUNCTION()
+	void InputSwitchNextPressed();
+	UFUNCTION()
+	void InputSwitchPreviosPressed();
 
 	float AxisX = 0.0f;
 	float AxisY = 0.0f;
@@ -88,8 +98,25 @@ public:
 	void AttackCharEvent(bool bIsFiring);
 	UFUNCTION()
 	void MovementTick(float DeltaTime);
+	//MovementTick runs in UTopDownShooterCharacterTickManager instead of Tick
+	bool bMovementTickBatched = false;
+	//world point under the cursor, or the recorded one while an input replay runs
+	bool GetCursorAimLocation(FVector& OutLocation);
+
+	//bots and benchmarks aim without a cursor
+	void SetAimOverride(const FVector& Location) { bHasAimOverride = true; AimOverrideLocation = Location; }
+	void ClearAimOverride() { bHasAimOverride = false; }
+	bool bHasAimOverride = false;
+	FVector AimOverrideLocation = FVector::ZeroVector;
 	UFUNCTION(BlueprintCallable)
 	void CharacterUpdate();
+	//pushed by UTopDownShooterStatusEffects on the server when effects on this character start or end
+	void SetStatusModifiers(const FStatusEffectModifiers& Modifiers);
+	//the owning client predicts movement and fire rate, so it needs the same modifiers
+	UPROPERTY(ReplicatedUsing = OnRep_StatusModifiers, BlueprintReadOnly, Category = "Movement")
+	FStatusEffectModifiers StatusModifiers;
+	UFUNCTION()
+	void OnRep_StatusModifiers();
 	UFUNCTION(BlueprintCallable)
 	void ChangeMovementState();
 
@@ -112,6 +139,20 @@ public:
 	UFUNCTION(BlueprintNativeEvent)
 	void WeaponFireStart_BP(UAnimMontage* Anim);
 
+	//Fire events: owning client -> server, server -> everyone else
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerWeaponFire(const FWeaponFireEvent& FireEvent);
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastWeaponFire(const FWeaponFireEvent& FireEvent);
+	//switch and reload are predicted by the owning client and repeated on the server, which validates shots against them
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerSwitchWeapon(bool bIsForward);
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerReloadWeapon();
+	//the server tracks the shooter's dispersion itself, so it needs the movement state it depends on
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerChangeMovementState(bool bWalkEnabled, bool bSprintRunEnabled, bool bAimEnabled);
+
 
 	//Cursor
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Cursor")
@@ -0,0 +1,192 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterCharacterTickManager.h"
+#include "Character/TopDownShooterCharacter.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "Engine/Level.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Character Batch Tick"), STAT_TPS_CharacterBatchTick, STATGROUP_TopDownShooter);
+
+int32 CharacterTickManagerEnabled = 1;
+FAutoConsoleVariableRef CVARCharacterTickManagerEnabled(TEXT("TPS.CharacterTickManager"), CharacterTickManagerEnabled, TEXT("Run MovementTick of all characters in one batched tick, applies to characters that begin play afterwards"), ECVF_Default);
+
+void FCharacterBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Manager && TickType != LEVELTICK_ViewportsOnly)
+		Manager->TickCharacters(DeltaTime);
+}
+
+FString FCharacterBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("UTopDownShooterCharacterTickManager::TickCharacters");
+}
+
+void FCharacterAimBatch::Reset(int32 Num)
+{
+	AxisX.SetNumUninitialized(Num, false);
+	AxisY.SetNumUninitialized(Num, false);
+	LocationX.SetNumUninitialized(Num, false);
+	LocationY.SetNumUninitialized(Num, false);
+	AimX.SetNumUninitialized(Num, false);
+	AimY.SetNumUninitialized(Num, false);
+	AimZ.SetNumUninitialized(Num, false);
+	State.SetNumUninitialized(Num, false);
+	bHasAim.SetNumUninitialized(Num, false);
+	Yaw.SetNumUninitialized(Num, false);
+	bRotate.SetNumUninitialized(Num, false);
+	ShootEndZ.SetNumUninitialized(Num, false);
+	bReduceDispersion.SetNumUninitialized(Num, false);
+}
+
+void UTopDownShooterCharacterTickManager::Deinitialize()
+{
+	if (BatchTickFunction.IsTickFunctionRegistered())
+		BatchTickFunction.UnRegisterTickFunction();
+	BatchTickFunction.Manager = nullptr;
+	Characters.Empty();
+	BatchCharacters.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterCharacterTickManager::RegisterCharacter(ATopDownShooterCharacter* Character)
+{
+	UWorld* myWorld = GetWorld();
+	if (!CharacterTickManagerEnabled || !Character || !myWorld || !myWorld->IsGameWorld() || !myWorld->PersistentLevel)
+		return false;
+
+	if (!BatchTickFunction.IsTickFunctionRegistered())
+	{
+		BatchTickFunction.Manager = this;
+		BatchTickFunction.bCanEverTick = true;
+		BatchTickFunction.bStartWithTickEnabled = true;
+		BatchTickFunction.TickGroup = TG_PrePhysics;
+		BatchTickFunction.RegisterTickFunction(myWorld->PersistentLevel);
+	}
+
+	Characters.AddUnique(Character);
+
+	//cursor and input replay run in the actor tick first, movement consumes the batch's input
+	BatchTickFunction.AddPrerequisite(Character, Character->PrimaryActorTick);
+	if (UCharacterMovementComponent* myMovement = Character->GetCharacterMovement())
+		myMovement->PrimaryComponentTick.AddPrerequisite(this, BatchTickFunction);
+
+	return true;
+}
+
+void UTopDownShooterCharacterTickManager::UnregisterCharacter(ATopDownShooterCharacter* Character)
+{
+	if (!Character)
+		return;
+
+	Characters.Remove(Character);
+
+	BatchTickFunction.RemovePrerequisite(Character, Character->PrimaryActorTick);
+	if (UCharacterMovementComponent* myMovement = Character->GetCharacterMovement())
+		myMovement->PrimaryComponentTick.RemovePrerequisite(this, BatchTickFunction);
+	if (Character->CurrentWeapon)
+		Character->CurrentWeapon->PrimaryActorTick.RemovePrerequisite(this, BatchTickFunction);
+}
+
+void UTopDownShooterCharacterTickManager::AddWeaponPrerequisite(AActor* Weapon)
+{
+	if (Weapon && BatchTickFunction.IsTickFunctionRegistered())
+		Weapon->PrimaryActorTick.AddPrerequisite(this, BatchTickFunction);
+}
+
+void UTopDownShooterCharacterTickManager::TickCharacters(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_CharacterBatchTick);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, CharacterBatchTick);
+
+	Gather();
+	if (BatchCharacters.Num() == 0)
+		return;
+
+	Compute();
+	Apply();
+}
+
+void UTopDownShooterCharacterTickManager::Gather()
+{
+	BatchCharacters.Reset();
+	for (int32 i = Characters.Num() - 1; i >= 0; i--)
+	{
+		ATopDownShooterCharacter* myCharacter = Characters[i].Get();
+		if (!myCharacter || myCharacter->IsPendingKill())
+		{
+			Characters.RemoveAtSwap(i, 1, false);
+			continue;
+		}
+		//same as the actor tick that used to run MovementTick
+		if (myCharacter->IsActorTickEnabled())
+			BatchCharacters.Add(myCharacter);
+	}
+
+	const int32 Num = BatchCharacters.Num();
+	Batch.Reset(Num);
+	for (int32 i = 0; i < Num; i++)
+	{
+		ATopDownShooterCharacter* myCharacter = BatchCharacters[i];
+		const FVector myLocation = myCharacter->GetActorLocation();
+
+		Batch.AxisX[i] = myCharacter->AxisX;
+		Batch.AxisY[i] = myCharacter->AxisY;
+		Batch.LocationX[i] = myLocation.X;
+		Batch.LocationY[i] = myLocation.Y;
+		Batch.State[i] = uint8(myCharacter->MovementState);
+
+		//cursor traces and replay lookups stay on the game thread
+		FVector myAimLocation = FVector::ZeroVector;
+		Batch.bHasAim[i] = myCharacter->MovementState != EMovementState::SprintRun_State && myCharacter->GetCursorAimLocation(myAimLocation);
+		Batch.AimX[i] = myAimLocation.X;
+		Batch.AimY[i] = myAimLocation.Y;
+		Batch.AimZ[i] = myAimLocation.Z;
+	}
+}
+
+void UTopDownShooterCharacterTickManager::Compute()
+{
+	//a few flops per character, cheaper on this thread than any task dispatch; the traces in Gather are the real cost
+	for (int32 i = 0; i < BatchCharacters.Num(); i++)
+	{
+		const EMovementState myState = EMovementState(Batch.State[i]);
+		const bool bSprint = myState == EMovementState::SprintRun_State;
+		const bool bAiming = myState == EMovementState::Aim_State || myState == EMovementState::AimWalk_State;
+
+		//sprint faces the input, everything else looks at the aim point like FindLookAtRotation
+		const float DirX = bSprint ? Batch.AxisX[i] : Batch.AimX[i] - Batch.LocationX[i];
+		const float DirY = bSprint ? Batch.AxisY[i] : Batch.AimY[i] - Batch.LocationY[i];
+		Batch.Yaw[i] = FMath::Atan2(DirY, DirX) * (180.f / PI);
+		Batch.bRotate[i] = bSprint || Batch.bHasAim[i];
+
+		Batch.ShootEndZ[i] = Batch.AimZ[i] + (bAiming ? 160.0f : 120.0f);
+		Batch.bReduceDispersion[i] = bAiming;
+	}
+}
+
+void UTopDownShooterCharacterTickManager::Apply()
+{
+	for (int32 i = 0; i < BatchCharacters.Num(); i++)
+	{
+		ATopDownShooterCharacter* myCharacter = BatchCharacters[i];
+
+		myCharacter->AddMovementInput(FVector(1.0f, 0.0f, 0.0f), Batch.AxisX[i]);
+		myCharacter->AddMovementInput(FVector(0.0f, 1.0f, 0.0f), Batch.AxisY[i]);
+
+		if (!Batch.bRotate[i])
+			continue;
+
+		myCharacter->SetActorRotation(FQuat(FRotator(0.0f, Batch.Yaw[i], 0.0f)));
+
+		if (Batch.bHasAim[i] && myCharacter->CurrentWeapon)
+		{
+			myCharacter->CurrentWeapon->SetShouldReduceDispersion(Batch.bReduceDispersion[i] != 0);
+			myCharacter->CurrentWeapon->ShootEndLocation = FVector(Batch.AimX[i], Batch.AimY[i], Batch.ShootEndZ[i]);
+		}
+	}
+}
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "TopDownShooterCharacterTickManager.generated.h"
+
+class ATopDownShooterCharacter;
+class UTopDownShooterCharacterTickManager;
+
+USTRUCT()
+struct FCharacterBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	UTopDownShooterCharacterTickManager* Manager = nullptr;
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FCharacterBatchTickFunction> : public TStructOpsTypeTraitsBase2<FCharacterBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+//Movement inputs and aim of every character for one frame, structure of arrays
+struct FCharacterAimBatch
+{
+	void Reset(int32 Num);
+
+	TArray<float> AxisX;
+	TArray<float> AxisY;
+	TArray<float> LocationX;
+	TArray<float> LocationY;
+	TArray<float> AimX;
+	TArray<float> AimY;
+	TArray<float> AimZ;
+	TArray<uint8> State;
+	TArray<uint8> bHasAim;
+
+	//results
+	TArray<float> Yaw;
+	TArray<uint8> bRotate;
+	TArray<float> ShootEndZ;
+	TArray<uint8> bReduceDispersion;
+};
+
+/**
+ * Runs MovementTick for all characters in one pass instead of one per actor (TPS.CharacterTickManager).
+ * Gathers inputs and aim points, computes yaw and weapon aim points over contiguous arrays, applies them back.
+ * Ticks after the characters (cursor, input replay) and before their movement components and weapons, so shots use this frame's aim.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterCharacterTickManager : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//false when batching is off, the character then runs MovementTick itself
+	bool RegisterCharacter(ATopDownShooterCharacter* Character);
+	void UnregisterCharacter(ATopDownShooterCharacter* Character);
+
+	//the weapon fires after the aim of its character was applied
+	void AddWeaponPrerequisite(AActor* Weapon);
+
+	void TickCharacters(float DeltaTime);
+
+private:
+	void Gather();
+	void Compute();
+	void Apply();
+
+	FCharacterBatchTickFunction BatchTickFunction;
+
+	TArray<TWeakObjectPtr<ATopDownShooterCharacter>> Characters;
+	//characters of this frame, same order as the batch
+	TArray<ATopDownShooterCharacter*> BatchCharacters;
+	FCharacterAimBatch Batch;
+};
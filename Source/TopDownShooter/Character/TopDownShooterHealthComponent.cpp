@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterHealthComponent.h"
+#include "Character/TopDownShooterHealthTable.h"
+#include "GameFramework/Actor.h"
+#include "Engine/World.h"
+#include "Net/UnrealNetwork.h"
+
+UTopDownShooterHealthComponent::UTopDownShooterHealthComponent()
+{
+	//UTopDownShooterHealthTable processes all health components in one pass
+	PrimaryComponentTick.bCanEverTick = false;
+	SetIsReplicatedByDefault(true);
+}
+
+void UTopDownShooterHealthComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (GetOwnerRole() == ROLE_Authority)
+		Health = MaxHealth;
+
+	if (UTopDownShooterHealthTable* myHealthTable = GetWorld()->GetSubsystem<UTopDownShooterHealthTable>())
+		myHealthTable->RegisterComponent(this);
+
+	AActor* myOwner = GetOwner();
+	if (myOwner && bTakeOwnerDamage)
+		myOwner->OnTakeAnyDamage.AddDynamic(this, &UTopDownShooterHealthComponent::TakeAnyDamage);
+}
+
+void UTopDownShooterHealthComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AActor* myOwner = GetOwner())
+		myOwner->OnTakeAnyDamage.RemoveDynamic(this, &UTopDownShooterHealthComponent::TakeAnyDamage);
+
+	if (UTopDownShooterHealthTable* myHealthTable = GetWorld()->GetSubsystem<UTopDownShooterHealthTable>())
+		myHealthTable->UnregisterComponent(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+float UTopDownShooterHealthComponent::GetCurrentHealth() const
+{
+	//the table rows of clients never take damage
+	if (GetOwnerRole() != ROLE_Authority)
+		return Health;
+
+	const UTopDownShooterHealthTable* myHealthTable = GetWorld() ? GetWorld()->GetSubsystem<UTopDownShooterHealthTable>() : nullptr;
+	return myHealthTable ? myHealthTable->GetHealth(this) : 0.0f;
+}
+
+bool UTopDownShooterHealthComponent::IsDead() const
+{
+	if (GetOwnerRole() != ROLE_Authority)
+		return Health <= 0.0f;
+
+	const UTopDownShooterHealthTable* myHealthTable = GetWorld() ? GetWorld()->GetSubsystem<UTopDownShooterHealthTable>() : nullptr;
+	return myHealthTable && myHealthTable->IsDead(this);
+}
+
+void UTopDownShooterHealthComponent::ChangeHealthValue(float Damage, AController* EventInstigator)
+{
+	if (UTopDownShooterHealthTable* myHealthTable = GetWorld()->GetSubsystem<UTopDownShooterHealthTable>())
+		myHealthTable->QueueDamage(this, Damage, EventInstigator);
+}
+
+void UTopDownShooterHealthComponent::TakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser)
+{
+	ChangeHealthValue(Damage, InstigatedBy);
+}
+
+void UTopDownShooterHealthComponent::OnRep_Health(float OldHealth)
+{
+	OnHealthChange.Broadcast(Health, OldHealth - Health);
+	if (Health <= 0.0f && OldHealth > 0.0f)
+		OnDead.Broadcast(nullptr);
+}
+
+void UTopDownShooterHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(UTopDownShooterHealthComponent, Health);
+}
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "TopDownShooterHealthComponent.generated.h"
+
+class UDamageType;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHealthChange, float, Health, float, Damage);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnDead, AController*, Killer);
+
+/**
+ * Health of its owner, the values live in UTopDownShooterHealthTable.
+ * Damage from ApplyDamage is queued and applied with regen and death checks once per frame for all components,
+ * OnHealthChange fires at most once per frame with the summed damage, OnDead once.
+ * The server replicates the health, clients read it and get their events from OnRep_Health.
+ */
+UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
+class TOPDOWNSHOOTER_API UTopDownShooterHealthComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	friend class UTopDownShooterHealthTable;
+
+public:
+	UTopDownShooterHealthComponent();
+
+	UPROPERTY(BlueprintAssignable, Category = "Health")
+	FOnHealthChange OnHealthChange;
+	UPROPERTY(BlueprintAssignable, Category = "Health")
+	FOnDead OnDead;
+
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Health")
+	float MaxHealth = 100.0f;
+	//health per second, 0 for none
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Health")
+	float RegenPerSecond = 0.0f;
+	//seconds after the last damage before regen starts
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Health")
+	float RegenDelay = 3.0f;
+	//bind to the owner OnTakeAnyDamage, off while a Blueprint health component of the owner still takes that damage
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Health")
+	bool bTakeOwnerDamage = true;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//copy of the table row written by the server once per frame it changes
+	UPROPERTY(ReplicatedUsing = OnRep_Health)
+	float Health = 0.0f;
+	UFUNCTION()
+	void OnRep_Health(float OldHealth);
+
+public:
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	float GetCurrentHealth() const;
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	float GetMaxHealth() const { return MaxHealth; }
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	bool IsDead() const;
+
+	//negative heals, applied with the damage of this frame
+	UFUNCTION(BlueprintCallable, Category = "Health")
+	void ChangeHealthValue(float Damage, AController* EventInstigator = nullptr);
+
+	UFUNCTION()
+	void TakeAnyDamage(AActor* DamagedActor, float Damage, const UDamageType* DamageType, AController* InstigatedBy, AActor* DamageCauser);
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+private:
+	//row in the health table, INDEX_NONE while not registered
+	int32 HealthIndex = INDEX_NONE;
+};
@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterHealthTable.h"
+#include "Character/TopDownShooterHealthComponent.h"
+#include "GameFramework/Controller.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Health Table"), STAT_TPS_HealthTable, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Rows"), STAT_TPS_HealthRows, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Notifies"), STAT_TPS_HealthNotifies, STATGROUP_TopDownShooter);
+
+void FHealthRows::Add(float InMaxHealth, float InRegenPerSecond, float InRegenDelay)
+{
+	Health.Add(InMaxHealth);
+	MaxHealth.Add(InMaxHealth);
+	RegenPerSecond.Add(InRegenPerSecond);
+	RegenDelay.Add(InRegenDelay);
+	RegenCooldown.Add(0.0f);
+	PendingDamage.Add(0.0f);
+	bDead.Add(0);
+	LastInstigator.Add(nullptr);
+}
+
+void FHealthRows::RemoveAtSwap(int32 Index)
+{
+	Health.RemoveAtSwap(Index, 1, false);
+	MaxHealth.RemoveAtSwap(Index, 1, false);
+	RegenPerSecond.RemoveAtSwap(Index, 1, false);
+	RegenDelay.RemoveAtSwap(Index, 1, false);
+	RegenCooldown.RemoveAtSwap(Index, 1, false);
+	PendingDamage.RemoveAtSwap(Index, 1, false);
+	bDead.RemoveAtSwap(Index, 1, false);
+	LastInstigator.RemoveAtSwap(Index, 1, false);
+}
+
+void FHealthRows::Empty()
+{
+	Health.Empty();
+	MaxHealth.Empty();
+	RegenPerSecond.Empty();
+	RegenDelay.Empty();
+	RegenCooldown.Empty();
+	PendingDamage.Empty();
+	bDead.Empty();
+	LastInstigator.Empty();
+}
+
+void UTopDownShooterHealthTable::Deinitialize()
+{
+	for (UTopDownShooterHealthComponent* Component : Components)
+	{
+		if (Component)
+			Component->HealthIndex = INDEX_NONE;
+	}
+	Components.Empty();
+	Rows.Empty();
+	Notifies.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterHealthTable::IsTickable() const
+{
+	return Rows.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UTopDownShooterHealthTable::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterHealthTable, STATGROUP_Tickables);
+}
+
+void UTopDownShooterHealthTable::RegisterComponent(UTopDownShooterHealthComponent* Component)
+{
+	if (!Component || Component->HealthIndex != INDEX_NONE)
+		return;
+
+	Component->HealthIndex = Components.Add(Component);
+	Rows.Add(FMath::Max(Component->MaxHealth, 0.0f), Component->RegenPerSecond, Component->RegenDelay);
+}
+
+void UTopDownShooterHealthTable::UnregisterComponent(UTopDownShooterHealthComponent* Component)
+{
+	if (!Component || !Components.IsValidIndex(Component->HealthIndex) || Components[Component->HealthIndex] != Component)
+		return;
+
+	const int32 Index = Component->HealthIndex;
+	Component->HealthIndex = INDEX_NONE;
+	Rows.RemoveAtSwap(Index);
+	Components.RemoveAtSwap(Index, 1, false);
+	if (Index < Components.Num())
+		Components[Index]->HealthIndex = Index;
+}
+
+void UTopDownShooterHealthTable::QueueDamage(UTopDownShooterHealthComponent* Component, float Damage, AController* EventInstigator)
+{
+	if (!Component || !Components.IsValidIndex(Component->HealthIndex))
+		return;
+
+	const int32 Index = Component->HealthIndex;
+	Rows.PendingDamage[Index] += Damage;
+	if (EventInstigator && Damage > 0.0f)
+		Rows.LastInstigator[Index] = EventInstigator;
+}
+
+void UTopDownShooterHealthTable::QueueDamageBatch(const TArray<FHealthDamage>& Damages)
+{
+	for (const FHealthDamage& Entry : Damages)
+		QueueDamage(Entry.Target, Entry.Damage, Entry.EventInstigator);
+}
+
+float UTopDownShooterHealthTable::GetHealth(const UTopDownShooterHealthComponent* Component) const
+{
+	return Component && Components.IsValidIndex(Component->HealthIndex) ? Rows.Health[Component->HealthIndex] : 0.0f;
+}
+
+bool UTopDownShooterHealthTable::IsDead(const UTopDownShooterHealthComponent* Component) const
+{
+	return Component && Components.IsValidIndex(Component->HealthIndex) && Rows.bDead[Component->HealthIndex];
+}
+
+void UTopDownShooterHealthTable::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_HealthTable);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, HealthTable);
+
+	Process(DeltaTime);
+	SET_DWORD_STAT(STAT_TPS_HealthRows, Rows.Num());
+	SET_DWORD_STAT(STAT_TPS_HealthNotifies, Notifies.Num());
+	Notify();
+}
+
+void UTopDownShooterHealthTable::Process(float DeltaTime)
+{
+	Notifies.Reset();
+	for (int32 i = 0; i < Rows.Num(); i++)
+	{
+		const float Damage = Rows.PendingDamage[i];
+		Rows.PendingDamage[i] = 0.0f;
+		if (Rows.bDead[i])
+			continue;
+
+		const float OldHealth = Rows.Health[i];
+		if (Damage != 0.0f)
+		{
+			Rows.Health[i] = FMath::Clamp(OldHealth - Damage, 0.0f, Rows.MaxHealth[i]);
+			if (Damage > 0.0f)
+				Rows.RegenCooldown[i] = Rows.RegenDelay[i];
+		}
+		else if (Rows.RegenPerSecond[i] > 0.0f && OldHealth < Rows.MaxHealth[i])
+		{
+			Rows.RegenCooldown[i] -= DeltaTime;
+			if (Rows.RegenCooldown[i] <= 0.0f)
+				Rows.Health[i] = FMath::Min(OldHealth + Rows.RegenPerSecond[i] * DeltaTime, Rows.MaxHealth[i]);
+		}
+
+		if (Rows.Health[i] == OldHealth)
+			continue;
+
+		Notifies.AddDefaulted();
+		FHealthNotify& myNotify = Notifies.Last();
+		myNotify.Component = Components[i];
+		myNotify.Health = Rows.Health[i];
+		myNotify.Damage = OldHealth - Rows.Health[i];
+		if (Rows.Health[i] <= 0.0f)
+		{
+			Rows.bDead[i] = 1;
+			myNotify.bDied = true;
+			myNotify.Killer = Rows.LastInstigator[i];
+		}
+	}
+}
+
+void UTopDownShooterHealthTable::Notify()
+{
+	//handlers may destroy actors and unregister rows, the notifies do not point into the table
+	for (const FHealthNotify& myNotify : Notifies)
+	{
+		UTopDownShooterHealthComponent* myComponent = myNotify.Component.Get();
+		if (!myComponent)
+			continue;
+
+		myComponent->Health = myNotify.Health;
+		myComponent->OnHealthChange.Broadcast(myNotify.Health, myNotify.Damage);
+		if (myNotify.bDied)
+			myComponent->OnDead.Broadcast(myNotify.Killer.Get());
+	}
+	Notifies.Reset();
+}
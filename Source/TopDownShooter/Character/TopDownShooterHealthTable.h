@@ -0,0 +1,87 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TopDownShooterHealthTable.generated.h"
+
+class UTopDownShooterHealthComponent;
+
+//Health of every registered component as structure of arrays, dense (removal swaps the last row in)
+struct FHealthRows
+{
+	int32 Num() const { return Health.Num(); }
+	void Add(float InMaxHealth, float InRegenPerSecond, float InRegenDelay);
+	void RemoveAtSwap(int32 Index);
+	void Empty();
+
+	TArray<float> Health;
+	TArray<float> MaxHealth;
+	TArray<float> RegenPerSecond;
+	TArray<float> RegenDelay;
+	TArray<float> RegenCooldown;
+	//summed damage of this frame, negative heals
+	TArray<float> PendingDamage;
+	TArray<uint8> bDead;
+	TArray<TWeakObjectPtr<AController>> LastInstigator;
+};
+
+//One queued damage, for callers hitting many targets at once
+struct FHealthDamage
+{
+	UTopDownShooterHealthComponent* Target = nullptr;
+	float Damage = 0.0f;
+	AController* EventInstigator = nullptr;
+};
+
+//Events of one component for one frame
+struct FHealthNotify
+{
+	TWeakObjectPtr<UTopDownShooterHealthComponent> Component;
+	float Health = 0.0f;
+	float Damage = 0.0f;
+	bool bDied = false;
+	TWeakObjectPtr<AController> Killer;
+};
+
+/**
+ * Health values of all UTopDownShooterHealthComponent of the world in contiguous arrays.
+ * Damage is only summed when it arrives; once per frame damage, regen and deaths are processed for every row
+ * in one pass, then the changed components broadcast their Blueprint events.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterHealthTable : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	void RegisterComponent(UTopDownShooterHealthComponent* Component);
+	void UnregisterComponent(UTopDownShooterHealthComponent* Component);
+
+	void QueueDamage(UTopDownShooterHealthComponent* Component, float Damage, AController* EventInstigator);
+	void QueueDamageBatch(const TArray<FHealthDamage>& Damages);
+
+	float GetHealth(const UTopDownShooterHealthComponent* Component) const;
+	bool IsDead(const UTopDownShooterHealthComponent* Component) const;
+
+private:
+	void Process(float DeltaTime);
+	void Notify();
+
+	FHealthRows Rows;
+	UPROPERTY()
+	TArray<UTopDownShooterHealthComponent*> Components;
+
+	//filled by Process, broadcast by Notify once the table is consistent again
+	TArray<FHealthNotify> Notifies;
+};
@@ -3,6 +3,11 @@
 
 #include "TopDownShooterInventorComponent.h"
 #include "Game/TopDownShooterGameInstance.h"
+#include "FuncLibrary/InventoryLogic.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterMemory.h"
+
+DECLARE_CYCLE_STAT(TEXT("Inventory SwitchWeaponToIndex"), STAT_TPS_SwitchWeaponToIndex, STATGROUP_TopDownShooter);
 #pragma optimize ("", off)
 
 // Sets default values for this component's properties
@@ -21,6 +26,7 @@ void UTopDownShooterInventorComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
+	TPS_LLM_SCOPE(Inventory);
 	// ...
 
 	//Find init weaponsSlots and First Init Weapon
@@ -64,329 +70,27 @@ void UTopDownShooterInventorComponent::TickComponent(float DeltaTime, ELevelTick
 
 bool UTopDownShooterInventorComponent::SwitchWeaponToIndex(int32 ChangeToIndex, int32 OldIndex, FAdditionalWeaponInfos OldInfo, bool bIsForward)
 {
-	bool bIsSuccess = false;
-	int8 CorrectIndex = ChangeToIndex;
-	if (ChangeToIndex > WeaponSlots.Num() - 1)
-		CorrectIndex = 0;
-	else
-		if (ChangeToIndex < 0)
-			CorrectIndex = WeaponSlots.Num() - 1;
-
-	FName NewIdWeapon;
-	FAdditionalWeaponInfos NewAdditionalInfo;
-	int32 NewCurrentIndex = 0;
+	SCOPE_CYCLE_COUNTER(STAT_TPS_SwitchWeaponToIndex);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, SwitchWeaponToIndex);
 
-	if (WeaponSlots.IsValidIndex(CorrectIndex))
+	UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
+	auto GetWeaponType = [myGI](FName WeaponName, EWeaponType& OutType)
 	{
-		if (!WeaponSlots[CorrectIndex].NameItem.IsNone())
-		{
-			if (WeaponSlots[CorrectIndex].AdditionalInfo.Round > 0)
-			{
-				//good weapon have ammo start change
-				bIsSuccess = true;
-			}
-			else
-			{
-				UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-				if (myGI)
-				{
-					//check ammoSlots for this weapon
-					FWeaponInfos myInfo;
-					myGI->GetWeaponInfoByName(WeaponSlots[CorrectIndex].NameItem, myInfo);
-
-					bool bIsFind = false;
-					int8 j = 0;
-					while (j < AmmoSlots.Num() && !bIsFind)
-					{
-						if (AmmoSlots[j].WeaponType == myInfo.WeaponType && AmmoSlots[j].Cout > 0)
-						{
-							//good weapon have ammo start change
-							bIsSuccess = true;
-							bIsFind = true;
-						}
-						j++;
-					}
-				}
-			}
-			if (bIsSuccess)
-			{
-				NewCurrentIndex = CorrectIndex;
-				NewIdWeapon = WeaponSlots[CorrectIndex].NameItem;
-				NewAdditionalInfo = WeaponSlots[CorrectIndex].AdditionalInfo;
-			}
-		}
-	}
+		FWeaponInfos myInfo;
+		if (!myGI || !myGI->GetWeaponInfoByName(WeaponName, myInfo))
+			return false;
+		OutType = myInfo.WeaponType;
+		return true;
+	};
 
-	if (!bIsSuccess)
-	{
-		if (bIsForward)
-		{
-			int8 iteration = 0;
-			int8 Seconditeration = 0;
-			while (iteration < WeaponSlots.Num() && !bIsSuccess)
-			{
-				iteration++;
-				int8 tmpIndex = ChangeToIndex + iteration;
-				if (WeaponSlots.IsValidIndex(tmpIndex))
-				{
-					if (!WeaponSlots[tmpIndex].NameItem.IsNone())
-					{
-						if (WeaponSlots[tmpIndex].AdditionalInfo.Round > 0)
-						{
-							//WeaponGood
-							bIsSuccess = true;
-							NewIdWeapon = WeaponSlots[tmpIndex].NameItem;
-							NewAdditionalInfo = WeaponSlots[tmpIndex].AdditionalInfo;
-							NewCurrentIndex = tmpIndex;
-						}
-						else
-						{
-							FWeaponInfos myInfo;
-							UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-							myGI->GetWeaponInfoByName(WeaponSlots[tmpIndex].NameItem, myInfo);
-
-							bool bIsFind = false;
-							int8 j = 0;
-							while (j < AmmoSlots.Num() && !bIsFind)
-							{
-								if (AmmoSlots[j].WeaponType == myInfo.WeaponType && AmmoSlots[j].Cout > 0)
-								{
-									//WeaponGood
-									bIsSuccess = true;
-									NewIdWeapon = WeaponSlots[tmpIndex].NameItem;
-									NewAdditionalInfo = WeaponSlots[tmpIndex].AdditionalInfo;
-									NewCurrentIndex = tmpIndex;
-									bIsFind = true;
-								}
-								j++;
-							}
-						}
-					}
-				}
-				else
-				{
-					//go to end of right of array weapon slots
-					if (OldIndex != Seconditeration)
-					{
-						if (WeaponSlots.IsValidIndex(Seconditeration))
-						{
-							if (!WeaponSlots[Seconditeration].NameItem.IsNone())
-							{
-								if (WeaponSlots[Seconditeration].AdditionalInfo.Round > 0)
-								{
-									//WeaponGood
-									bIsSuccess = true;
-									NewIdWeapon = WeaponSlots[Seconditeration].NameItem;
-									NewAdditionalInfo = WeaponSlots[Seconditeration].AdditionalInfo;
-									NewCurrentIndex = Seconditeration;
-								}
-								else
-								{
-									FWeaponInfos myInfo;
-									UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-									myGI->GetWeaponInfoByName(WeaponSlots[Seconditeration].NameItem, myInfo);
-
-									bool bIsFind = false;
-									int8 j = 0;
-									while (j < AmmoSlots.Num() && !bIsFind)
-									{
-										if (AmmoSlots[j].WeaponType == myInfo.WeaponType && AmmoSlots[j].Cout > 0)
-										{
-											//WeaponGood
-											bIsSuccess = true;
-											NewIdWeapon = WeaponSlots[Seconditeration].NameItem;
-											NewAdditionalInfo = WeaponSlots[Seconditeration].AdditionalInfo;
-											NewCurrentIndex = Seconditeration;
-											bIsFind = true;
-										}
-										j++;
-									}
-								}
-							}
-						}
-					}
-					else
-					{
-						//go to same weapon when start
-						if (WeaponSlots.IsValidIndex(Seconditeration))
-						{
-							if (!WeaponSlots[Seconditeration].NameItem.IsNone())
-							{
-								if (WeaponSlots[Seconditeration].AdditionalInfo.Round > 0)
-								{
-									//WeaponGood, it same weapon do nothing
-								}
-								else
-								{
-									FWeaponInfos myInfo;
-									UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-									myGI->GetWeaponInfoByName(WeaponSlots[Seconditeration].NameItem, myInfo);
-
-									bool bIsFind = false;
-									int8 j = 0;
-									while (j < AmmoSlots.Num() && !bIsFind)
-									{
-										if (AmmoSlots[j].WeaponType == myInfo.WeaponType)
-										{
-											if (AmmoSlots[j].Cout > 0)
-											{
-												//WeaponGood, it same weapon do nothing
-											}
-											else
-											{
-												//Not find weapon with amm need init Pistol with infinity ammo
-												UE_LOG(LogTemp, Error, TEXT("UTPSInventoryComponent::SwitchWeaponToIndex - Init PISTOL - NEED"));
-											}
-										}
-										j++;
-									}
-								}
-							}
-						}
-					}
-					Seconditeration++;
-				}
-			}
-		}
-		else
-		{
-			int8 iteration = 0;
-			int8 Seconditeration = WeaponSlots.Num() - 1;
-			while (iteration < WeaponSlots.Num() && !bIsSuccess)
-			{
-				iteration++;
-				int8 tmpIndex = ChangeToIndex - iteration;
-				if (WeaponSlots.IsValidIndex(tmpIndex))
-				{
-					if (!WeaponSlots[tmpIndex].NameItem.IsNone())
-					{
-						if (WeaponSlots[tmpIndex].AdditionalInfo.Round > 0)
-						{
-							//WeaponGood
-							bIsSuccess = true;
-							NewIdWeapon = WeaponSlots[tmpIndex].NameItem;
-							NewAdditionalInfo = WeaponSlots[tmpIndex].AdditionalInfo;
-							NewCurrentIndex = tmpIndex;
-						}
-						else
-						{
-							FWeaponInfos myInfo;
-							UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-							myGI->GetWeaponInfoByName(WeaponSlots[tmpIndex].NameItem, myInfo);
-
-							bool bIsFind = false;
-							int8 j = 0;
-							while (j < AmmoSlots.Num() && !bIsFind)
-							{
-								if (AmmoSlots[j].WeaponType == myInfo.WeaponType && AmmoSlots[j].Cout > 0)
-								{
-									//WeaponGood
-									bIsSuccess = true;
-									NewIdWeapon = WeaponSlots[tmpIndex].NameItem;
-									NewAdditionalInfo = WeaponSlots[tmpIndex].AdditionalInfo;
-									NewCurrentIndex = tmpIndex;
-									bIsFind = true;
-								}
-								j++;
-							}
-						}
-					}
-				}
-				else
-				{
-					//go to end of LEFT of array weapon slots
-					if (OldIndex != Seconditeration)
-					{
-						if (WeaponSlots.IsValidIndex(Seconditeration))
-						{
-							if (!WeaponSlots[Seconditeration].NameItem.IsNone())
-							{
-								if (WeaponSlots[Seconditeration].AdditionalInfo.Round > 0)
-								{
-									//WeaponGood
-									bIsSuccess = true;
-									NewIdWeapon = WeaponSlots[Seconditeration].NameItem;
-									NewAdditionalInfo = WeaponSlots[Seconditeration].AdditionalInfo;
-									NewCurrentIndex = Seconditeration;
-								}
-								else
-								{
-									FWeaponInfos myInfo;
-									UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-									myGI->GetWeaponInfoByName(WeaponSlots[Seconditeration].NameItem, myInfo);
-
-									bool bIsFind = false;
-									int8 j = 0;
-									while (j < AmmoSlots.Num() && !bIsFind)
-									{
-										if (AmmoSlots[j].WeaponType == myInfo.WeaponType && AmmoSlots[j].Cout > 0)
-										{
-											//WeaponGood
-											bIsSuccess = true;
-											NewIdWeapon = WeaponSlots[Seconditeration].NameItem;
-											NewAdditionalInfo = WeaponSlots[Seconditeration].AdditionalInfo;
-											NewCurrentIndex = Seconditeration;
-											bIsFind = true;
-										}
-										j++;
-									}
-								}
-							}
-						}
-					}
-					else
-					{
-						//go to same weapon when start
-						if (WeaponSlots.IsValidIndex(Seconditeration))
-						{
-							if (!WeaponSlots[Seconditeration].NameItem.IsNone())
-							{
-								if (WeaponSlots[Seconditeration].AdditionalInfo.Round > 0)
-								{
-									//WeaponGood, it same weapon do nothing
-								}
-								else
-								{
-									FWeaponInfos myInfo;
-									UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
-
-									myGI->GetWeaponInfoByName(WeaponSlots[Seconditeration].NameItem, myInfo);
-
-									bool bIsFind = false;
-									int8 j = 0;
-									while (j < AmmoSlots.Num() && !bIsFind)
-									{
-										if (AmmoSlots[j].WeaponType == myInfo.WeaponType)
-										{
-											if (AmmoSlots[j].Cout > 0)
-											{
-												//WeaponGood, it same weapon do nothing
-											}
-											else
-											{
-												//Not find weapon with amm need init Pistol with infinity ammo
-												UE_LOG(LogTemp, Error, TEXT("UTPSInventoryComponent::SwitchWeaponToIndex - Init PISTOL - NEED"));
-											}
-										}
-										j++;
-									}
-								}
-							}
-						}
-					}
-					Seconditeration--;
-				}
-			}
-		}
-	}
+	const int32 NewCurrentIndex = InventoryLogic::FindSwitchIndex(WeaponSlots, AmmoSlots, ChangeToIndex, OldIndex, bIsForward, GetWeaponType);
+	const bool bIsSuccess = NewCurrentIndex != INDEX_NONE;
 
 	if (bIsSuccess)
 	{
+		//read the new slot before the old one is written back, they can be the same
+		const FName NewIdWeapon = WeaponSlots[NewCurrentIndex].NameItem;
+		const FAdditionalWeaponInfos NewAdditionalInfo = WeaponSlots[NewCurrentIndex].AdditionalInfo;
 		SetAdditionalInfoWeapon(OldIndex, OldInfo);
 		OnSwitchWeapon.Broadcast(NewIdWeapon, NewAdditionalInfo, NewCurrentIndex);
 		//OnWeaponAmmoAviable.Broadcast()
@@ -451,6 +155,7 @@ FName UTopDownShooterInventorComponent::GetWeaponNameBySlotIndex(int32 indexSlot
 
 void UTopDownShooterInventorComponent::SetAdditionalInfoWeapon(int32 IndexWeapon, FAdditionalWeaponInfos NewInfo)
 {
+	TPS_LLM_SCOPE(Inventory);
 	if (WeaponSlots.IsValidIndex(IndexWeapon))
 	{
 		bool bIsFind = false;
@@ -475,6 +180,7 @@ void UTopDownShooterInventorComponent::SetAdditionalInfoWeapon(int32 IndexWeapon
 
 void UTopDownShooterInventorComponent::AmmoSlotChangeValue(EWeaponType TypeWeapon, int32 CoutChangeAmmo)
 {
+	TPS_LLM_SCOPE(Inventory);
 	bool bIsFind = false;
 	int8 i = 0;
 	while (i < AmmoSlots.Num() && !bIsFind)
@@ -485,6 +191,7 @@ void UTopDownShooterInventorComponent::AmmoSlotChangeValue(EWeaponType TypeWeapo
 			if (AmmoSlots[i].Cout > AmmoSlots[i].MaxCout)
 				AmmoSlots[i].Cout = AmmoSlots[i].MaxCout;
 
+			bPickupEligibilityDirty = true;
 			OnAmmoChange.Broadcast(AmmoSlots[i].WeaponType, AmmoSlots[i].Cout);
 
 			bIsFind = true;
@@ -495,25 +202,11 @@ void UTopDownShooterInventorComponent::AmmoSlotChangeValue(EWeaponType TypeWeapo
 
 bool UTopDownShooterInventorComponent::CheckAmmoForWeapon(EWeaponType TypeWeapon, int8 & AviableAmmoForWeapon)
 {
-	AviableAmmoForWeapon = 0;
-	bool bIsFind = false;
-	int8 i = 0;
-	while (i < AmmoSlots.Num() && !bIsFind)
-	{
-		if (AmmoSlots[i].WeaponType == TypeWeapon)
-		{
-			bIsFind = true;
-			AviableAmmoForWeapon = AmmoSlots[i].Cout;
-			if (AmmoSlots[i].Cout > 0)
-			{
-				//OnWeaponAmmoAviable.Broadcast(TypeWeapon);//remove not here, only when pickUp ammo this type, or swithc weapon
-				return true;
-			}
-
-		}
-
-		i++;
-	}
+	int32 AviableAmmo = 0;
+	const bool bHasAmmo = InventoryLogic::FindAmmoForWeapon(AmmoSlots, TypeWeapon, AviableAmmo);
+	AviableAmmoForWeapon = AviableAmmo;
+	if (bHasAmmo)
+		return true;
 
 	OnWeaponAmmoEmpty.Broadcast(TypeWeapon);//visual empty ammo slot
 
@@ -522,40 +215,27 @@ bool UTopDownShooterInventorComponent::CheckAmmoForWeapon(EWeaponType TypeWeapon
 
 bool UTopDownShooterInventorComponent::CheckCanTakeAmmo(EWeaponType AmmoType)
 {
-	bool result = false;
-	int8 i = 0;
-	while (i < AmmoSlots.Num() && !result)
-	{
-		if (AmmoSlots[i].WeaponType == AmmoType && AmmoSlots[i].Cout < AmmoSlots[i].MaxCout)
-			result = true;
-		i++;
-	}
-	return result;
+	return (InventoryLogic::GetTakeableAmmoMask(AmmoSlots) & (1u << uint32(AmmoType))) != 0;
 }
 
 bool UTopDownShooterInventorComponent::CheckCanTakeWeapon(int32 & FreeSlot)
 {
-	bool bIsFreeSlot = false;
-	int8 i = 0;
-	while (i < WeaponSlots.Num() && !bIsFreeSlot)
-	{
-		if (WeaponSlots[i].NameItem.IsNone())
-		{
-			bIsFreeSlot = true;
-			FreeSlot = i;
-		}
-		i++;
-	}
-	return bIsFreeSlot;
+	const int32 FoundSlot = InventoryLogic::FindFreeWeaponSlot(WeaponSlots);
+	if (FoundSlot == INDEX_NONE)
+		return false;
+	FreeSlot = FoundSlot;
+	return true;
 }
 
 bool UTopDownShooterInventorComponent::SwitchWeaponToInventory(FWeaponSlot NewWeapon, int32 IndexSlot, int32 CurrentIndexWeaponChar, FDropItem & DropItemInfo)
 {
+	TPS_LLM_SCOPE(Inventory);
 	bool result = false;
 
 	if (WeaponSlots.IsValidIndex(IndexSlot) && GetDropItemInfoFromInventory(IndexSlot, DropItemInfo))
 	{
 		WeaponSlots[IndexSlot] = NewWeapon;
+		bPickupEligibilityDirty = true;
 
 		SwitchWeaponToIndex(CurrentIndexWeaponChar, -1, NewWeapon.AdditionalInfo, true);
 
@@ -567,12 +247,14 @@ bool UTopDownShooterInventorComponent::SwitchWeaponToInventory(FWeaponSlot NewWe
 
 bool UTopDownShooterInventorComponent::TryGetWeaponToInventory(FWeaponSlot NewWeapon)
 {
+	TPS_LLM_SCOPE(Inventory);
 	int32 indexSlot = -1;
 	if (CheckCanTakeWeapon(indexSlot))
 	{
 		if (WeaponSlots.IsValidIndex(indexSlot))
 		{
 			WeaponSlots[indexSlot] = NewWeapon;
+			bPickupEligibilityDirty = true;
 
 			OnUpdateWeaponSlots.Broadcast(indexSlot, NewWeapon);
 			return true;
@@ -602,15 +284,14 @@ bool UTopDownShooterInventorComponent::GetDropItemInfoFromInventory(int32 IndexS
 
 #pragma optimize ("", on)
 
-
-
-
-
-
-
-
-
-
-
-
-
+void UTopDownShooterInventorComponent::GetPickupEligibility(uint32& OutAmmoMask, int32& OutFreeWeaponSlot)
+{
+	if (bPickupEligibilityDirty)
+	{
+		TakeableAmmoMask = InventoryLogic::GetTakeableAmmoMask(AmmoSlots);
+		FreeWeaponSlot = InventoryLogic::FindFreeWeaponSlot(WeaponSlots);
+		bPickupEligibilityDirty = false;
+	}
+	OutAmmoMask = TakeableAmmoMask;
+	OutFreeWeaponSlot = FreeWeaponSlot;
+}
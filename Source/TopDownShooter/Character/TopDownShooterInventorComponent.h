@@ -75,5 +75,15 @@ public:
 
 	UFUNCTION(BlueprintCallable, Category = "Interface")
 	bool GetDropItemInfoFromInventory(int32 IndexSlot, FDropItem &DropItemInfo);
-		
+
+	//what pickups can give (ammo types not full as bits, first free weapon slot), cached until the slots change
+	//through the functions above, direct writes to the slot arrays need MarkPickupEligibilityDirty
+	void GetPickupEligibility(uint32& OutAmmoMask, int32& OutFreeWeaponSlot);
+	UFUNCTION(BlueprintCallable, Category = "Interface")
+	void MarkPickupEligibilityDirty() { bPickupEligibilityDirty = true; }
+
+private:
+	bool bPickupEligibilityDirty = true;
+	uint32 TakeableAmmoMask = 0;
+	int32 FreeWeaponSlot = INDEX_NONE;
 };
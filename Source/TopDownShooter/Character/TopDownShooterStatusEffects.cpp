@@ -0,0 +1,219 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterStatusEffects.h"
+#include "Character/TopDownShooterCharacter.h"
+#include "Kismet/GameplayStatics.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Status Effects"), STAT_TPS_StatusEffects, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Status Effects Active"), STAT_TPS_StatusEffectsActive, STATGROUP_TopDownShooter);
+
+static bool StatusEventEarlier(const FStatusEffectEvent& A, const FStatusEffectEvent& B)
+{
+	return A.Time < B.Time;
+}
+
+void UTopDownShooterStatusEffects::Deinitialize()
+{
+	Effects.Empty();
+	EventHeap.Empty();
+	Targets.Empty();
+	PendingDamage.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterStatusEffects::IsTickable() const
+{
+	return EventHeap.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UTopDownShooterStatusEffects::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterStatusEffects, STATGROUP_Tickables);
+}
+
+int32 UTopDownShooterStatusEffects::ApplyStatusEffect(AActor* Target, const FStatusEffectInfos& Infos, AController* EventInstigator)
+{
+	if (!Target || Target->IsPendingKill() || Infos.Duration <= 0.0f)
+		return 0;
+	//effects run where damage is authoritative, the owning client gets the modifiers replicated on its character
+	if (GetWorld()->GetNetMode() == NM_Client)
+		return 0;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const bool bPeriodic = Infos.DamagePerTick != 0.0f && Infos.TickInterval > 0.0f;
+	const TWeakObjectPtr<AActor> TargetKey(Target);
+	FStatusEffectTarget& myTarget = Targets.FindOrAdd(TargetKey);
+
+	//same tag again (another bullet of the flamethrower) only refreshes the running effect
+	if (Infos.Tag != NAME_None)
+	{
+		for (uint32 Id : myTarget.EffectIds)
+		{
+			FActiveStatusEffect& Effect = Effects[Id];
+			if (Effect.Infos.Tag != Infos.Tag)
+				continue;
+
+			const bool bWasPeriodic = Effect.NextTickTime < MAX_flt;
+			Effect.Infos = Infos;
+			Effect.Instigator = EventInstigator;
+			Effect.ExpireTime = Now + Infos.Duration;
+			if (!bPeriodic)
+				Effect.NextTickTime = MAX_flt;
+			else if (!bWasPeriodic)
+				Effect.NextTickTime = Now + Infos.TickInterval;
+			Schedule(Id, Effect);
+			UpdateTarget(TargetKey);
+			return int32(Id);
+		}
+	}
+
+	const uint32 Id = NextEffectId++;
+	if (NextEffectId > uint32(MAX_int32))
+		NextEffectId = 1;
+
+	FActiveStatusEffect& Effect = Effects.Add(Id);
+	Effect.Infos = Infos;
+	Effect.Target = Target;
+	Effect.Instigator = EventInstigator;
+	Effect.ExpireTime = Now + Infos.Duration;
+	Effect.NextTickTime = bPeriodic ? Now + Infos.TickInterval : MAX_flt;
+	myTarget.EffectIds.Add(Id);
+	Schedule(Id, Effect);
+	UpdateTarget(TargetKey);
+
+	return int32(Id);
+}
+
+void UTopDownShooterStatusEffects::RemoveStatusEffect(int32 EffectId)
+{
+	if (EffectId > 0)
+		RemoveEffect(uint32(EffectId));
+}
+
+void UTopDownShooterStatusEffects::RemoveAllStatusEffects(AActor* Target)
+{
+	const TWeakObjectPtr<AActor> TargetKey(Target);
+	FStatusEffectTarget* myTarget = Targets.Find(TargetKey);
+	if (!myTarget)
+		return;
+
+	//stale heap entries of these effects find nothing and are skipped
+	for (uint32 Id : myTarget->EffectIds)
+		Effects.Remove(Id);
+	myTarget->EffectIds.Reset();
+	UpdateTarget(TargetKey);
+}
+
+FStatusEffectModifiers UTopDownShooterStatusEffects::GetModifiers(const AActor* Target) const
+{
+	const FStatusEffectTarget* myTarget = Targets.Find(TWeakObjectPtr<AActor>(const_cast<AActor*>(Target)));
+	return myTarget ? myTarget->Modifiers : FStatusEffectModifiers();
+}
+
+void UTopDownShooterStatusEffects::Schedule(uint32 EffectId, FActiveStatusEffect& Effect)
+{
+	//a refreshed effect leaves its old entry behind, it no longer matches NextEventTime when popped
+	Effect.NextEventTime = FMath::Min(Effect.ExpireTime, Effect.NextTickTime);
+	FStatusEffectEvent Event;
+	Event.Time = Effect.NextEventTime;
+	Event.EffectId = EffectId;
+	EventHeap.HeapPush(Event, StatusEventEarlier);
+}
+
+void UTopDownShooterStatusEffects::RemoveEffect(uint32 EffectId)
+{
+	FActiveStatusEffect Effect;
+	if (!Effects.RemoveAndCopyValue(EffectId, Effect))
+		return;
+
+	if (FStatusEffectTarget* myTarget = Targets.Find(Effect.Target))
+		myTarget->EffectIds.RemoveSingleSwap(EffectId, false);
+	UpdateTarget(Effect.Target);
+}
+
+void UTopDownShooterStatusEffects::UpdateTarget(const TWeakObjectPtr<AActor>& Target)
+{
+	FStatusEffectTarget* myTarget = Targets.Find(Target);
+	if (!myTarget)
+		return;
+
+	FStatusEffectModifiers Modifiers;
+	for (uint32 Id : myTarget->EffectIds)
+	{
+		const FStatusEffectInfos& Infos = Effects[Id].Infos;
+		Modifiers.MoveSpeed *= Infos.MoveSpeedMultiplier;
+		Modifiers.FireInterval *= Infos.FireIntervalMultiplier;
+		Modifiers.Dispersion *= Infos.DispersionMultiplier;
+	}
+
+	const bool bChanged = Modifiers.MoveSpeed != myTarget->Modifiers.MoveSpeed || Modifiers.FireInterval != myTarget->Modifiers.FireInterval || Modifiers.Dispersion != myTarget->Modifiers.Dispersion;
+	if (myTarget->EffectIds.Num() == 0)
+		Targets.Remove(Target);
+	else
+		myTarget->Modifiers = Modifiers;
+
+	if (bChanged)
+	{
+		if (ATopDownShooterCharacter* myCharacter = Cast<ATopDownShooterCharacter>(Target.Get()))
+			myCharacter->SetStatusModifiers(Modifiers);
+	}
+}
+
+void UTopDownShooterStatusEffects::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_StatusEffects);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, StatusEffects);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	PendingDamage.Reset();
+	while (EventHeap.Num() > 0 && EventHeap.HeapTop().Time <= Now)
+	{
+		FStatusEffectEvent Event;
+		EventHeap.HeapPop(Event, StatusEventEarlier, false);
+
+		FActiveStatusEffect* Effect = Effects.Find(Event.EffectId);
+		if (!Effect || Effect->NextEventTime != Event.Time)
+			continue;
+		if (!Effect->Target.IsValid())
+		{
+			RemoveEffect(Event.EffectId);
+			continue;
+		}
+
+		//a hitch may owe several periodic ticks, they are summed into one ApplyDamage
+		float Damage = 0.0f;
+		const float LastTickTime = FMath::Min(Now, Effect->ExpireTime);
+		while (Effect->NextTickTime <= LastTickTime)
+		{
+			Damage += Effect->Infos.DamagePerTick;
+			Effect->NextTickTime += Effect->Infos.TickInterval;
+		}
+		if (Damage != 0.0f)
+		{
+			PendingDamage.AddDefaulted();
+			FStatusEffectDamage& myDamage = PendingDamage.Last();
+			myDamage.Target = Effect->Target;
+			myDamage.Damage = Damage;
+			myDamage.Instigator = Effect->Instigator;
+		}
+
+		if (Effect->ExpireTime <= Now)
+			RemoveEffect(Event.EffectId);
+		else
+			Schedule(Event.EffectId, *Effect);
+	}
+
+	//damage handlers may apply or remove effects, the heap is consistent by now
+	for (const FStatusEffectDamage& myDamage : PendingDamage)
+	{
+		if (AActor* myTarget = myDamage.Target.Get())
+			UGameplayStatics::ApplyDamage(myTarget, myDamage.Damage, myDamage.Instigator.Get(), nullptr, nullptr);
+	}
+	PendingDamage.Reset();
+
+	SET_DWORD_STAT(STAT_TPS_StatusEffectsActive, Effects.Num());
+}
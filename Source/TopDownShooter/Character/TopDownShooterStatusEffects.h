@@ -0,0 +1,90 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FuncLibrary/Types.h"
+#include "TopDownShooterStatusEffects.generated.h"
+
+struct FActiveStatusEffect
+{
+	FStatusEffectInfos Infos;
+	TWeakObjectPtr<AActor> Target;
+	TWeakObjectPtr<AController> Instigator;
+	float ExpireTime = 0.0f;
+	float NextTickTime = 0.0f;
+	//time of the heap entry that is current for this effect, older entries are skipped
+	float NextEventTime = 0.0f;
+};
+
+//Heap entry, the effect is due at Time
+struct FStatusEffectEvent
+{
+	float Time = 0.0f;
+	uint32 EffectId = 0;
+};
+
+//Periodic damage owed by one effect this frame
+struct FStatusEffectDamage
+{
+	TWeakObjectPtr<AActor> Target;
+	float Damage = 0.0f;
+	TWeakObjectPtr<AController> Instigator;
+};
+
+//Effects on one actor and the modifiers they add up to
+struct FStatusEffectTarget
+{
+	TArray<uint32> EffectIds;
+	FStatusEffectModifiers Modifiers;
+};
+
+/**
+ * All burning, poison, slow... effects of the world. Every effect has one entry in a min-heap keyed by the
+ * time of its next periodic damage or its expiration, each frame only the entries that are due get popped.
+ * Modifiers are recomputed when an effect starts or ends and pushed to ATopDownShooterCharacter (speed, weapon stats),
+ * which replicates them to its owning client. Nothing runs on clients.
+ * Periodic damage goes through ApplyDamage, so it lands in UTopDownShooterHealthTable like any other hit.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterStatusEffects : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//returns the effect id, 0 when nothing was applied; a tagged effect already on Target is refreshed and keeps its id
+	UFUNCTION(BlueprintCallable, Category = "StatusEffect")
+	int32 ApplyStatusEffect(AActor* Target, const FStatusEffectInfos& Infos, AController* EventInstigator);
+	UFUNCTION(BlueprintCallable, Category = "StatusEffect")
+	void RemoveStatusEffect(int32 EffectId);
+	UFUNCTION(BlueprintCallable, Category = "StatusEffect")
+	void RemoveAllStatusEffects(AActor* Target);
+
+	UFUNCTION(BlueprintCallable, Category = "StatusEffect")
+	FStatusEffectModifiers GetModifiers(const AActor* Target) const;
+	UFUNCTION(BlueprintCallable, Category = "StatusEffect")
+	int32 GetNumEffects() const { return Effects.Num(); }
+
+private:
+	void Schedule(uint32 EffectId, FActiveStatusEffect& Effect);
+	void RemoveEffect(uint32 EffectId);
+	void UpdateTarget(const TWeakObjectPtr<AActor>& Target);
+
+	TMap<uint32, FActiveStatusEffect> Effects;
+	TArray<FStatusEffectEvent> EventHeap;
+	TMap<TWeakObjectPtr<AActor>, FStatusEffectTarget> Targets;
+	uint32 NextEffectId = 1;
+
+	//scratch, periodic damage of this frame is applied after the heap is walked
+	TArray<FStatusEffectDamage> PendingDamage;
+};
@@ -0,0 +1,208 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CapsuleRaycast.h"
+#include "Math/VectorRegister.h"
+
+void FCapsuleSoA::Reset()
+{
+	NumCapsules = 0;
+	AX.Reset();
+	AY.Reset();
+	AZ.Reset();
+	EX.Reset();
+	EY.Reset();
+	EZ.Reset();
+	Radius.Reset();
+}
+
+int32 FCapsuleSoA::Add(const FVector& Center, const FVector& Up, float HalfHeight, float InRadius)
+{
+	if (NumCapsules == Radius.Num())
+	{
+		//grow by one SIMD lane group, new lanes are padding until written
+		AX.AddZeroed(4);
+		AY.AddZeroed(4);
+		AZ.AddZeroed(4);
+		EX.AddZeroed(4);
+		EY.AddZeroed(4);
+		EZ.AddZeroed(4);
+		for (int8 i = 0; i < 4; i++)
+		{
+			Radius.Add(-1.0f);
+		}
+	}
+
+	const float SegmentHalfLength = FMath::Max(HalfHeight - InRadius, 0.0f);
+	const FVector SegmentStart = Center - Up * SegmentHalfLength;
+	const FVector SegmentAxis = Up * (SegmentHalfLength * 2.0f);
+
+	const int32 Index = NumCapsules;
+	AX[Index] = SegmentStart.X;
+	AY[Index] = SegmentStart.Y;
+	AZ[Index] = SegmentStart.Z;
+	EX[Index] = SegmentAxis.X;
+	EY[Index] = SegmentAxis.Y;
+	EZ[Index] = SegmentAxis.Z;
+	Radius[Index] = InRadius;
+
+	NumCapsules++;
+	return Index;
+}
+
+void FCapsuleSoA::InitPadding(int32 NumLanes)
+{
+	check(NumLanes % 4 == 0);
+	NumCapsules = NumLanes;
+	AX.Reset(NumLanes);
+	AY.Reset(NumLanes);
+	AZ.Reset(NumLanes);
+	EX.Reset(NumLanes);
+	EY.Reset(NumLanes);
+	EZ.Reset(NumLanes);
+	Radius.Reset(NumLanes);
+	AX.AddZeroed(NumLanes);
+	AY.AddZeroed(NumLanes);
+	AZ.AddZeroed(NumLanes);
+	EX.AddZeroed(NumLanes);
+	EY.AddZeroed(NumLanes);
+	EZ.AddZeroed(NumLanes);
+	Radius.Init(-1.0f, NumLanes);
+}
+
+void FCapsuleSoA::SetSegment(int32 Index, const FVector& SegmentStart, const FVector& SegmentAxis, float InRadius)
+{
+	AX[Index] = SegmentStart.X;
+	AY[Index] = SegmentStart.Y;
+	AZ[Index] = SegmentStart.Z;
+	EX[Index] = SegmentAxis.X;
+	EY[Index] = SegmentAxis.Y;
+	EZ[Index] = SegmentAxis.Z;
+	Radius[Index] = InRadius;
+}
+
+namespace CapsuleRaycast
+{
+	FORCEINLINE VectorRegister Dot3SoA(const VectorRegister& X1, const VectorRegister& Y1, const VectorRegister& Z1, const VectorRegister& X2, const VectorRegister& Y2, const VectorRegister& Z2)
+	{
+		return VectorMultiplyAdd(X1, X2, VectorMultiplyAdd(Y1, Y2, VectorMultiply(Z1, Z2)));
+	}
+
+	FORCEINLINE VectorRegister Clamp01(const VectorRegister& V)
+	{
+		return VectorMin(VectorMax(V, VectorZero()), VectorOne());
+	}
+
+	bool RaycastNearest(const FCapsuleSoA& Capsules, const FVector& Start, const FVector& End, int32& OutIndex, float& OutTime)
+	{
+		return RaycastNearestInRange(Capsules, 0, Capsules.NumPadded(), Start, End, 0.0f, [](int32 Lane) { return false; }, OutIndex, OutTime);
+	}
+
+	bool RaycastNearestInRange(const FCapsuleSoA& Capsules, int32 FirstLane, int32 NumLanes, const FVector& Start, const FVector& End, float InflateRadius,
+		TFunctionRef<bool(int32 Lane)> IgnoreLane, int32& OutIndex, float& OutTime)
+	{
+		OutIndex = INDEX_NONE;
+		OutTime = 1.0f;
+
+		const FVector Dir = End - Start;
+		const float DirSizeSquared = Dir.SizeSquared();
+		if (NumLanes <= 0 || DirSizeSquared < KINDA_SMALL_NUMBER)
+			return false;
+		checkSlow(FirstLane % 4 == 0 && NumLanes % 4 == 0 && FirstLane + NumLanes <= Capsules.NumPadded());
+
+		//closest points between ray segment S + D*s and capsule segment A + E*t (Ericson, Real-Time Collision Detection 5.1.9)
+		const VectorRegister SX = VectorSetFloat1(Start.X);
+		const VectorRegister SY = VectorSetFloat1(Start.Y);
+		const VectorRegister SZ = VectorSetFloat1(Start.Z);
+		const VectorRegister DX = VectorSetFloat1(Dir.X);
+		const VectorRegister DY = VectorSetFloat1(Dir.Y);
+		const VectorRegister DZ = VectorSetFloat1(Dir.Z);
+		const VectorRegister A = VectorSetFloat1(DirSizeSquared);
+		const VectorRegister Epsilon = VectorSetFloat1(KINDA_SMALL_NUMBER);
+		const VectorRegister Inflate = VectorSetFloat1(InflateRadius);
+
+		float BestTime = 1.0f;
+		int32 BestIndex = INDEX_NONE;
+
+		MS_ALIGN(16) float LaneS[4] GCC_ALIGN(16);
+		MS_ALIGN(16) float LaneDistSquared[4] GCC_ALIGN(16);
+
+		for (int32 Base = FirstLane; Base < FirstLane + NumLanes; Base += 4)
+		{
+			const VectorRegister CapAX = VectorLoadAligned(&Capsules.AX[Base]);
+			const VectorRegister CapAY = VectorLoadAligned(&Capsules.AY[Base]);
+			const VectorRegister CapAZ = VectorLoadAligned(&Capsules.AZ[Base]);
+			const VectorRegister CapEX = VectorLoadAligned(&Capsules.EX[Base]);
+			const VectorRegister CapEY = VectorLoadAligned(&Capsules.EY[Base]);
+			const VectorRegister CapEZ = VectorLoadAligned(&Capsules.EZ[Base]);
+			const VectorRegister PaddedR = VectorLoadAligned(&Capsules.Radius[Base]);
+			const VectorRegister CapR = VectorAdd(PaddedR, Inflate);
+
+			const VectorRegister RX = VectorSubtract(SX, CapAX);
+			const VectorRegister RY = VectorSubtract(SY, CapAY);
+			const VectorRegister RZ = VectorSubtract(SZ, CapAZ);
+
+			const VectorRegister E = VectorMax(Dot3SoA(CapEX, CapEY, CapEZ, CapEX, CapEY, CapEZ), Epsilon);
+			const VectorRegister B = Dot3SoA(DX, DY, DZ, CapEX, CapEY, CapEZ);
+			const VectorRegister C = Dot3SoA(DX, DY, DZ, RX, RY, RZ);
+			const VectorRegister F = Dot3SoA(CapEX, CapEY, CapEZ, RX, RY, RZ);
+
+			//s on the infinite lines, 0 when segments are parallel
+			const VectorRegister Denom = VectorSubtract(VectorMultiply(A, E), VectorMultiply(B, B));
+			const VectorRegister NotParallel = VectorCompareGT(Denom, Epsilon);
+			VectorRegister S = VectorDivide(VectorSubtract(VectorMultiply(B, F), VectorMultiply(C, E)), VectorMax(Denom, Epsilon));
+			S = Clamp01(VectorSelect(NotParallel, S, VectorZero()));
+
+			//t for that s, when it leaves the capsule segment clamp it and recompute s
+			const VectorRegister T = VectorDivide(VectorMultiplyAdd(B, S, F), E);
+			const VectorRegister TClamped = Clamp01(T);
+			const VectorRegister SFromT = Clamp01(VectorDivide(VectorSubtract(VectorMultiply(B, TClamped), C), A));
+			S = VectorSelect(VectorCompareNE(T, TClamped), SFromT, S);
+
+			//R + D*s - E*t
+			const VectorRegister CX = VectorSubtract(VectorMultiplyAdd(DX, S, RX), VectorMultiply(CapEX, TClamped));
+			const VectorRegister CY = VectorSubtract(VectorMultiplyAdd(DY, S, RY), VectorMultiply(CapEY, TClamped));
+			const VectorRegister CZ = VectorSubtract(VectorMultiplyAdd(DZ, S, RZ), VectorMultiply(CapEZ, TClamped));
+			const VectorRegister DistSquared = Dot3SoA(CX, CY, CZ, CX, CY, CZ);
+
+			const VectorRegister HitMask = VectorBitwiseAnd(VectorCompareLE(DistSquared, VectorMultiply(CapR, CapR)), VectorCompareGE(PaddedR, VectorZero()));
+			const int32 Mask = VectorMaskBits(HitMask);
+			if (Mask)
+			{
+				VectorStoreAligned(S, LaneS);
+				VectorStoreAligned(DistSquared, LaneDistSquared);
+				for (int32 Lane = 0; Lane < 4; Lane++)
+				{
+					if ((Mask & (1 << Lane)) && !IgnoreLane(Base + Lane))
+					{
+						//step back from the closest approach to the surface entry
+						const float CapRadius = Capsules.Radius[Base + Lane] + InflateRadius;
+						const float Entry = FMath::Max(LaneS[Lane] - FMath::Sqrt((CapRadius * CapRadius - LaneDistSquared[Lane]) / DirSizeSquared), 0.0f);
+						if (BestIndex == INDEX_NONE || Entry < BestTime)
+						{
+							BestTime = Entry;
+							BestIndex = Base + Lane;
+						}
+					}
+				}
+			}
+		}
+
+		OutIndex = BestIndex;
+		OutTime = BestTime;
+		return BestIndex != INDEX_NONE;
+	}
+
+	FVector GetSurfaceNormal(const FCapsuleSoA& Capsules, int32 Index, const FVector& Point)
+	{
+		const FVector SegmentStart = Capsules.GetSegmentStart(Index);
+		const FVector SegmentAxis = Capsules.GetSegmentAxis(Index);
+		const float AxisSizeSquared = SegmentAxis.SizeSquared();
+
+		float T = 0.0f;
+		if (AxisSizeSquared > KINDA_SMALL_NUMBER)
+			T = FMath::Clamp(FVector::DotProduct(Point - SegmentStart, SegmentAxis) / AxisSizeSquared, 0.0f, 1.0f);
+
+		return (Point - (SegmentStart + SegmentAxis * T)).GetSafeNormal();
+	}
+}
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+
+//Capsules kept as structure of arrays so ray tests run 4 capsules per SIMD register
+struct TOPDOWNSHOOTER_API FCapsuleSoA
+{
+	void Reset();
+
+	//Returns index of the new capsule
+	int32 Add(const FVector& Center, const FVector& Up, float HalfHeight, float Radius);
+
+	//NumLanes slots (multiple of 4) that are all padding until written with SetSegment
+	void InitPadding(int32 NumLanes);
+	void SetSegment(int32 Index, const FVector& SegmentStart, const FVector& SegmentAxis, float InRadius);
+
+	int32 Num() const { return NumCapsules; }
+	//Arrays are padded to a multiple of 4, padding has Radius < 0 and never hits
+	int32 NumPadded() const { return Radius.Num(); }
+
+	FVector GetSegmentStart(int32 Index) const { return FVector(AX[Index], AY[Index], AZ[Index]); }
+	FVector GetSegmentAxis(int32 Index) const { return FVector(EX[Index], EY[Index], EZ[Index]); }
+	FVector GetCenter(int32 Index) const { return GetSegmentStart(Index) + GetSegmentAxis(Index) * 0.5f; }
+
+	//Segment start (bottom sphere center), segment axis (bottom -> top sphere center), radius
+	TArray<float, TAlignedHeapAllocator<16>> AX;
+	TArray<float, TAlignedHeapAllocator<16>> AY;
+	TArray<float, TAlignedHeapAllocator<16>> AZ;
+	TArray<float, TAlignedHeapAllocator<16>> EX;
+	TArray<float, TAlignedHeapAllocator<16>> EY;
+	TArray<float, TAlignedHeapAllocator<16>> EZ;
+	TArray<float, TAlignedHeapAllocator<16>> Radius;
+
+private:
+	int32 NumCapsules = 0;
+};
+
+namespace CapsuleRaycast
+{
+	//Nearest capsule hit by segment Start -> End. OutTime is the entry point as a 0..1 fraction of the segment
+	TOPDOWNSHOOTER_API bool RaycastNearest(const FCapsuleSoA& Capsules, const FVector& Start, const FVector& End, int32& OutIndex, float& OutTime);
+
+	//Same for the lanes FirstLane .. FirstLane + NumLanes (both multiples of 4), capsules grown by InflateRadius so a sphere
+	//sweep can be tested like a ray. IgnoreLane is asked only for lanes that hit
+	TOPDOWNSHOOTER_API bool RaycastNearestInRange(const FCapsuleSoA& Capsules, int32 FirstLane, int32 NumLanes, const FVector& Start, const FVector& End, float InflateRadius,
+		TFunctionRef<bool(int32 Lane)> IgnoreLane, int32& OutIndex, float& OutTime);
+
+	//Outward normal of capsule Index at a point on (or near) its surface
+	TOPDOWNSHOOTER_API FVector GetSurfaceNormal(const FCapsuleSoA& Capsules, int32 Index, const FVector& Point);
+}
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CapsuleSpatialHash.h"
+
+void FCapsuleSpatialHash::Reset()
+{
+	Entries.Reset();
+	EntryCapsule.Reset();
+	BucketStart.Reset();
+	BucketMask = 0;
+}
+
+void FCapsuleSpatialHash::Build(const FCapsuleSoA& Capsules, float InCellSize, float InMaxInflate)
+{
+	CellSize = FMath::Max(InCellSize, 1.0f);
+	InvCellSize = 1.0f / CellSize;
+	MaxInflate = FMath::Max(InMaxInflate, 0.0f);
+
+	const int32 NumCapsules = Capsules.Num();
+	const int32 NumBuckets = int32(FMath::RoundUpToPowerOfTwo(uint32(FMath::Max(NumCapsules * 2, 16))));
+	BucketMask = uint32(NumBuckets - 1);
+
+	//cell range (inclusive) of every capsule, grown so sphere sweeps up to MaxInflate find it too
+	BucketFill.Reset();
+	BucketFill.AddZeroed(NumBuckets);
+	CapsuleCells.Reset(NumCapsules);
+	for (int32 i = 0; i < NumCapsules; i++)
+	{
+		const float CapRadius = Capsules.Radius[i];
+		if (CapRadius < 0.0f)
+		{
+			CapsuleCells.Add(FIntRect(0, 0, -1, -1));
+			continue;
+		}
+
+		const FVector A = Capsules.GetSegmentStart(i);
+		const FVector B = A + Capsules.GetSegmentAxis(i);
+		const float Grow = CapRadius + MaxInflate;
+		const FIntRect Cells(GetCell(FMath::Min(A.X, B.X) - Grow), GetCell(FMath::Min(A.Y, B.Y) - Grow), GetCell(FMath::Max(A.X, B.X) + Grow), GetCell(FMath::Max(A.Y, B.Y) + Grow));
+		CapsuleCells.Add(Cells);
+
+		for (int32 CellY = Cells.Min.Y; CellY <= Cells.Max.Y; CellY++)
+		{
+			for (int32 CellX = Cells.Min.X; CellX <= Cells.Max.X; CellX++)
+				BucketFill[GetBucket(CellX, CellY)]++;
+		}
+	}
+
+	//bucket runs padded to whole SIMD lane groups, BucketFill becomes the write cursor
+	BucketStart.SetNumUninitialized(NumBuckets + 1, false);
+	BucketStart[0] = 0;
+	for (int32 Bucket = 0; Bucket < NumBuckets; Bucket++)
+	{
+		BucketStart[Bucket + 1] = BucketStart[Bucket] + Align(BucketFill[Bucket], 4);
+		BucketFill[Bucket] = BucketStart[Bucket];
+	}
+
+	const int32 NumLanes = BucketStart[NumBuckets];
+	Entries.InitPadding(NumLanes);
+	EntryCapsule.Init(INDEX_NONE, NumLanes);
+
+	for (int32 i = 0; i < NumCapsules; i++)
+	{
+		const FIntRect& Cells = CapsuleCells[i];
+		for (int32 CellY = Cells.Min.Y; CellY <= Cells.Max.Y; CellY++)
+		{
+			for (int32 CellX = Cells.Min.X; CellX <= Cells.Max.X; CellX++)
+			{
+				const int32 Lane = BucketFill[GetBucket(CellX, CellY)]++;
+				Entries.SetSegment(Lane, Capsules.GetSegmentStart(i), Capsules.GetSegmentAxis(i), Capsules.Radius[i]);
+				EntryCapsule[Lane] = i;
+			}
+		}
+	}
+}
+
+bool FCapsuleSpatialHash::RaycastNearest(const FVector& Start, const FVector& End, float InflateRadius, TFunctionRef<bool(int32 CapsuleIndex)> IgnoreCapsule, int32& OutIndex, float& OutTime) const
+{
+	OutIndex = INDEX_NONE;
+	OutTime = 1.0f;
+	if (Entries.NumPadded() == 0)
+		return false;
+
+	InflateRadius = FMath::Clamp(InflateRadius, 0.0f, MaxInflate);
+	const FVector Dir = End - Start;
+
+	//2D DDA over the cells the segment crosses (Amanatides & Woo), times are fractions of the segment
+	int32 CellX = GetCell(Start.X);
+	int32 CellY = GetCell(Start.Y);
+	const int32 StepX = Dir.X > 0.0f ? 1 : (Dir.X < 0.0f ? -1 : 0);
+	const int32 StepY = Dir.Y > 0.0f ? 1 : (Dir.Y < 0.0f ? -1 : 0);
+	float TMaxX = StepX > 0 ? ((CellX + 1) * CellSize - Start.X) / Dir.X : (StepX < 0 ? (CellX * CellSize - Start.X) / Dir.X : BIG_NUMBER);
+	float TMaxY = StepY > 0 ? ((CellY + 1) * CellSize - Start.Y) / Dir.Y : (StepY < 0 ? (CellY * CellSize - Start.Y) / Dir.Y : BIG_NUMBER);
+	const float TDeltaX = StepX != 0 ? CellSize / FMath::Abs(Dir.X) : BIG_NUMBER;
+	const float TDeltaY = StepY != 0 ? CellSize / FMath::Abs(Dir.Y) : BIG_NUMBER;
+	const int32 NumCells = FMath::Abs(GetCell(End.X) - CellX) + FMath::Abs(GetCell(End.Y) - CellY) + 1;
+
+	auto IgnoreLane = [this, &IgnoreCapsule](int32 Lane) { return IgnoreCapsule(EntryCapsule[Lane]); };
+
+	int32 BestIndex = INDEX_NONE;
+	float BestTime = 1.0f;
+	for (int32 Step = 0; Step < NumCells; Step++)
+	{
+		const uint32 Bucket = GetBucket(CellX, CellY);
+		const int32 FirstLane = BucketStart[Bucket];
+		const int32 NumLanes = BucketStart[Bucket + 1] - FirstLane;
+
+		int32 HitLane = INDEX_NONE;
+		float HitTime = 1.0f;
+		if (NumLanes > 0 && CapsuleRaycast::RaycastNearestInRange(Entries, FirstLane, NumLanes, Start, End, InflateRadius, IgnoreLane, HitLane, HitTime)
+			&& (BestIndex == INDEX_NONE || HitTime < BestTime))
+		{
+			BestIndex = EntryCapsule[HitLane];
+			BestTime = HitTime;
+		}
+
+		//any hit before the segment leaves this cell lies in a cell already tested
+		const float TExit = FMath::Min3(TMaxX, TMaxY, 1.0f);
+		if (BestIndex != INDEX_NONE && BestTime <= TExit)
+			break;
+
+		if (TMaxX < TMaxY)
+		{
+			CellX += StepX;
+			TMaxX += TDeltaX;
+		}
+		else
+		{
+			CellY += StepY;
+			TMaxY += TDeltaY;
+		}
+	}
+
+	OutIndex = BestIndex;
+	OutTime = BestTime;
+	return BestIndex != INDEX_NONE;
+}
@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FuncLibrary/CapsuleRaycast.h"
+
+/**
+ * Uniform grid over XY for capsules, hashed into a power of two bucket table so the map size does not matter.
+ * Every capsule is copied into each bucket its XY bounds touch, buckets are contiguous SIMD runs of FCapsuleSoA lanes.
+ * Queries walk the cells along the segment and stop at the first cell that already holds the nearest hit.
+ * Build is single threaded, queries only read and can run from several threads.
+ */
+struct TOPDOWNSHOOTER_API FCapsuleSpatialHash
+{
+	//MaxInflate is the biggest sphere radius a query may sweep with
+	void Build(const FCapsuleSoA& Capsules, float InCellSize, float InMaxInflate);
+	void Reset();
+
+	//Nearest capsule hit by a sphere of InflateRadius (0 for a ray, at most MaxInflate) moving Start -> End.
+	//OutIndex is the index in the capsules given to Build, OutTime the 0..1 fraction of the segment
+	bool RaycastNearest(const FVector& Start, const FVector& End, float InflateRadius, TFunctionRef<bool(int32 CapsuleIndex)> IgnoreCapsule, int32& OutIndex, float& OutTime) const;
+
+	int32 NumEntries() const { return Entries.NumPadded(); }
+	float GetMaxInflate() const { return MaxInflate; }
+
+private:
+	uint32 GetBucket(int32 CellX, int32 CellY) const { return ((uint32(CellX) * 73856093u) ^ (uint32(CellY) * 19349663u)) & BucketMask; }
+	int32 GetCell(float Coord) const { return FMath::FloorToInt(Coord * InvCellSize); }
+
+	//capsule copies grouped by bucket, each bucket padded to a multiple of 4 lanes
+	FCapsuleSoA Entries;
+	TArray<int32> EntryCapsule;
+	//NumBuckets + 1 offsets into Entries
+	TArray<int32> BucketStart;
+	uint32 BucketMask = 0;
+
+	float CellSize = 1.0f;
+	float InvCellSize = 1.0f;
+	float MaxInflate = 0.0f;
+
+	//build scratch
+	TArray<FIntRect> CapsuleCells;
+	TArray<int32> BucketFill;
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CosmeticLibrary.h"
+#include "Kismet/GameplayStatics.h"
+#include "Components/AudioComponent.h"
+#include "Components/DecalComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "Game/TopDownShooterSpawnQueue.h"
+#include "TopDownShooterMemory.h"
+
+bool UCosmeticLibrary::ShouldPlayCosmetics(const UObject* WorldContextObject)
+{
+#if UE_SERVER
+	return false;
+#else
+	const UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	return World && World->GetNetMode() != NM_DedicatedServer;
+#endif
+}
+
+UAudioComponent* UCosmeticLibrary::SpawnSoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, FVector Location)
+{
+	if (!Sound || !ShouldPlayCosmetics(WorldContextObject))
+		return nullptr;
+
+	return UGameplayStatics::SpawnSoundAtLocation(WorldContextObject, Sound, Location);
+}
+
+void UCosmeticLibrary::PlaySoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, FVector Location)
+{
+	if (Sound && ShouldPlayCosmetics(WorldContextObject))
+		UGameplayStatics::PlaySoundAtLocation(WorldContextObject, Sound, Location);
+}
+
+UParticleSystemComponent* UCosmeticLibrary::SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* EmitterTemplate, const FTransform& SpawnTransform)
+{
+	if (!EmitterTemplate || !ShouldPlayCosmetics(WorldContextObject))
+		return nullptr;
+
+	TPS_LLM_SCOPE(ImpactFX);
+	return UGameplayStatics::SpawnEmitterAtLocation(WorldContextObject, EmitterTemplate, SpawnTransform);
+}
+
+UDecalComponent* UCosmeticLibrary::SpawnDecalAtLocation(const UObject* WorldContextObject, UMaterialInterface* DecalMaterial, FVector DecalSize, FVector Location, FRotator Rotation, float LifeSpan)
+{
+	if (!DecalMaterial || !ShouldPlayCosmetics(WorldContextObject))
+		return nullptr;
+
+	TPS_LLM_SCOPE(ImpactFX);
+	return UGameplayStatics::SpawnDecalAtLocation(WorldContextObject, DecalMaterial, DecalSize, Location, Rotation, LifeSpan);
+}
+
+UDecalComponent* UCosmeticLibrary::SpawnDecalAttached(UMaterialInterface* DecalMaterial, FVector DecalSize, USceneComponent* AttachToComponent, FVector Location, FRotator Rotation, float LifeSpan)
+{
+	if (!DecalMaterial || !AttachToComponent || !ShouldPlayCosmetics(AttachToComponent))
+		return nullptr;
+
+	TPS_LLM_SCOPE(ImpactFX);
+	return UGameplayStatics::SpawnDecalAttached(DecalMaterial, DecalSize, AttachToComponent, NAME_None, Location, Rotation, EAttachLocation::KeepWorldPosition, LifeSpan);
+}
+
+void UCosmeticLibrary::QueueEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* EmitterTemplate, const FTransform& SpawnTransform)
+{
+	if (!EmitterTemplate || !ShouldPlayCosmetics(WorldContextObject))
+		return;
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull);
+	TWeakObjectPtr<UWorld> WeakWorld(World);
+	TWeakObjectPtr<UParticleSystem> WeakTemplate(EmitterTemplate);
+	UTopDownShooterSpawnQueue::Queue(World, ESpawnPriority::Cosmetic, INDEX_NONE, [WeakWorld, WeakTemplate, SpawnTransform]()
+	{
+		if (WeakWorld.IsValid() && WeakTemplate.IsValid())
+		{
+			TPS_LLM_SCOPE(ImpactFX);
+			UGameplayStatics::SpawnEmitterAtLocation(WeakWorld.Get(), WeakTemplate.Get(), SpawnTransform);
+		}
+	});
+}
+
+void UCosmeticLibrary::QueueDecalAttached(UMaterialInterface* DecalMaterial, FVector DecalSize, USceneComponent* AttachToComponent, FVector Location, FRotator Rotation, float LifeSpan)
+{
+	if (!DecalMaterial || !AttachToComponent || !ShouldPlayCosmetics(AttachToComponent))
+		return;
+
+	//the hit component may be destroyed before the decal gets its frame
+	TWeakObjectPtr<UMaterialInterface> WeakMaterial(DecalMaterial);
+	TWeakObjectPtr<USceneComponent> WeakComponent(AttachToComponent);
+	UTopDownShooterSpawnQueue::Queue(AttachToComponent, ESpawnPriority::Cosmetic, INDEX_NONE, [WeakMaterial, DecalSize, WeakComponent, Location, Rotation, LifeSpan]()
+	{
+		if (WeakMaterial.IsValid() && WeakComponent.IsValid())
+		{
+			TPS_LLM_SCOPE(ImpactFX);
+			UGameplayStatics::SpawnDecalAttached(WeakMaterial.Get(), DecalSize, WeakComponent.Get(), NAME_None, Location, Rotation, EAttachLocation::KeepWorldPosition, LifeSpan);
+		}
+	});
+}
+
+void UCosmeticLibrary::PlayMontage(USkeletalMeshComponent* Mesh, UAnimMontage* Montage)
+{
+	if (Montage && Mesh && Mesh->GetAnimInstance() && ShouldPlayCosmetics(Mesh))
+		Mesh->GetAnimInstance()->Montage_Play(Montage);
+}
+
+void UCosmeticLibrary::StopAllMontages(USkeletalMeshComponent* Mesh, float BlendOut)
+{
+	if (Mesh && Mesh->GetAnimInstance() && ShouldPlayCosmetics(Mesh))
+		Mesh->GetAnimInstance()->StopAllMontages(BlendOut);
+}
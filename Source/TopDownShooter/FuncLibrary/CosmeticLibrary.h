@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintFunctionLibrary.h"
+#include "CosmeticLibrary.generated.h"
+
+class UAudioComponent;
+class UParticleSystemComponent;
+class UDecalComponent;
+
+/**
+ * Every sound, emitter, decal and montage of gameplay code goes through here.
+ * Dedicated servers skip them at runtime, Server targets (UE_SERVER) compile them out.
+ * The Queue variants defer the spawn to UTopDownShooterSpawnQueue as Cosmetic requests.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UCosmeticLibrary : public UBlueprintFunctionLibrary
+{
+	GENERATED_BODY()
+
+public:
+	UFUNCTION(BlueprintPure, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static bool ShouldPlayCosmetics(const UObject* WorldContextObject);
+
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static UAudioComponent* SpawnSoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, FVector Location);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static void PlaySoundAtLocation(const UObject* WorldContextObject, USoundBase* Sound, FVector Location);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static UParticleSystemComponent* SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* EmitterTemplate, const FTransform& SpawnTransform);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static UDecalComponent* SpawnDecalAtLocation(const UObject* WorldContextObject, UMaterialInterface* DecalMaterial, FVector DecalSize, FVector Location, FRotator Rotation, float LifeSpan = 0.0f);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic")
+	static UDecalComponent* SpawnDecalAttached(UMaterialInterface* DecalMaterial, FVector DecalSize, USceneComponent* AttachToComponent, FVector Location, FRotator Rotation, float LifeSpan = 0.0f);
+
+	//impact FX nobody holds on to, spawned through UTopDownShooterSpawnQueue and dropped when a burst cannot fit in time
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic", meta = (WorldContext = "WorldContextObject"))
+	static void QueueEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* EmitterTemplate, const FTransform& SpawnTransform);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic")
+	static void QueueDecalAttached(UMaterialInterface* DecalMaterial, FVector DecalSize, USceneComponent* AttachToComponent, FVector Location, FRotator Rotation, float LifeSpan = 0.0f);
+
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic")
+	static void PlayMontage(USkeletalMeshComponent* Mesh, UAnimMontage* Montage);
+	UFUNCTION(BlueprintCallable, Category = "Cosmetic")
+	static void StopAllMontages(USkeletalMeshComponent* Mesh, float BlendOut);
+};
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FlowField.h"
+
+//neighbour offsets, the first four are the straight ones
+static const int32 FlowOffsetX[8] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+static const int32 FlowOffsetY[8] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+static const float FlowStepCost[8] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f };
+
+struct FFlowOpenCell
+{
+	float Distance;
+	int32 Index;
+};
+
+void FFlowField::Init(const FVector2D& InOrigin, int32 InWidth, int32 InHeight, float InCellSize)
+{
+	Origin = InOrigin;
+	Width = FMath::Max(InWidth, 1);
+	Height = FMath::Max(InHeight, 1);
+	CellSize = FMath::Max(InCellSize, 1.0f);
+
+	const int32 NumCells = Width * Height;
+	Blocked.Reset();
+	Blocked.AddZeroed(NumCells);
+	Distance.Reset();
+	Distance.AddUninitialized(NumCells);
+	Direction.Reset();
+	Direction.AddUninitialized(NumCells);
+}
+
+bool FFlowField::WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const
+{
+	OutX = FMath::FloorToInt((Location.X - Origin.X) / CellSize);
+	OutY = FMath::FloorToInt((Location.Y - Origin.Y) / CellSize);
+	return IsValidCell(OutX, OutY);
+}
+
+void FFlowField::Solve(const TArray<FIntPoint>& Goals)
+{
+	const int32 NumCells = Width * Height;
+	for (int32 i = 0; i < NumCells; i++)
+	{
+		Distance[i] = MAX_flt;
+		Direction[i] = NoDirection;
+	}
+
+	auto ByDistance = [](const FFlowOpenCell& A, const FFlowOpenCell& B) { return A.Distance < B.Distance; };
+
+	TArray<FFlowOpenCell> Open;
+	Open.Reserve(Width + Height);
+	for (const FIntPoint& Goal : Goals)
+	{
+		if (!IsValidCell(Goal.X, Goal.Y))
+			continue;
+		const int32 Index = GetCellIndex(Goal.X, Goal.Y);
+		//a player standing in a blocked cell (against a wall) is still a goal
+		if (Distance[Index] > 0.0f)
+		{
+			Distance[Index] = 0.0f;
+			Open.HeapPush({ 0.0f, Index }, ByDistance);
+		}
+	}
+
+	while (Open.Num() > 0)
+	{
+		FFlowOpenCell Current;
+		Open.HeapPop(Current, ByDistance, false);
+		if (Current.Distance > Distance[Current.Index])
+			continue;
+
+		const int32 X = Current.Index % Width;
+		const int32 Y = Current.Index / Width;
+		for (int32 d = 0; d < 8; d++)
+		{
+			const int32 NX = X + FlowOffsetX[d];
+			const int32 NY = Y + FlowOffsetY[d];
+			if (!IsValidCell(NX, NY))
+				continue;
+			const int32 Next = GetCellIndex(NX, NY);
+			if (Blocked[Next])
+				continue;
+			//diagonals only when both straight cells next to it are open
+			if (d >= 4 && (Blocked[GetCellIndex(NX, Y)] || Blocked[GetCellIndex(X, NY)]))
+				continue;
+
+			const float NewDistance = Current.Distance + FlowStepCost[d];
+			if (NewDistance < Distance[Next])
+			{
+				Distance[Next] = NewDistance;
+				Open.HeapPush({ NewDistance, Next }, ByDistance);
+			}
+		}
+	}
+
+	//each cell points at its cheapest reachable neighbour, the same moves the search allowed
+	for (int32 Y = 0; Y < Height; Y++)
+	{
+		for (int32 X = 0; X < Width; X++)
+		{
+			const int32 Index = GetCellIndex(X, Y);
+			if (Blocked[Index] || Distance[Index] == MAX_flt || Distance[Index] == 0.0f)
+				continue;
+
+			float BestDistance = Distance[Index];
+			for (int32 d = 0; d < 8; d++)
+			{
+				const int32 NX = X + FlowOffsetX[d];
+				const int32 NY = Y + FlowOffsetY[d];
+				if (!IsValidCell(NX, NY))
+					continue;
+				if (d >= 4 && (Blocked[GetCellIndex(NX, Y)] || Blocked[GetCellIndex(X, NY)]))
+					continue;
+				const float NextDistance = Distance[GetCellIndex(NX, NY)];
+				if (NextDistance < BestDistance)
+				{
+					BestDistance = NextDistance;
+					Direction[Index] = uint8(d);
+				}
+			}
+		}
+	}
+}
+
+FVector2D FFlowField::SampleDirection(const FVector& Location) const
+{
+	int32 X, Y;
+	if (!WorldToCell(Location, X, Y))
+		return FVector2D::ZeroVector;
+
+	const uint8 d = Direction[GetCellIndex(X, Y)];
+	if (d == NoDirection)
+		return FVector2D::ZeroVector;
+
+	const FVector2D Step(float(FlowOffsetX[d]), float(FlowOffsetY[d]));
+	return d >= 4 ? Step * 0.70710678f : Step;
+}
+
+float FFlowField::SampleDistance(const FVector& Location) const
+{
+	int32 X, Y;
+	if (!WorldToCell(Location, X, Y))
+		return -1.0f;
+
+	const float CellDistance = Distance[GetCellIndex(X, Y)];
+	return CellDistance == MAX_flt ? -1.0f : CellDistance * CellSize;
+}
@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Grid over XY holding, for every cell, the path distance to the nearest goal and the neighbour to step to
+struct TOPDOWNSHOOTER_API FFlowField
+{
+	void Init(const FVector2D& InOrigin, int32 InWidth, int32 InHeight, float InCellSize);
+
+	bool IsValidCell(int32 X, int32 Y) const { return X >= 0 && Y >= 0 && X < Width && Y < Height; }
+	int32 GetCellIndex(int32 X, int32 Y) const { return Y * Width + X; }
+	bool WorldToCell(const FVector& Location, int32& OutX, int32& OutY) const;
+	FVector2D GetCellCenter(int32 X, int32 Y) const { return Origin + FVector2D((X + 0.5f) * CellSize, (Y + 0.5f) * CellSize); }
+
+	//Dijkstra from all goal cells at once, 8 neighbours, no corner cutting past blocked cells
+	void Solve(const TArray<FIntPoint>& Goals);
+
+	//unit direction toward the nearest goal, zero outside the grid, in blocked or unreachable cells and at a goal
+	FVector2D SampleDirection(const FVector& Location) const;
+	//path distance to the nearest goal, negative when there is none
+	float SampleDistance(const FVector& Location) const;
+
+	FVector2D Origin = FVector2D::ZeroVector;
+	int32 Width = 0;
+	int32 Height = 0;
+	float CellSize = 100.0f;
+
+	//filled before Solve, 1 for cells agents cannot enter
+	TArray<uint8> Blocked;
+	TArray<float> Distance;
+	//index into the 8 neighbour offsets, NoDirection when there is nowhere to go
+	TArray<uint8> Direction;
+
+	static const uint8 NoDirection = 0xFF;
+};
@@ -0,0 +1,103 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InventoryLogic.h"
+
+namespace InventoryLogic
+{
+	bool FindAmmoForWeapon(const TArray<FAmmoSlot>& AmmoSlots, EWeaponType TypeWeapon, int32& OutAviableAmmo)
+	{
+		OutAviableAmmo = 0;
+		for (const FAmmoSlot& Ammo : AmmoSlots)
+		{
+			if (Ammo.WeaponType == TypeWeapon)
+			{
+				OutAviableAmmo = Ammo.Cout;
+				return Ammo.Cout > 0;
+			}
+		}
+		return false;
+	}
+
+	uint32 GetTakeableAmmoMask(const TArray<FAmmoSlot>& AmmoSlots)
+	{
+		uint32 Mask = 0;
+		for (const FAmmoSlot& Ammo : AmmoSlots)
+		{
+			if (Ammo.Cout < Ammo.MaxCout)
+				Mask |= 1u << uint32(Ammo.WeaponType);
+		}
+		return Mask;
+	}
+
+	int32 FindFreeWeaponSlot(const TArray<FWeaponSlot>& WeaponSlots)
+	{
+		for (int32 i = 0; i < WeaponSlots.Num(); i++)
+		{
+			if (WeaponSlots[i].NameItem.IsNone())
+				return i;
+		}
+		return INDEX_NONE;
+	}
+
+	bool IsSlotUsable(const FWeaponSlot& Slot, const TArray<FAmmoSlot>& AmmoSlots, FWeaponTypeLookup GetWeaponType)
+	{
+		if (Slot.NameItem.IsNone())
+			return false;
+		if (Slot.AdditionalInfo.Round > 0)
+			return true;
+
+		//empty clip, any ammo slot of the weapon type with ammo left will do
+		EWeaponType myType;
+		if (!GetWeaponType(Slot.NameItem, myType))
+			return false;
+
+		for (const FAmmoSlot& Ammo : AmmoSlots)
+		{
+			if (Ammo.WeaponType == myType && Ammo.Cout > 0)
+				return true;
+		}
+		return false;
+	}
+
+	int32 FindSwitchIndex(const TArray<FWeaponSlot>& WeaponSlots, const TArray<FAmmoSlot>& AmmoSlots, int32 ChangeToIndex, int32 OldIndex, bool bIsForward, FWeaponTypeLookup GetWeaponType)
+	{
+		const int32 NumSlots = WeaponSlots.Num();
+
+		int32 CorrectIndex = ChangeToIndex;
+		if (ChangeToIndex > NumSlots - 1)
+			CorrectIndex = 0;
+		else if (ChangeToIndex < 0)
+			CorrectIndex = NumSlots - 1;
+
+		if (WeaponSlots.IsValidIndex(CorrectIndex) && IsSlotUsable(WeaponSlots[CorrectIndex], AmmoSlots, GetWeaponType))
+			return CorrectIndex;
+
+		//walk on in the switch direction, past the end wrap around to the other side but never back onto the old slot
+		const int32 Step = bIsForward ? 1 : -1;
+		int32 WrapIndex = bIsForward ? 0 : NumSlots - 1;
+		for (int32 Iteration = 1; Iteration <= NumSlots; Iteration++)
+		{
+			const int32 TmpIndex = ChangeToIndex + Iteration * Step;
+			if (WeaponSlots.IsValidIndex(TmpIndex))
+			{
+				if (IsSlotUsable(WeaponSlots[TmpIndex], AmmoSlots, GetWeaponType))
+					return TmpIndex;
+			}
+			else
+			{
+				if (WrapIndex != OldIndex && WeaponSlots.IsValidIndex(WrapIndex) && IsSlotUsable(WeaponSlots[WrapIndex], AmmoSlots, GetWeaponType))
+					return WrapIndex;
+
+				if (WrapIndex == OldIndex && WeaponSlots.IsValidIndex(WrapIndex) && !IsSlotUsable(WeaponSlots[WrapIndex], AmmoSlots, GetWeaponType))
+				{
+					//Not find weapon with amm need init Pistol with infinity ammo
+					UE_LOG(LogTemp, Error, TEXT("InventoryLogic::FindSwitchIndex - Init PISTOL - NEED"));
+				}
+				WrapIndex += Step;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+}
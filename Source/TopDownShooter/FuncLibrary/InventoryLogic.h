@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FuncLibrary/Types.h"
+
+//Inventory selection without a component, UTopDownShooterInventorComponent forwards here
+namespace InventoryLogic
+{
+	//Weapon type of a weapon row, false when unknown
+	typedef TFunctionRef<bool(FName WeaponName, EWeaponType& OutType)> FWeaponTypeLookup;
+
+	//First ammo slot of TypeWeapon: OutAviableAmmo is its count, true when there is something to load
+	TOPDOWNSHOOTER_API bool FindAmmoForWeapon(const TArray<FAmmoSlot>& AmmoSlots, EWeaponType TypeWeapon, int32& OutAviableAmmo);
+
+	//Slot holds a weapon that is loaded or has ammo left in the inventory
+	TOPDOWNSHOOTER_API bool IsSlotUsable(const FWeaponSlot& Slot, const TArray<FAmmoSlot>& AmmoSlots, FWeaponTypeLookup GetWeaponType);
+
+	//Bit (1 << EWeaponType) set for every ammo type with a slot that is not full, what CheckCanTakeAmmo answers per type
+	TOPDOWNSHOOTER_API uint32 GetTakeableAmmoMask(const TArray<FAmmoSlot>& AmmoSlots);
+
+	//First empty weapon slot, INDEX_NONE when the inventory is full
+	TOPDOWNSHOOTER_API int32 FindFreeWeaponSlot(const TArray<FWeaponSlot>& WeaponSlots);
+
+	//Slot SwitchWeaponToIndex lands on, walking past unusable slots in the switch direction. INDEX_NONE when nothing to switch to
+	TOPDOWNSHOOTER_API int32 FindSwitchIndex(const TArray<FWeaponSlot>& WeaponSlots, const TArray<FAmmoSlot>& AmmoSlots, int32 ChangeToIndex, int32 OldIndex, bool bIsForward, FWeaponTypeLookup GetWeaponType);
+}
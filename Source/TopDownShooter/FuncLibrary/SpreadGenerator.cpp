@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpreadGenerator.h"
+#include "Math/VectorRegister.h"
+#include "Math/RandomStream.h"
+#include "Math/RotationMatrix.h"
+
+void FShotSpread::Reset(int32 InNumPellets)
+{
+	NumPellets = FMath::Max(InNumPellets, 0);
+	const int32 NumPadded = Align(NumPellets, 4);
+
+	CosPhi.SetNumUninitialized(NumPadded, false);
+	SinPhi.SetNumUninitialized(NumPadded, false);
+	CosTheta.SetNumUninitialized(NumPadded, false);
+	SinTheta.SetNumUninitialized(NumPadded, false);
+	DirX.SetNumUninitialized(NumPadded, false);
+	DirY.SetNumUninitialized(NumPadded, false);
+	DirZ.SetNumUninitialized(NumPadded, false);
+	Pitch.SetNumUninitialized(NumPellets, false);
+	Yaw.SetNumUninitialized(NumPellets, false);
+
+	//padding lanes point straight ahead
+	for (int32 i = NumPellets; i < NumPadded; i++)
+	{
+		CosPhi[i] = 1.0f;
+		SinPhi[i] = 0.0f;
+		CosTheta[i] = 1.0f;
+		SinTheta[i] = 0.0f;
+	}
+}
+
+namespace SpreadGenerator
+{
+	void BuildPattern(const TArray<FVector2D>& Points, FSpreadPattern& OutPattern)
+	{
+		OutPattern.Radius.Reset(Points.Num());
+		OutPattern.CosTheta.Reset(Points.Num());
+		OutPattern.SinTheta.Reset(Points.Num());
+		for (const FVector2D& Point : Points)
+		{
+			const float Length = Point.Size();
+			const FVector2D Unit = Length > KINDA_SMALL_NUMBER ? Point / Length : FVector2D(1.0f, 0.0f);
+			OutPattern.Radius.Add(FMath::Min(Length, 1.0f));
+			OutPattern.CosTheta.Add(Unit.X);
+			OutPattern.SinTheta.Add(Unit.Y);
+		}
+	}
+
+	void Generate(const FVector& Direction, float DirectionSign, float DispersionDegrees, int32 NumPellets, FRandomStream& Stream, const FSpreadPattern* Pattern, FShotSpread& OutSpread)
+	{
+		OutSpread.Reset(NumPellets);
+		if (NumPellets <= 0)
+			return;
+
+		const float ConeHalfAngleRad = DispersionDegrees * PI / 180.f;
+		const bool bUsePattern = Pattern && Pattern->Num() > 0;
+
+		//cone angles, the random draws keep the order VRandCone uses so seeds give the same pellets
+		for (int32 i = 0; i < NumPellets; i++)
+		{
+			float Phi = 0.0f;
+			if (bUsePattern)
+			{
+				const int32 PatternIndex = i % Pattern->Num();
+				Phi = Pattern->Radius[PatternIndex] * ConeHalfAngleRad;
+				OutSpread.CosTheta[i] = Pattern->CosTheta[PatternIndex];
+				OutSpread.SinTheta[i] = Pattern->SinTheta[PatternIndex];
+			}
+			else if (ConeHalfAngleRad > 0.f)
+			{
+				const float RandU = Stream.FRand();
+				const float RandV = Stream.FRand();
+				Phi = FMath::Fmod(FMath::Acos((2.f * RandV) - 1.f), ConeHalfAngleRad);
+				FMath::SinCos(&OutSpread.SinTheta[i], &OutSpread.CosTheta[i], 2.f * PI * RandU);
+			}
+			else
+			{
+				OutSpread.CosTheta[i] = 1.0f;
+				OutSpread.SinTheta[i] = 0.0f;
+			}
+			FMath::SinCos(&OutSpread.SinPhi[i], &OutSpread.CosPhi[i], Phi);
+		}
+
+		//cone frame is built once per shot: tilt by Phi around Y, then turn by Theta around the aim axis
+		const FMatrix DirMat = FRotationMatrix(Direction.Rotation());
+		const FVector AxisX = DirMat.GetUnitAxis(EAxis::X) * DirectionSign;
+		const FVector AxisY = DirMat.GetUnitAxis(EAxis::Y) * DirectionSign;
+		const FVector AxisZ = DirMat.GetUnitAxis(EAxis::Z) * -DirectionSign;
+
+		const VectorRegister XX = VectorSetFloat1(AxisX.X), XY = VectorSetFloat1(AxisX.Y), XZ = VectorSetFloat1(AxisX.Z);
+		const VectorRegister YX = VectorSetFloat1(AxisY.X), YY = VectorSetFloat1(AxisY.Y), YZ = VectorSetFloat1(AxisY.Z);
+		const VectorRegister ZX = VectorSetFloat1(AxisZ.X), ZY = VectorSetFloat1(AxisZ.Y), ZZ = VectorSetFloat1(AxisZ.Z);
+
+		for (int32 Base = 0; Base < OutSpread.DirX.Num(); Base += 4)
+		{
+			const VectorRegister CosPhi = VectorLoadAligned(&OutSpread.CosPhi[Base]);
+			const VectorRegister SinPhi = VectorLoadAligned(&OutSpread.SinPhi[Base]);
+			//Dir = cos(Phi) X + sin(Phi) sin(Theta) Y - sin(Phi) cos(Theta) Z
+			const VectorRegister WY = VectorMultiply(SinPhi, VectorLoadAligned(&OutSpread.SinTheta[Base]));
+			const VectorRegister WZ = VectorMultiply(SinPhi, VectorLoadAligned(&OutSpread.CosTheta[Base]));
+
+			VectorStoreAligned(VectorMultiplyAdd(CosPhi, XX, VectorMultiplyAdd(WY, YX, VectorMultiply(WZ, ZX))), &OutSpread.DirX[Base]);
+			VectorStoreAligned(VectorMultiplyAdd(CosPhi, XY, VectorMultiplyAdd(WY, YY, VectorMultiply(WZ, ZY))), &OutSpread.DirY[Base]);
+			VectorStoreAligned(VectorMultiplyAdd(CosPhi, XZ, VectorMultiplyAdd(WY, YZ, VectorMultiply(WZ, ZZ))), &OutSpread.DirZ[Base]);
+		}
+
+		//same pitch and yaw FVector::Rotation() gives, projectiles do not roll
+		for (int32 i = 0; i < NumPellets; i++)
+		{
+			const float X = OutSpread.DirX[i];
+			const float Y = OutSpread.DirY[i];
+			const float Z = OutSpread.DirZ[i];
+			OutSpread.Yaw[i] = FMath::Atan2(Y, X) * (180.f / PI);
+			OutSpread.Pitch[i] = FMath::Atan2(Z, FMath::Sqrt(X * X + Y * Y)) * (180.f / PI);
+		}
+	}
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Authored spread pattern, precomputed once: every point as a unit vector on the cone's disk and a fraction of the cone angle
+struct TOPDOWNSHOOTER_API FSpreadPattern
+{
+	int32 Num() const { return Radius.Num(); }
+
+	TArray<float> Radius;
+	TArray<float> CosTheta;
+	TArray<float> SinTheta;
+};
+
+//Pellets of one shot as structure of arrays, padded to a multiple of 4 so directions are built 4 pellets per SIMD register
+struct TOPDOWNSHOOTER_API FShotSpread
+{
+	void Reset(int32 NumPellets);
+
+	int32 Num() const { return NumPellets; }
+
+	FVector GetDirection(int32 Index) const { return FVector(DirX[Index], DirY[Index], DirZ[Index]); }
+	FRotator GetRotation(int32 Index) const { return FRotator(Pitch[Index], Yaw[Index], 0.0f); }
+
+	//cone angles per pellet
+	TArray<float, TAlignedHeapAllocator<16>> CosPhi;
+	TArray<float, TAlignedHeapAllocator<16>> SinPhi;
+	TArray<float, TAlignedHeapAllocator<16>> CosTheta;
+	TArray<float, TAlignedHeapAllocator<16>> SinTheta;
+
+	//results, unit directions and their rotations
+	TArray<float, TAlignedHeapAllocator<16>> DirX;
+	TArray<float, TAlignedHeapAllocator<16>> DirY;
+	TArray<float, TAlignedHeapAllocator<16>> DirZ;
+	TArray<float> Pitch;
+	TArray<float> Yaw;
+
+private:
+	int32 NumPellets = 0;
+};
+
+namespace SpreadGenerator
+{
+	//Points on the unit disk of the cone, length 1 is the edge of the current dispersion
+	TOPDOWNSHOOTER_API void BuildPattern(const TArray<FVector2D>& Points, FSpreadPattern& OutPattern);
+
+	//All pellets of a shot around unit Direction (times DirectionSign), cone half angle DispersionDegrees.
+	//Without a pattern every pellet draws from Stream exactly like FRandomStream::VRandCone, a pattern draws nothing and repeats over the pellets
+	TOPDOWNSHOOTER_API void Generate(const FVector& Direction, float DirectionSign, float DispersionDegrees, int32 NumPellets, FRandomStream& Stream, const FSpreadPattern* Pattern, FShotSpread& OutSpread);
+}
@@ -2,5 +2,40 @@
 
 
 #include "Types.h"
+#include "UObject/CoreNet.h"
 
+bool FWeaponFireEvent::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar << WeaponSlot;
+	Ar << ShotIndex;
+	Ar << Seed;
+	Ar << Timestamp;
 
+	bool bMuzzleSuccess = true;
+	bool bAimSuccess = true;
+	MuzzleLocation.NetSerialize(Ar, Map, bMuzzleSuccess);
+	MuzzleRotation.SerializeCompressedShort(Ar);
+	AimPoint.NetSerialize(Ar, Map, bAimSuccess);
+
+	//hundredths of a degree is finer than any authored spread
+	uint16 DispersionQuantized = 0;
+	if (Ar.IsSaving())
+		DispersionQuantized = (uint16)FMath::Clamp(FMath::RoundToInt(Dispersion * 100.0f), 0, (int32)MAX_uint16);
+	Ar << DispersionQuantized;
+	if (Ar.IsLoading())
+		Dispersion = DispersionQuantized * 0.01f;
+
+	bOutSuccess = bMuzzleSuccess && bAimSuccess;
+	return true;
+}
+
+void FWeaponFireEvent::Quantize()
+{
+	//through the serializer itself, any change to the wire format is picked up here
+	FNetBitWriter Writer(nullptr, 0);
+	bool bSuccess = true;
+	NetSerialize(Writer, nullptr, bSuccess);
+
+	FNetBitReader Reader(nullptr, Writer.GetData(), Writer.GetNumBits());
+	NetSerialize(Reader, nullptr, bSuccess);
+}
@@ -7,6 +7,7 @@
 #include "Engine/DataTable.h"
 #include "Animation/AnimMontage.h"
 #include "Particles/ParticleSystem.h"
+#include "Engine/NetSerialization.h"
 #include "Types.generated.h"
 
 UENUM(BlueprintType)
@@ -129,6 +130,10 @@ struct FWeaponDispersion
 	float Run_StateDispersionAimRecoil = 1.0f;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dispersion ")
 	float Run_StateDispersionReduction = 0.1f;
+
+	//optional, seconds since the last shot or state change -> 0..1 of the way to min (aiming) or max, replaces the linear Reduction
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dispersion ")
+	class UCurveFloat* DispersionRecoveryCurve = nullptr;
 };
 
 USTRUCT(BlueprintType)
@@ -195,9 +200,15 @@ struct FWeaponInfos : public FTableRowBase
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dispersion ")
 	FWeaponDispersion DispersionWeapon;
+	//fixed pellet layout instead of random spread, points on the unit disk of the dispersion cone (length 1 = edge), repeats over NumberProjectileByShot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dispersion ")
+	TArray<FVector2D> SpreadPattern;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound ")
 	USoundBase* SoundFireWeapon = nullptr;
+	//optional, looped on the weapon while a burst lasts instead of retriggering SoundFireWeapon per shot
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound ")
+	USoundBase* SoundFireWeaponLoop = nullptr;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Sound ")
 	USoundBase* SoundReloadWeapon = nullptr;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "FX ")
@@ -293,6 +304,84 @@ struct FDropItem : public FTableRowBase
 	FWeaponSlot WeaponInfo;
 };
 
+USTRUCT(BlueprintType)
+struct FStatusEffectInfos
+{
+	GENERATED_BODY()
+
+	//effects with the same tag on one target refresh instead of stacking, None always stacks
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	FName Tag = NAME_None;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float Duration = 5.0f;
+	//ApplyDamage every TickInterval seconds, 0 for none
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float DamagePerTick = 0.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float TickInterval = 1.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float MoveSpeedMultiplier = 1.0f;
+	//scales the time between shots
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float FireIntervalMultiplier = 1.0f;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "StatusEffect")
+	float DispersionMultiplier = 1.0f;
+};
+
+//Product of the multipliers of all effects active on one actor
+USTRUCT(BlueprintType)
+struct FStatusEffectModifiers
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category = "StatusEffect")
+	float MoveSpeed = 1.0f;
+	UPROPERTY(BlueprintReadOnly, Category = "StatusEffect")
+	float FireInterval = 1.0f;
+	UPROPERTY(BlueprintReadOnly, Category = "StatusEffect")
+	float Dispersion = 1.0f;
+};
+
+//Everything needed to reproduce one shot on any machine, pellets are regenerated from Seed
+USTRUCT()
+struct FWeaponFireEvent
+{
+	GENERATED_BODY()
+
+	//inventory slot of the weapon on the shooting character
+	UPROPERTY()
+	uint8 WeaponSlot = 0;
+	UPROPERTY()
+	uint16 ShotIndex = 0;
+	UPROPERTY()
+	int32 Seed = 0;
+	//server world time seen by the shooter
+	UPROPERTY()
+	float Timestamp = 0.0f;
+	UPROPERTY()
+	FVector_NetQuantize10 MuzzleLocation;
+	UPROPERTY()
+	FRotator MuzzleRotation = FRotator::ZeroRotator;
+	UPROPERTY()
+	FVector_NetQuantize AimPoint;
+	//cone angle in degrees used for this shot
+	UPROPERTY()
+	float Dispersion = 0.0f;
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+	//round to what NetSerialize sends, so the shooter resolves the same pellets as everyone receiving the event
+	void Quantize();
+};
+
+template<>
+struct TStructOpsTypeTraits<FWeaponFireEvent> : public TStructOpsTypeTraitsBase2<FWeaponFireEvent>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
+
 UCLASS()
 class TOPDOWNSHOOTER_API UTypes : public UBlueprintFunctionLibrary
 {
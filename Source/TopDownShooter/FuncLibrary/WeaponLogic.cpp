@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponLogic.h"
+#include "Math/RandomStream.h"
+
+namespace WeaponLogic
+{
+	float EvaluateDispersion(float Anchor, float Elapsed, float Min, float Max, float RatePerSecond, bool bReloading, bool bFiring, bool bShouldReduce)
+	{
+		if (bReloading)
+			return Anchor;
+
+		float Current = FMath::Clamp(Anchor, Min, Max);
+		if (!bFiring)
+			Current += (bShouldReduce ? -RatePerSecond : RatePerSecond) * Elapsed;
+
+		return FMath::Clamp(Current, Min, Max);
+	}
+
+	float EvaluateDispersionCurve(float Anchor, float CurveAlpha, float Min, float Max, bool bReloading, bool bFiring, bool bShouldReduce)
+	{
+		if (bReloading)
+			return Anchor;
+
+		const float Start = FMath::Clamp(Anchor, Min, Max);
+		if (bFiring)
+			return Start;
+
+		return FMath::Lerp(Start, bShouldReduce ? Min : Max, FMath::Clamp(CurveAlpha, 0.0f, 1.0f));
+	}
+
+	FVector ApplyDispersionToShoot(const FVector& Direction, float DispersionDegrees, FRandomStream& Stream)
+	{
+		return Stream.VRandCone(Direction, DispersionDegrees * PI / 180.f);
+	}
+
+	void ComputeReload(int32 MaxRound, int32 Round, int32 AviableAmmo, int32& OutRound, int32& OutTakenFromInventory)
+	{
+		const int32 NeedToReload = MaxRound - Round;
+		if (NeedToReload > AviableAmmo)
+		{
+			OutRound = AviableAmmo;
+			OutTakenFromInventory = AviableAmmo;
+		}
+		else
+		{
+			OutRound = Round + NeedToReload;
+			OutTakenFromInventory = NeedToReload;
+		}
+	}
+}
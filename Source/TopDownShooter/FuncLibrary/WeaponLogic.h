@@ -0,0 +1,20 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+//Weapon math without an actor, AWeaponDefault forwards here so it can be measured in isolation (TPS.MicroBench)
+namespace WeaponLogic
+{
+	//Dispersion Elapsed seconds after it was Anchor: moves towards Min (reduce) or Max at RatePerSecond, held while firing, frozen while reloading
+	TOPDOWNSHOOTER_API float EvaluateDispersion(float Anchor, float Elapsed, float Min, float Max, float RatePerSecond, bool bReloading, bool bFiring, bool bShouldReduce);
+	//Same with an authored recovery curve, CurveAlpha 0..1 is how far it got from Anchor towards Min (reduce) or Max
+	TOPDOWNSHOOTER_API float EvaluateDispersionCurve(float Anchor, float CurveAlpha, float Min, float Max, bool bReloading, bool bFiring, bool bShouldReduce);
+
+	//Random direction inside a cone of DispersionDegrees around Direction
+	TOPDOWNSHOOTER_API FVector ApplyDispersionToShoot(const FVector& Direction, float DispersionDegrees, FRandomStream& Stream);
+
+	//Rounds in the clip after a reload and how many of them come out of the inventory
+	TOPDOWNSHOOTER_API void ComputeReload(int32 MaxRound, int32 Round, int32 AviableAmmo, int32& OutRound, int32& OutTakenFromInventory);
+}
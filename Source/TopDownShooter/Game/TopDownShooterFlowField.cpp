@@ -0,0 +1,214 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterFlowField.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Flow Field Tick"), STAT_TPS_FlowField, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Obstacles"), STAT_TPS_FlowFieldObstacles, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Flow Field Solve"), STAT_TPS_FlowFieldSolve, STATGROUP_TopDownShooter);
+
+int32 FlowFieldEnabled = 1;
+FAutoConsoleVariableRef CVARFlowFieldEnabled(TEXT("TPS.FlowField"), FlowFieldEnabled, TEXT("Solve a flow field toward the players for horde enemies, off means they walk straight at the nearest player"), ECVF_Default);
+
+float FlowFieldCellSize = 100.0f;
+FAutoConsoleVariableRef CVARFlowFieldCellSize(TEXT("TPS.FlowField.CellSize"), FlowFieldCellSize, TEXT("Cell size of the flow field"), ECVF_Default);
+
+int32 FlowFieldSize = 128;
+FAutoConsoleVariableRef CVARFlowFieldSize(TEXT("TPS.FlowField.Size"), FlowFieldSize, TEXT("Cells along each side of the flow field"), ECVF_Default);
+
+int32 FlowFieldMargin = 16;
+FAutoConsoleVariableRef CVARFlowFieldMargin(TEXT("TPS.FlowField.Margin"), FlowFieldMargin, TEXT("A player closer than this many cells to the border moves the flow field"), ECVF_Default);
+
+float FlowFieldIdleTime = 2.0f;
+FAutoConsoleVariableRef CVARFlowFieldIdleTime(TEXT("TPS.FlowField.IdleTime"), FlowFieldIdleTime, TEXT("Seconds without anyone reading the flow field before it stops updating"), ECVF_Default);
+
+//obstacle probe height around the players' capsule centre, clear of the floor below
+static const float FlowFieldProbeHalfHeight = 40.0f;
+
+void UTopDownShooterFlowField::Deinitialize()
+{
+	//the worker reads the physics scene of this world
+	if (bSolvePending)
+		PendingField.Wait();
+	bSolvePending = false;
+	Field.Reset();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterFlowField::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	if (HasAnyFlags(RF_ClassDefaultObject) || !World || !World->IsGameWorld())
+		return false;
+	return bSolvePending || (FlowFieldEnabled && LastRequestTime >= 0.0 && FPlatformTime::Seconds() - LastRequestTime < FlowFieldIdleTime);
+}
+
+TStatId UTopDownShooterFlowField::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterFlowField, STATGROUP_Tickables);
+}
+
+FFlowFieldPtr UTopDownShooterFlowField::GetField() const
+{
+	LastRequestTime = FPlatformTime::Seconds();
+	return FlowFieldEnabled ? Field : nullptr;
+}
+
+FVector UTopDownShooterFlowField::GetFlowDirection(FVector Location) const
+{
+	FFlowFieldPtr myField = GetField();
+	if (!myField.IsValid())
+		return FVector::ZeroVector;
+	return FVector(myField->SampleDirection(Location), 0.0f);
+}
+
+void UTopDownShooterFlowField::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_FlowField);
+
+	if (bSolvePending && PendingField.IsReady())
+		FinishSolve();
+
+	if (!FlowFieldEnabled || !GatherGoals())
+		return;
+
+	if (NeedsPlacement())
+		Place();
+
+	Goals.Reset();
+	for (const FVector& Location : PlayerLocations)
+	{
+		const int32 X = FMath::FloorToInt((Location.X - GridOrigin.X) / GridCellSize);
+		const int32 Y = FMath::FloorToInt((Location.Y - GridOrigin.Y) / GridCellSize);
+		if (X >= 0 && Y >= 0 && X < GridSize && Y < GridSize)
+			Goals.Add(FIntPoint(X, Y));
+	}
+
+	//one solve in flight at a time, the next one picks up whatever changed meanwhile
+	if (!bSolvePending && (bPlacementChanged || Goals != SolvedGoals))
+		StartSolve(bPlacementChanged);
+}
+
+bool UTopDownShooterFlowField::GatherGoals()
+{
+	PlayerLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* myPC = It->Get();
+		APawn* myPawn = myPC ? myPC->GetPawn() : nullptr;
+		if (myPawn && !myPawn->IsPendingKill())
+			PlayerLocations.Add(myPawn->GetActorLocation());
+	}
+	return PlayerLocations.Num() > 0;
+}
+
+bool UTopDownShooterFlowField::NeedsPlacement() const
+{
+	if (!bPlaced || GridCellSize != FMath::Max(FlowFieldCellSize, 1.0f) || GridSize != FMath::Max(FlowFieldSize, 1))
+		return true;
+
+	const float Margin = FMath::Clamp(FlowFieldMargin, 0, GridSize / 2) * GridCellSize;
+	const float Extent = GridSize * GridCellSize;
+	for (const FVector& Location : PlayerLocations)
+	{
+		const float LocalX = Location.X - GridOrigin.X;
+		const float LocalY = Location.Y - GridOrigin.Y;
+		if (LocalX < Margin || LocalY < Margin || LocalX > Extent - Margin || LocalY > Extent - Margin)
+			return true;
+	}
+	return false;
+}
+
+void UTopDownShooterFlowField::Place()
+{
+	FVector Center = FVector::ZeroVector;
+	for (const FVector& Location : PlayerLocations)
+		Center += Location;
+	Center /= float(PlayerLocations.Num());
+
+	const float NewCellSize = FMath::Max(FlowFieldCellSize, 1.0f);
+	const int32 NewSize = FMath::Max(FlowFieldSize, 1);
+	const float HalfExtent = NewSize * NewCellSize * 0.5f;
+	//snapped to whole cells so a moved grid keeps the same cell boundaries
+	const FVector2D NewOrigin(FMath::GridSnap(Center.X - HalfExtent, NewCellSize), FMath::GridSnap(Center.Y - HalfExtent, NewCellSize));
+
+	//players too far apart to fit keep asking for a move, only a different grid is worth sampling again
+	if (bPlaced && NewOrigin == GridOrigin && NewCellSize == GridCellSize && NewSize == GridSize)
+		return;
+
+	GridOrigin = NewOrigin;
+	GridCellSize = NewCellSize;
+	GridSize = NewSize;
+	GridZ = Center.Z;
+	bPlaced = true;
+	bPlacementChanged = true;
+}
+
+void UTopDownShooterFlowField::StartSolve(bool bSampleObstacles)
+{
+	UWorld* myWorld = GetWorld();
+	//walls carry over from the field currently in use when the grid did not move
+	FFlowFieldPtr PreviousField = bSampleObstacles ? nullptr : Field;
+	const FVector2D Origin = GridOrigin;
+	const int32 Size = GridSize;
+	const float CellSize = GridCellSize;
+	const float ProbeZ = GridZ;
+	const TArray<FIntPoint> SolveGoals = Goals;
+
+	//counted here, the counters are game thread only
+	if (bSampleObstacles)
+	{
+		TPS_COUNT_TRACES(FlowFieldObstacleTraces, Size * Size);
+	}
+
+	SolvedGoals = Goals;
+	bPlacementChanged = false;
+	bSolvePending = true;
+
+	PendingField = Async(EAsyncExecution::ThreadPool, [myWorld, PreviousField, Origin, Size, CellSize, ProbeZ, SolveGoals]()
+	{
+		TSharedPtr<FFlowField, ESPMode::ThreadSafe> NewField = MakeShared<FFlowField, ESPMode::ThreadSafe>();
+		NewField->Init(Origin, Size, Size, CellSize);
+
+		if (PreviousField.IsValid() && PreviousField->Blocked.Num() == NewField->Blocked.Num() && PreviousField->Origin == Origin)
+		{
+			NewField->Blocked = PreviousField->Blocked;
+		}
+		else
+		{
+			SCOPE_CYCLE_COUNTER(STAT_TPS_FlowFieldObstacles);
+
+			const FCollisionShape Box = FCollisionShape::MakeBox(FVector(CellSize * 0.5f, CellSize * 0.5f, FlowFieldProbeHalfHeight));
+			const FCollisionObjectQueryParams ObjectParams(ECC_WorldStatic);
+			const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(FlowFieldObstacle), false);
+			for (int32 Y = 0; Y < Size; Y++)
+			{
+				for (int32 X = 0; X < Size; X++)
+				{
+					const FVector Probe(NewField->GetCellCenter(X, Y), ProbeZ);
+					NewField->Blocked[NewField->GetCellIndex(X, Y)] = myWorld->OverlapAnyTestByObjectType(Probe, FQuat::Identity, ObjectParams, Box, QueryParams) ? 1 : 0;
+				}
+			}
+		}
+
+		{
+			SCOPE_CYCLE_COUNTER(STAT_TPS_FlowFieldSolve);
+			NewField->Solve(SolveGoals);
+		}
+		return FFlowFieldPtr(NewField);
+	});
+}
+
+void UTopDownShooterFlowField::FinishSolve()
+{
+	Field = PendingField.Get();
+	PendingField = TFuture<FFlowFieldPtr>();
+	bSolvePending = false;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Async/Future.h"
+#include "FuncLibrary/FlowField.h"
+#include "TopDownShooterFlowField.generated.h"
+
+typedef TSharedPtr<const FFlowField, ESPMode::ThreadSafe> FFlowFieldPtr;
+
+/**
+ * Flow field toward the nearest player over a square grid centred on the players, so crowds of enemies
+ * follow one shared field instead of each asking the navmesh for a path.
+ * The field is solved on a worker thread only when a player enters another cell or the grid has to move,
+ * agents keep reading the previous field until the new one is swapped in on the game thread.
+ * Walls are found with overlap tests against world static geometry at the players' height (flat maps).
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterFlowField : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//latest solved field, null until the first one is ready; safe to read from worker threads while held.
+	//Asking for it keeps the field updated, nobody asking for a few seconds stops the updates
+	FFlowFieldPtr GetField() const;
+
+	//direction to walk from Location toward the nearest player, zero outside the field or with no path
+	UFUNCTION(BlueprintCallable, Category = "FlowField")
+	FVector GetFlowDirection(FVector Location) const;
+
+private:
+	bool GatherGoals();
+	bool NeedsPlacement() const;
+	void Place();
+	void StartSolve(bool bSampleObstacles);
+	void FinishSolve();
+
+	FFlowFieldPtr Field;
+	TFuture<FFlowFieldPtr> PendingField;
+	bool bSolvePending = false;
+
+	//grid placement the next solve uses, walls are sampled again only when it changes
+	FVector2D GridOrigin = FVector2D::ZeroVector;
+	int32 GridSize = 0;
+	float GridCellSize = 0.0f;
+	float GridZ = 0.0f;
+	bool bPlaced = false;
+	bool bPlacementChanged = false;
+
+	TArray<FVector> PlayerLocations;
+	TArray<FIntPoint> Goals;
+	TArray<FIntPoint> SolvedGoals;
+
+	mutable double LastRequestTime = -1.0;
+};
@@ -2,6 +2,7 @@
 
 
 #include "TopDownShooterGameInstance.h"
+#include "TopDownShooterMemory.h"
 
 bool UTopDownShooterGameInstance::GetWeaponInfoByName(FName NameWeapon, FWeaponInfos & OutInfo)
 {
@@ -13,6 +14,7 @@ bool UTopDownShooterGameInstance::GetWeaponInfoByName(FName NameWeapon, FWeaponI
 		WeaponInfoRow = WeaponInfoTable->FindRow<FWeaponInfos>(NameWeapon, "", false);
 		if (WeaponInfoRow)
 		{
+			TPS_LLM_SCOPE(WeaponData);
 			bIsFind = true;
 			OutInfo = *WeaponInfoRow;
 		}
@@ -32,7 +34,7 @@ bool UTopDownShooterGameInstance::GetDropItemInfoByName(FName NameItem, FDropIte
 
 	if (DropItemInfoTable)
 	{
-		DropItemInfoRow = WeaponInfoTable->FindRow<FDropItem>(NameItem, "", false);
+		DropItemInfoRow = DropItemInfoTable->FindRow<FDropItem>(NameItem, "", false);
 		if (DropItemInfoRow)
 		{
 			bIsFind = true;
@@ -41,7 +43,7 @@ bool UTopDownShooterGameInstance::GetDropItemInfoByName(FName NameItem, FDropIte
 	}
 	else
 	{
-		UE_LOG(LogTemp, Warning, TEXT("UTPSGameInstance::GetWeaponInfoByName - WeaponTable -NULL"));
+		UE_LOG(LogTemp, Warning, TEXT("UTPSGameInstance::GetDropItemInfoByName - DropItemInfoTable -NULL"));
 	}
 
 	return bIsFind;
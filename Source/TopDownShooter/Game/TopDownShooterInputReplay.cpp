@@ -0,0 +1,343 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterInputReplay.h"
+#include "Character/TopDownShooterCharacter.h"
+#include "Engine/Engine.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/Archive.h"
+
+namespace InputReplay
+{
+	static const uint32 FileMagic = 0x52534454; //"TDSR"
+	static const int32 FileVersion = 2;
+
+	UTopDownShooterInputReplay* Get(UWorld* World)
+	{
+		UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+		return GameInstance ? GameInstance->GetSubsystem<UTopDownShooterInputReplay>() : nullptr;
+	}
+
+	FString ResolvePath(const FString& FileName)
+	{
+		//bare names go to Saved/InputReplays
+		if (FPaths::IsRelative(FileName) && FPaths::GetPath(FileName).IsEmpty())
+			return FPaths::ProjectSavedDir() / TEXT("InputReplays") / FPaths::SetExtension(FileName, TEXT("tdsreplay"));
+		return FileName;
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInputReplayRecord(TEXT("TPS.InputReplay.Record"), TEXT("TPS.InputReplay.Record <File> - start recording player input"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTopDownShooterInputReplay* myInputReplay = InputReplay::Get(World))
+			myInputReplay->StartRecording(Args.Num() > 0 ? Args[0] : FString(TEXT("Default")));
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInputReplayPlay(TEXT("TPS.InputReplay.Play"), TEXT("TPS.InputReplay.Play <File> - replay recorded input at fixed timestep"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTopDownShooterInputReplay* myInputReplay = InputReplay::Get(World))
+			myInputReplay->StartReplay(Args.Num() > 0 ? Args[0] : FString(TEXT("Default")));
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdInputReplayStop(TEXT("TPS.InputReplay.Stop"), TEXT("Stop recording (and save) or replaying input"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTopDownShooterInputReplay* myInputReplay = InputReplay::Get(World))
+			myInputReplay->Stop();
+	}));
+
+FArchive& operator<<(FArchive& Ar, FInputReplayFrame& Frame)
+{
+	Ar << Frame.AxisX;
+	Ar << Frame.AxisY;
+	Ar << Frame.Actions;
+	Ar << Frame.bHasCursorHit;
+	if (Frame.bHasCursorHit)
+		Ar << Frame.CursorHit;
+	Ar << Frame.WeaponSeeds;
+	return Ar;
+}
+
+void UTopDownShooterInputReplay::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	FParse::Value(FCommandLine::Get(), TEXT("TPSReplayFPS="), FixedFrameRate);
+	FixedFrameRate = FMath::Max(FixedFrameRate, 1);
+	bExitWhenDone = FParse::Param(FCommandLine::Get(), TEXT("TPSReplayExit"));
+
+	FString myFileName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("TPSReplayInput="), myFileName))
+		StartReplay(myFileName);
+	else if (FParse::Value(FCommandLine::Get(), TEXT("TPSRecordInput="), myFileName))
+		StartRecording(myFileName);
+}
+
+void UTopDownShooterInputReplay::Deinitialize()
+{
+	Stop();
+
+	Super::Deinitialize();
+}
+
+void UTopDownShooterInputReplay::StartRecording(const FString& FileName)
+{
+	Stop();
+
+	FilePath = InputReplay::ResolvePath(FileName);
+	Frames.Reset();
+	//loading frames are not counted, frame 0 is the first one gameplay touches the replay
+	bFrameStarted = false;
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("TPSSeed="), SessionSeed))
+		SessionSeed = int32(FPlatformTime::Cycles());
+	ApplySessionSeed();
+
+	//fixed step that still waits for real time, so a human can play while recording
+	if (GEngine)
+	{
+		GEngine->bUseFixedFrameRate = true;
+		GEngine->FixedFrameRate = FixedFrameRate;
+	}
+
+	bRecording = true;
+	UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::StartRecording - %s, seed %d, %d fps"), *FilePath, SessionSeed, FixedFrameRate);
+}
+
+bool UTopDownShooterInputReplay::StartReplay(const FString& FileName)
+{
+	Stop();
+
+	FilePath = InputReplay::ResolvePath(FileName);
+	TUniquePtr<FArchive> Reader(IFileManager::Get().CreateFileReader(*FilePath));
+	if (!Reader)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::StartReplay - can't open %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = 0;
+	int32 Version = 0;
+	*Reader << Magic;
+	*Reader << Version;
+	if (Magic != InputReplay::FileMagic || Version != InputReplay::FileVersion)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::StartReplay - %s is not a replay of version %d"), *FilePath, InputReplay::FileVersion);
+		return false;
+	}
+
+	*Reader << SessionSeed;
+	*Reader << FixedFrameRate;
+	*Reader << Frames;
+	if (Reader->IsError() || !Reader->Close())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::StartReplay - %s is corrupted"), *FilePath);
+		Frames.Reset();
+		return false;
+	}
+
+	bFrameStarted = false;
+	AppliedFrameCounter = 0;
+	ReplaySeedFrame = INDEX_NONE;
+	ReplaySeedCursor = 0;
+	ApplySessionSeed();
+
+	//fixed step without waiting, headless replays run as fast as the game thread allows
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FixedFrameRate);
+
+	bReplaying = true;
+	UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::StartReplay - %s, seed %d, %d frames at %d fps"), *FilePath, SessionSeed, Frames.Num(), FixedFrameRate);
+	return true;
+}
+
+void UTopDownShooterInputReplay::Stop()
+{
+	if (bRecording)
+	{
+		bRecording = false;
+		if (GEngine)
+			GEngine->bUseFixedFrameRate = false;
+
+		if (WriteFile())
+			UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::Stop - saved %d frames to %s"), Frames.Num(), *FilePath);
+	}
+
+	if (bReplaying)
+	{
+		bReplaying = false;
+		FApp::SetUseFixedTimeStep(false);
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::Stop - replay of %s stopped after %d frames"), *FilePath, bFrameStarted ? GetFrameIndex() : 0);
+	}
+
+	Frames.Reset();
+}
+
+bool UTopDownShooterInputReplay::WriteFile() const
+{
+	TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*FilePath));
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::WriteFile - can't write %s"), *FilePath);
+		return false;
+	}
+
+	uint32 Magic = InputReplay::FileMagic;
+	int32 Version = InputReplay::FileVersion;
+	int32 mySeed = SessionSeed;
+	int32 myFrameRate = FixedFrameRate;
+	*Writer << Magic;
+	*Writer << Version;
+	*Writer << mySeed;
+	*Writer << myFrameRate;
+	*Writer << const_cast<TArray<FInputReplayFrame>&>(Frames);
+	return Writer->Close();
+}
+
+void UTopDownShooterInputReplay::ApplySessionSeed()
+{
+	//global RNG is used by drop meshes and blueprints, weapons get their own seeds below
+	FMath::RandInit(SessionSeed);
+	FMath::SRandInit(SessionSeed);
+	WeaponSeedCounter = 0;
+}
+
+bool UTopDownShooterInputReplay::IsDrivenCharacter(const ATopDownShooterCharacter* Character) const
+{
+	if (!Character || !Character->IsLocallyControlled())
+		return false;
+
+	const APlayerController* myPC = GetGameInstance()->GetFirstLocalPlayerController(Character->GetWorld());
+	return myPC && myPC->GetPawn() == Character;
+}
+
+int32 UTopDownShooterInputReplay::GetFrameIndex()
+{
+	//the first call comes from the world's BeginPlay or the driven character's first tick, the same frame when recording and replaying
+	if (!bFrameStarted)
+	{
+		StartFrameCounter = GFrameCounter;
+		bFrameStarted = true;
+	}
+	return int32(GFrameCounter - StartFrameCounter);
+}
+
+FInputReplayFrame& UTopDownShooterInputReplay::GetRecordFrame()
+{
+	//one entry per engine frame since gameplay started, frames without input stay empty
+	const int32 FrameIndex = GetFrameIndex();
+	if (Frames.Num() <= FrameIndex)
+		Frames.SetNum(FrameIndex + 1);
+	return Frames[FrameIndex];
+}
+
+const FInputReplayFrame* UTopDownShooterInputReplay::GetReplayFrame()
+{
+	const int32 FrameIndex = GetFrameIndex();
+	if (Frames.IsValidIndex(FrameIndex))
+		return &Frames[FrameIndex];
+
+	UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::GetReplayFrame - replay finished"));
+	Stop();
+	if (bExitWhenDone)
+		FPlatformMisc::RequestExit(false);
+	return nullptr;
+}
+
+void UTopDownShooterInputReplay::RecordAxis(float AxisX, float AxisY)
+{
+	if (!bRecording)
+		return;
+
+	FInputReplayFrame& Frame = GetRecordFrame();
+	Frame.AxisX = AxisX;
+	Frame.AxisY = AxisY;
+}
+
+void UTopDownShooterInputReplay::RecordAction(EInputReplayAction Action)
+{
+	if (bRecording)
+		GetRecordFrame().Actions |= uint8(Action);
+}
+
+void UTopDownShooterInputReplay::RecordCursorHit(const FVector& CursorHit)
+{
+	if (!bRecording)
+		return;
+
+	FInputReplayFrame& Frame = GetRecordFrame();
+	Frame.bHasCursorHit = true;
+	Frame.CursorHit = CursorHit;
+}
+
+void UTopDownShooterInputReplay::ApplyFrame(ATopDownShooterCharacter* Character)
+{
+	//once per frame, the character can tick again after a hitch
+	if (!bReplaying || AppliedFrameCounter == GFrameCounter)
+		return;
+	AppliedFrameCounter = GFrameCounter;
+
+	const FInputReplayFrame* Frame = GetReplayFrame();
+	if (!Frame)
+		return;
+
+	Character->AxisX = Frame->AxisX;
+	Character->AxisY = Frame->AxisY;
+
+	//same order the input component would have fired them
+	if (Frame->Actions & uint8(EInputReplayAction::FirePressed))
+		Character->InputAttackPressed();
+	if (Frame->Actions & uint8(EInputReplayAction::FireReleased))
+		Character->InputAttackReleased();
+	if (Frame->Actions & uint8(EInputReplayAction::Reload))
+		Character->InputReloadReleased();
+	if (Frame->Actions & uint8(EInputReplayAction::SwitchNext))
+		Character->InputSwitchNextPressed();
+	if (Frame->Actions & uint8(EInputReplayAction::SwitchPrevios))
+		Character->InputSwitchPreviosPressed();
+}
+
+bool UTopDownShooterInputReplay::GetReplayCursorHit(FVector& OutCursorHit)
+{
+	if (!bReplaying)
+		return false;
+
+	const int32 FrameIndex = GetFrameIndex();
+	if (!Frames.IsValidIndex(FrameIndex) || !Frames[FrameIndex].bHasCursorHit)
+		return false;
+
+	OutCursorHit = Frames[FrameIndex].CursorHit;
+	return true;
+}
+
+int32 UTopDownShooterInputReplay::GetWeaponSeed()
+{
+	if (bReplaying)
+	{
+		const int32 FrameIndex = GetFrameIndex();
+		if (ReplaySeedFrame != FrameIndex)
+		{
+			ReplaySeedFrame = FrameIndex;
+			ReplaySeedCursor = 0;
+		}
+		if (Frames.IsValidIndex(FrameIndex) && Frames[FrameIndex].WeaponSeeds.IsValidIndex(ReplaySeedCursor))
+			return Frames[FrameIndex].WeaponSeeds[ReplaySeedCursor++];
+
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterInputReplay::GetWeaponSeed - replay diverged, no seed recorded for frame %d"), FrameIndex);
+	}
+
+	const int32 Seed = int32(HashCombine(uint32(SessionSeed), uint32(WeaponSeedCounter++)));
+	if (bRecording)
+		GetRecordFrame().WeaponSeeds.Add(Seed);
+	return Seed;
+}
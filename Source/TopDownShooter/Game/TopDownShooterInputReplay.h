@@ -0,0 +1,92 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "TopDownShooterInputReplay.generated.h"
+
+class ATopDownShooterCharacter;
+
+enum class EInputReplayAction : uint8
+{
+	FirePressed = 1 << 0,
+	FireReleased = 1 << 1,
+	Reload = 1 << 2,
+	SwitchNext = 1 << 3,
+	SwitchPrevios = 1 << 4,
+};
+
+//Everything the player character consumed during one frame
+struct FInputReplayFrame
+{
+	float AxisX = 0.0f;
+	float AxisY = 0.0f;
+	uint8 Actions = 0;
+	bool bHasCursorHit = false;
+	FVector CursorHit = FVector::ZeroVector;
+	//seeds handed to weapons spawned this frame
+	TArray<int32> WeaponSeeds;
+
+	friend FArchive& operator<<(FArchive& Ar, FInputReplayFrame& Frame);
+};
+
+/**
+ * Records the input of the first local player into a file and plays it back at a fixed timestep,
+ * so identical gameplay can be profiled across builds (e.g. under -nullrhi).
+ * -TPSRecordInput=<file> records, -TPSReplayInput=<file> replays, -TPSReplayExit quits when done.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterInputReplay : public UGameInstanceSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	void StartRecording(const FString& FileName);
+	bool StartReplay(const FString& FileName);
+	void Stop();
+
+	bool IsRecording() const { return bRecording; }
+	bool IsReplaying() const { return bReplaying; }
+	//only the first local player's character is recorded or driven
+	bool IsDrivenCharacter(const ATopDownShooterCharacter* Character) const;
+
+	//Record
+	void RecordAxis(float AxisX, float AxisY);
+	void RecordAction(EInputReplayAction Action);
+	void RecordCursorHit(const FVector& CursorHit);
+
+	//Replay: feeds the current frame into the character
+	void ApplyFrame(ATopDownShooterCharacter* Character);
+	bool GetReplayCursorHit(FVector& OutCursorHit);
+
+	//Seed for a newly spawned weapon, recorded or taken from the replay
+	int32 GetWeaponSeed();
+
+private:
+	//engine frames since the first one that recorded or replayed anything
+	int32 GetFrameIndex();
+	FInputReplayFrame& GetRecordFrame();
+	const FInputReplayFrame* GetReplayFrame();
+	void ApplySessionSeed();
+	bool WriteFile() const;
+
+	bool bRecording = false;
+	bool bReplaying = false;
+	bool bExitWhenDone = false;
+
+	FString FilePath;
+	int32 SessionSeed = 0;
+	int32 FixedFrameRate = 60;
+	int32 WeaponSeedCounter = 0;
+
+	TArray<FInputReplayFrame> Frames;
+	uint64 StartFrameCounter = 0;
+	bool bFrameStarted = false;
+	uint64 AppliedFrameCounter = 0;
+	int32 ReplaySeedCursor = 0;
+	int32 ReplaySeedFrame = INDEX_NONE;
+};
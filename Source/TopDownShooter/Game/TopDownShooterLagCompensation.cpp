@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterLagCompensation.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerState.h"
+#include "Components/CapsuleComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "HAL/IConsoleManager.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+int32 LagCompensationEnabled = 1;
+FAutoConsoleVariableRef CVARLagCompensationEnabled(TEXT("TPS.LagCompensation"), LagCompensationEnabled, TEXT("Resolve hitscan shots of remote players against the capsule history"), ECVF_Default);
+
+int32 LagCompensationHistoryFrames = 120;
+FAutoConsoleVariableRef CVARLagCompensationHistoryFrames(TEXT("TPS.LagCompensation.HistoryFrames"), LagCompensationHistoryFrames, TEXT("Number of server frames kept for rewind"), ECVF_Default);
+
+float LagCompensationMaxRewind = 0.4f;
+FAutoConsoleVariableRef CVARLagCompensationMaxRewind(TEXT("TPS.LagCompensation.MaxRewind"), LagCompensationMaxRewind, TEXT("Max seconds a shot can be rewound"), ECVF_Default);
+
+int32 DebugLagCompensationShow = 0;
+FAutoConsoleVariableRef CVARDebugLagCompensationShow(TEXT("TPS.DebugLagCompensation"), DebugLagCompensationShow, TEXT("Draw rewound (green) and current (red) capsules for compensated shots"), ECVF_Cheat);
+
+void UTopDownShooterLagCompensation::Deinitialize()
+{
+	TrackedCharacters.Empty();
+	History.Empty();
+	HistoryHead = INDEX_NONE;
+	HistoryNum = 0;
+
+	Super::Deinitialize();
+}
+
+void UTopDownShooterLagCompensation::Tick(float DeltaTime)
+{
+	RecordFrame();
+}
+
+bool UTopDownShooterLagCompensation::IsTickable() const
+{
+	//history is only needed where shots of remote players are resolved
+	const UWorld* World = GetWorld();
+	return LagCompensationEnabled && !HasAnyFlags(RF_ClassDefaultObject) && World && World->IsGameWorld()
+		&& (World->GetNetMode() == NM_ListenServer || World->GetNetMode() == NM_DedicatedServer);
+}
+
+TStatId UTopDownShooterLagCompensation::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterLagCompensation, STATGROUP_Tickables);
+}
+
+void UTopDownShooterLagCompensation::RegisterCharacter(ACharacter* Character)
+{
+	if (Character)
+		TrackedCharacters.AddUnique(Character);
+}
+
+void UTopDownShooterLagCompensation::UnregisterCharacter(ACharacter* Character)
+{
+	TrackedCharacters.RemoveSwap(Character);
+}
+
+void UTopDownShooterLagCompensation::GetTrackedActors(TArray<AActor*>& OutActors) const
+{
+	for (const TWeakObjectPtr<ACharacter>& Character : TrackedCharacters)
+	{
+		if (Character.IsValid())
+			OutActors.Add(Character.Get());
+	}
+}
+
+bool UTopDownShooterLagCompensation::ShouldRewindFor(const AController* ShooterController) const
+{
+	return IsTickable() && HistoryNum > 0 && ShooterController && ShooterController->PlayerState && !ShooterController->IsLocalController();
+}
+
+float UTopDownShooterLagCompensation::ClampShooterViewTime(float ClientTimestamp) const
+{
+	//never trust a timestamp from the future or older than the rewind window
+	const float Now = GetWorld()->GetTimeSeconds();
+	return FMath::Clamp(ClientTimestamp, Now - LagCompensationMaxRewind, Now);
+}
+
+void UTopDownShooterLagCompensation::RecordFrame()
+{
+	const int32 Capacity = FMath::Max(LagCompensationHistoryFrames, 2);
+	if (History.Num() != Capacity)
+	{
+		History.SetNum(Capacity);
+		HistoryHead = INDEX_NONE;
+		HistoryNum = 0;
+	}
+
+	HistoryHead = (HistoryHead + 1) % Capacity;
+	HistoryNum = FMath::Min(HistoryNum + 1, Capacity);
+
+	FLagCompensationFrame& Frame = History[HistoryHead];
+	Frame.Time = GetWorld()->GetTimeSeconds();
+	Frame.Capsules.Reset();
+	Frame.Owners.Reset();
+
+	for (int32 i = TrackedCharacters.Num() - 1; i >= 0; i--)
+	{
+		ACharacter* Character = TrackedCharacters[i].Get();
+		if (!Character)
+		{
+			TrackedCharacters.RemoveAtSwap(i);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		if (Capsule)
+		{
+			Frame.Capsules.Add(Capsule->GetComponentLocation(), Capsule->GetUpVector(), Capsule->GetScaledCapsuleHalfHeight(), Capsule->GetScaledCapsuleRadius());
+			Frame.Owners.Add(Character);
+		}
+	}
+}
+
+const FLagCompensationFrame* UTopDownShooterLagCompensation::GetFrame(int32 Age) const
+{
+	if (Age < 0 || Age >= HistoryNum)
+		return nullptr;
+	return &History[(HistoryHead - Age + History.Num()) % History.Num()];
+}
+
+void UTopDownShooterLagCompensation::BuildRewoundCapsules(float Timestamp, const AActor* IgnoredActor)
+{
+	RewoundCapsules.Reset();
+	RewoundOwners.Reset();
+
+	//find the two frames around Timestamp, newest first
+	const FLagCompensationFrame* Newer = GetFrame(0);
+	const FLagCompensationFrame* Older = Newer;
+	int32 Age = 1;
+	while (Older && Older->Time > Timestamp)
+	{
+		const FLagCompensationFrame* Next = GetFrame(Age++);
+		if (!Next)
+			break;
+		Newer = Older;
+		Older = Next;
+	}
+
+	if (!Newer)
+		return;
+
+	const float Span = Newer->Time - Older->Time;
+	const float Alpha = Span > KINDA_SMALL_NUMBER ? FMath::Clamp((Timestamp - Older->Time) / Span, 0.0f, 1.0f) : 1.0f;
+
+	for (int32 i = 0; i < Newer->Owners.Num(); i++)
+	{
+		ACharacter* Character = Newer->Owners[i].Get();
+		if (!Character || Character == IgnoredActor)
+			continue;
+
+		const FVector NewerStart = Newer->Capsules.GetSegmentStart(i);
+		const FVector NewerAxis = Newer->Capsules.GetSegmentAxis(i);
+		FVector Center = NewerStart + NewerAxis * 0.5f;
+		FVector Axis = NewerAxis;
+
+		//frames are recorded in the same order unless characters joined or left in between
+		int32 OlderIndex = Older->Owners.IsValidIndex(i) && Older->Owners[i] == Newer->Owners[i] ? i : Older->Owners.IndexOfByKey(Newer->Owners[i]);
+		if (OlderIndex != INDEX_NONE)
+		{
+			const FVector OlderAxis = Older->Capsules.GetSegmentAxis(OlderIndex);
+			Center = FMath::Lerp(Older->Capsules.GetSegmentStart(OlderIndex) + OlderAxis * 0.5f, Center, Alpha);
+			Axis = FMath::Lerp(OlderAxis, NewerAxis, Alpha);
+		}
+
+		const float CapRadius = Newer->Capsules.Radius[i];
+		RewoundCapsules.Add(Center, Axis.GetSafeNormal(SMALL_NUMBER, FVector::UpVector), Axis.Size() * 0.5f + CapRadius, CapRadius);
+		RewoundOwners.Add(Character);
+	}
+}
+
+bool UTopDownShooterLagCompensation::RewindLineTrace(float Timestamp, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FHitResult& OutHit)
+{
+	BuildRewoundCapsules(Timestamp, IgnoredActor);
+	TPS_COUNT_TRACES(RewindTraces, 1);
+
+	if (DebugLagCompensationShow)
+	{
+		for (int32 i = 0; i < RewoundCapsules.Num(); i++)
+		{
+			const float CapRadius = RewoundCapsules.Radius[i];
+			const FVector Axis = RewoundCapsules.GetSegmentAxis(i);
+			DrawDebugCapsule(GetWorld(), RewoundCapsules.GetCenter(i), Axis.Size() * 0.5f + CapRadius, CapRadius, FRotationMatrix::MakeFromZ(Axis.GetSafeNormal(SMALL_NUMBER, FVector::UpVector)).ToQuat(), FColor::Green, false, 5.0f);
+
+			const UCapsuleComponent* Capsule = RewoundOwners[i]->GetCapsuleComponent();
+			DrawDebugCapsule(GetWorld(), Capsule->GetComponentLocation(), Capsule->GetScaledCapsuleHalfHeight(), Capsule->GetScaledCapsuleRadius(), Capsule->GetComponentQuat(), FColor::Red, false, 5.0f);
+		}
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterLagCompensation::RewindLineTrace - rewind %.1f ms, %d capsules"), (GetWorld()->GetTimeSeconds() - Timestamp) * 1000.0f, RewoundCapsules.Num());
+	}
+
+	int32 HitIndex = INDEX_NONE;
+	float HitTime = 1.0f;
+	if (!CapsuleRaycast::RaycastNearest(RewoundCapsules, Start, End, HitIndex, HitTime))
+		return false;
+
+	ACharacter* HitCharacter = RewoundOwners[HitIndex];
+	UCapsuleComponent* HitCapsule = HitCharacter->GetCapsuleComponent();
+	const FVector ImpactPoint = FMath::Lerp(Start, End, HitTime);
+	const FVector ImpactNormal = CapsuleRaycast::GetSurfaceNormal(RewoundCapsules, HitIndex, ImpactPoint);
+
+	OutHit = FHitResult(HitCharacter, HitCapsule, ImpactPoint, ImpactNormal);
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	OutHit.Time = HitTime;
+	OutHit.Distance = (End - Start).Size() * HitTime;
+	OutHit.Location = ImpactPoint;
+	OutHit.bBlockingHit = true;
+	if (HitCapsule)
+		OutHit.PhysMaterial = HitCapsule->GetBodyInstance()->GetSimplePhysicalMaterial();
+
+	return true;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FuncLibrary/CapsuleRaycast.h"
+#include "TopDownShooterLagCompensation.generated.h"
+
+class ACharacter;
+
+//Capsules of all tracked characters at one server frame
+struct FLagCompensationFrame
+{
+	float Time = 0.0f;
+	FCapsuleSoA Capsules;
+	TArray<TWeakObjectPtr<ACharacter>> Owners;
+};
+
+/**
+ * Server side lag compensation. Records the collision capsule of every character into a ring buffer
+ * each frame so hitscan shots can be tested against where targets were when the shooter saw them.
+ * Rewind never moves physics bodies, shots are tested against the history with SIMD ray-vs-capsule.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterLagCompensation : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	void RegisterCharacter(ACharacter* Character);
+	void UnregisterCharacter(ACharacter* Character);
+	void GetTrackedActors(TArray<AActor*>& OutActors) const;
+
+	//true when shots from this controller must be resolved against history (server, remote player)
+	bool ShouldRewindFor(const AController* ShooterController) const;
+	//server time the shooter reported seeing, limited to the rewind window
+	float ClampShooterViewTime(float ClientTimestamp) const;
+
+	//Trace Start -> End against character capsules as they were at Timestamp
+	bool RewindLineTrace(float Timestamp, const FVector& Start, const FVector& End, const AActor* IgnoredActor, FHitResult& OutHit);
+
+private:
+	void RecordFrame();
+	const FLagCompensationFrame* GetFrame(int32 Age) const;
+	void BuildRewoundCapsules(float Timestamp, const AActor* IgnoredActor);
+
+	TArray<TWeakObjectPtr<ACharacter>> TrackedCharacters;
+
+	//ring buffer, HistoryHead is the newest frame
+	TArray<FLagCompensationFrame> History;
+	int32 HistoryHead = INDEX_NONE;
+	int32 HistoryNum = 0;
+
+	//scratch for a single rewind query
+	FCapsuleSoA RewoundCapsules;
+	TArray<ACharacter*> RewoundOwners;
+};
@@ -0,0 +1,146 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterPawnHitGrid.h"
+#include "Horde/TopDownShooterHorde.h"
+#include "Horde/HordeEnemyActor.h"
+#include "GameFramework/Pawn.h"
+#include "Components/CapsuleComponent.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+#include "Kismet/GameplayStatics.h"
+#include "HAL/IConsoleManager.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pawn Hit Grid Build"), STAT_TPS_PawnHitGridBuild, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Pawn Hit Grid Query"), STAT_TPS_PawnHitGridQuery, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pawn Hit Grid Capsules"), STAT_TPS_PawnHitGridCapsules, STATGROUP_TopDownShooter);
+
+int32 PawnHitGridEnabled = 1;
+FAutoConsoleVariableRef CVARPawnHitGridEnabled(TEXT("TPS.PawnHitGrid"), PawnHitGridEnabled, TEXT("Hit pawns and horde enemies through the capsule spatial hash, physics traces only see world geometry"), ECVF_Default);
+
+float PawnHitGridCellSize = 250.0f;
+FAutoConsoleVariableRef CVARPawnHitGridCellSize(TEXT("TPS.PawnHitGrid.CellSize"), PawnHitGridCellSize, TEXT("Cell size of the pawn hit grid"), ECVF_Default);
+
+float PawnHitGridMaxSweepRadius = 64.0f;
+FAutoConsoleVariableRef CVARPawnHitGridMaxSweepRadius(TEXT("TPS.PawnHitGrid.MaxSweepRadius"), PawnHitGridMaxSweepRadius, TEXT("Biggest projectile radius the pawn hit grid is built for"), ECVF_Default);
+
+void UTopDownShooterPawnHitGrid::Deinitialize()
+{
+	Hash.Reset();
+	Capsules.Reset();
+	CapsuleComponents.Empty();
+	CapsuleHordeIds.Empty();
+	BuiltFrame = MAX_uint64;
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterPawnHitGrid::IsEnabled()
+{
+	return PawnHitGridEnabled != 0;
+}
+
+void UTopDownShooterPawnHitGrid::EnsureBuilt()
+{
+	check(IsInGameThread());
+	if (BuiltFrame != GFrameCounter)
+	{
+		Build();
+		BuiltFrame = GFrameCounter;
+	}
+}
+
+void UTopDownShooterPawnHitGrid::Build()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_PawnHitGridBuild);
+
+	Capsules.Reset();
+	CapsuleComponents.Reset();
+	CapsuleHordeIds.Reset();
+
+	UWorld* myWorld = GetWorld();
+	for (TActorIterator<APawn> It(myWorld); It; ++It)
+	{
+		UCapsuleComponent* myCapsule = Cast<UCapsuleComponent>(It->GetRootComponent());
+		if (!myCapsule || It->IsPendingKill() || !CollisionEnabledHasQuery(myCapsule->GetCollisionEnabled()))
+			continue;
+
+		Capsules.Add(myCapsule->GetComponentLocation(), myCapsule->GetUpVector(), myCapsule->GetScaledCapsuleHalfHeight(), myCapsule->GetScaledCapsuleRadius());
+		CapsuleComponents.Add(myCapsule);
+		CapsuleHordeIds.Add(0);
+	}
+
+	//every entity, the ones with a proxy report the proxy's capsule
+	if (const UTopDownShooterHorde* myHorde = myWorld->GetSubsystem<UTopDownShooterHorde>())
+	{
+		const FHordeEntities& myEntities = myHorde->GetEntities();
+		float EntityRadius = 0.0f;
+		float EntityHalfHeight = 0.0f;
+		myHorde->GetEntityCapsuleSize(EntityRadius, EntityHalfHeight);
+
+		for (int32 i = 0; i < myEntities.Num(); i++)
+		{
+			if (myEntities.State[i] == EHordeEntityState::Dead)
+				continue;
+
+			AHordeEnemyActor* myProxy = myHorde->GetEntityProxy(i);
+			Capsules.Add(myEntities.GetLocation(i), FVector::UpVector, EntityHalfHeight, EntityRadius);
+			CapsuleComponents.Add(myProxy ? myProxy->CollisionCapsule : nullptr);
+			CapsuleHordeIds.Add(myEntities.Ids[i]);
+		}
+	}
+
+	Hash.Build(Capsules, PawnHitGridCellSize, PawnHitGridMaxSweepRadius);
+	SET_DWORD_STAT(STAT_TPS_PawnHitGridCapsules, Capsules.Num());
+}
+
+bool UTopDownShooterPawnHitGrid::SweepPawns(const FVector& Start, const FVector& End, float Radius, const TArray<AActor*>& IgnoredActors, FHitResult& OutHit, uint32& OutHordeEntityId) const
+{
+	OutHordeEntityId = 0;
+	SCOPE_CYCLE_COUNTER(STAT_TPS_PawnHitGridQuery);
+
+	auto IgnoreCapsule = [this, &IgnoredActors](int32 CapsuleIndex)
+	{
+		const UCapsuleComponent* myCapsule = CapsuleComponents[CapsuleIndex].Get();
+		return myCapsule && IgnoredActors.Contains(myCapsule->GetOwner());
+	};
+
+	int32 HitIndex = INDEX_NONE;
+	float HitTime = 1.0f;
+	if (!Hash.RaycastNearest(Start, End, Radius, IgnoreCapsule, HitIndex, HitTime))
+		return false;
+
+	//same layout a physics sweep gives: Location is the sphere center at contact, ImpactPoint on the capsule
+	UCapsuleComponent* HitCapsule = CapsuleComponents[HitIndex].Get();
+	const FVector Location = FMath::Lerp(Start, End, HitTime);
+	const FVector Normal = CapsuleRaycast::GetSurfaceNormal(Capsules, HitIndex, Location);
+
+	OutHit = FHitResult(HitCapsule ? HitCapsule->GetOwner() : nullptr, HitCapsule, Location, Normal);
+	OutHit.ImpactPoint = Location - Normal * FMath::Clamp(Radius, 0.0f, Hash.GetMaxInflate());
+	OutHit.TraceStart = Start;
+	OutHit.TraceEnd = End;
+	OutHit.Time = HitTime;
+	OutHit.Distance = (End - Start).Size() * HitTime;
+	OutHit.bBlockingHit = true;
+	if (HitCapsule)
+		OutHit.PhysMaterial = HitCapsule->GetBodyInstance()->GetSimplePhysicalMaterial();
+	else
+		OutHordeEntityId = CapsuleHordeIds[HitIndex];
+
+	return true;
+}
+
+void UTopDownShooterPawnHitGrid::ApplyHitDamage(UWorld* World, const FHitResult& Hit, uint32 HordeEntityId, float Damage, AController* EventInstigator, AActor* DamageCauser)
+{
+	if (Hit.GetActor())
+	{
+		UGameplayStatics::ApplyDamage(Hit.GetActor(), Damage, EventInstigator, DamageCauser, NULL);
+	}
+	else if (HordeEntityId != 0)
+	{
+		if (UTopDownShooterHorde* myHorde = World ? World->GetSubsystem<UTopDownShooterHorde>() : nullptr)
+			myHorde->ApplyDamageToEntity(HordeEntityId, Damage, EventInstigator, DamageCauser);
+	}
+}
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FuncLibrary/CapsuleSpatialHash.h"
+#include "TopDownShooterPawnHitGrid.generated.h"
+
+class UCapsuleComponent;
+
+/**
+ * Spatial hash of every pawn capsule and every horde entity, so shots against crowds do not go through the physics scene.
+ * Weapons and projectiles test their segment here first and trace physics for world geometry only (pawns ignored).
+ * Rebuilt lazily by the first query of a frame; call EnsureBuilt on the game thread before querying from workers.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterPawnHitGrid : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//TPS.PawnHitGrid, off means pawns are hit by physics like before
+	static bool IsEnabled();
+
+	void EnsureBuilt();
+
+	//Nearest pawn or horde entity hit by a sphere of Radius (0 for a ray) moving Start -> End.
+	//Horde entities without a proxy actor give a hit without actor and their id in OutHordeEntityId, 0 for anything else
+	bool SweepPawns(const FVector& Start, const FVector& End, float Radius, const TArray<AActor*>& IgnoredActors, FHitResult& OutHit, uint32& OutHordeEntityId) const;
+
+	//ApplyDamage for actors, horde damage when HordeEntityId comes with a hit without one
+	static void ApplyHitDamage(UWorld* World, const FHitResult& Hit, uint32 HordeEntityId, float Damage, AController* EventInstigator, AActor* DamageCauser);
+
+private:
+	void Build();
+
+	FCapsuleSpatialHash Hash;
+	FCapsuleSoA Capsules;
+	//per capsule: the capsule component it came from (null for horde entities without proxy) and the horde entity id
+	TArray<TWeakObjectPtr<UCapsuleComponent>> CapsuleComponents;
+	TArray<uint32> CapsuleHordeIds;
+	uint64 BuiltFrame = MAX_uint64;
+};
@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterSpawnQueue.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "Engine/Engine.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Queue"), STAT_TPS_SpawnQueue, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Depth"), STAT_TPS_SpawnQueueDepth, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Run"), STAT_TPS_SpawnQueueRun, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Dropped"), STAT_TPS_SpawnQueueDropped, STATGROUP_TopDownShooter);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Spawn Queue Max Latency (ms)"), STAT_TPS_SpawnQueueLatency, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Spawn Queue Max Latency (frames)"), STAT_TPS_SpawnQueueLatencyFrames, STATGROUP_TopDownShooter);
+
+int32 SpawnQueueEnabled = 1;
+FAutoConsoleVariableRef CVARSpawnQueueEnabled(TEXT("TPS.SpawnQueue"), SpawnQueueEnabled, TEXT("Defer cosmetic spawns (debris, impact decals and emitters) to a budgeted queue, off spawns them where they are requested"), ECVF_Default);
+
+float SpawnQueueBudgetMs = 1.0f;
+FAutoConsoleVariableRef CVARSpawnQueueBudgetMs(TEXT("TPS.SpawnQueue.BudgetMs"), SpawnQueueBudgetMs, TEXT("Milliseconds per frame the spawn queue may spend before waiting requests move to the next frame"), ECVF_Default);
+
+int32 SpawnQueueMaxDelay = 2;
+FAutoConsoleVariableRef CVARSpawnQueueMaxDelay(TEXT("TPS.SpawnQueue.MaxDelay"), SpawnQueueMaxDelay, TEXT("Default frames a queued spawn may wait, cosmetic ones are dropped after"), ECVF_Default);
+
+static bool SpawnRequestFirst(const FSpawnRequest& A, const FSpawnRequest& B)
+{
+	if (A.Priority != B.Priority)
+		return A.Priority < B.Priority;
+	if (A.DeadlineFrame != B.DeadlineFrame)
+		return A.DeadlineFrame < B.DeadlineFrame;
+	return A.Sequence < B.Sequence;
+}
+
+void UTopDownShooterSpawnQueue::Deinitialize()
+{
+	//whatever is left would spawn into a world going away
+	Requests.Empty();
+	DueRequests.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterSpawnQueue::IsTickable() const
+{
+	return Requests.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UTopDownShooterSpawnQueue::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterSpawnQueue, STATGROUP_Tickables);
+}
+
+void UTopDownShooterSpawnQueue::QueueSpawn(ESpawnPriority Priority, int32 MaxDelayFrames, TFunction<void()>&& Spawn)
+{
+	check(IsInGameThread());
+
+	FSpawnRequest Request;
+	Request.Spawn = MoveTemp(Spawn);
+	Request.Priority = Priority;
+	Request.QueueFrame = GFrameCounter;
+	Request.DeadlineFrame = GFrameCounter + uint64(FMath::Max(MaxDelayFrames == INDEX_NONE ? SpawnQueueMaxDelay : MaxDelayFrames, 0));
+	Request.QueueTime = FPlatformTime::Seconds();
+	Request.Sequence = NextSequence++;
+	Requests.HeapPush(MoveTemp(Request), SpawnRequestFirst);
+}
+
+void UTopDownShooterSpawnQueue::Queue(const UObject* WorldContextObject, ESpawnPriority Priority, int32 MaxDelayFrames, TFunction<void()>&& Spawn)
+{
+	UWorld* World = SpawnQueueEnabled ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::ReturnNull) : nullptr;
+	UTopDownShooterSpawnQueue* mySpawnQueue = World ? World->GetSubsystem<UTopDownShooterSpawnQueue>() : nullptr;
+	if (mySpawnQueue)
+		mySpawnQueue->QueueSpawn(Priority, MaxDelayFrames, MoveTemp(Spawn));
+	else
+		Spawn();
+}
+
+void UTopDownShooterSpawnQueue::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_SpawnQueue);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, SpawnQueue);
+
+	const uint64 Frame = GFrameCounter;
+	const double StartTime = FPlatformTime::Seconds();
+	const double EndTime = StartTime + FMath::Max(SpawnQueueBudgetMs, 0.0f) * 0.001;
+	RunNum = 0;
+	DroppedNum = 0;
+	MaxLatencyMs = 0.0;
+	MaxLatencyFrames = 0;
+
+	//spawns may queue more spawns, they land in the heap and run this frame if the budget allows
+	double Now = StartTime;
+	while (Requests.Num() > 0 && Now < EndTime)
+	{
+		FSpawnRequest Request;
+		Requests.HeapPop(Request, SpawnRequestFirst, false);
+		if (Request.Priority == ESpawnPriority::Cosmetic && Request.DeadlineFrame < Frame)
+			Drop(Request);
+		else
+			Run(Request, Frame, Now);
+		Now = FPlatformTime::Seconds();
+	}
+
+	//over budget: what reached its deadline cannot wait for the next frame
+	if (Requests.Num() > 0)
+	{
+		DueRequests.Reset();
+		for (int32 i = Requests.Num() - 1; i >= 0; i--)
+		{
+			if (Requests[i].DeadlineFrame > Frame)
+				continue;
+			DueRequests.Add(MoveTemp(Requests[i]));
+			Requests.RemoveAtSwap(i, 1, false);
+		}
+		Requests.Heapify(SpawnRequestFirst);
+
+		for (FSpawnRequest& Request : DueRequests)
+		{
+			if (Request.Priority == ESpawnPriority::Cosmetic)
+				Drop(Request);
+			else
+				Run(Request, Frame, FPlatformTime::Seconds());
+		}
+		DueRequests.Reset();
+	}
+
+	SET_DWORD_STAT(STAT_TPS_SpawnQueueDepth, Requests.Num());
+	SET_DWORD_STAT(STAT_TPS_SpawnQueueRun, RunNum);
+	SET_DWORD_STAT(STAT_TPS_SpawnQueueDropped, DroppedNum);
+	SET_FLOAT_STAT(STAT_TPS_SpawnQueueLatency, MaxLatencyMs);
+	SET_DWORD_STAT(STAT_TPS_SpawnQueueLatencyFrames, MaxLatencyFrames);
+	CSV_CUSTOM_STAT(TopDownShooter, SpawnQueueDepth, Requests.Num(), ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TopDownShooter, SpawnQueueDropped, DroppedNum, ECsvCustomStatOp::Set);
+	CSV_CUSTOM_STAT(TopDownShooter, SpawnQueueLatencyMs, float(MaxLatencyMs), ECsvCustomStatOp::Set);
+}
+
+void UTopDownShooterSpawnQueue::Run(FSpawnRequest& Request, uint64 Frame, double Now)
+{
+	MaxLatencyMs = FMath::Max(MaxLatencyMs, (Now - Request.QueueTime) * 1000.0);
+	MaxLatencyFrames = FMath::Max(MaxLatencyFrames, int32(Frame - Request.QueueFrame));
+	RunNum++;
+	if (Request.Spawn)
+		Request.Spawn();
+}
+
+void UTopDownShooterSpawnQueue::Drop(FSpawnRequest& Request)
+{
+	DroppedNum++;
+	Request.Spawn = nullptr;
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TopDownShooterSpawnQueue.generated.h"
+
+//Order in which queued spawns run, Critical ones always run by their deadline, Cosmetic ones are dropped past it
+UENUM(BlueprintType)
+enum class ESpawnPriority : uint8
+{
+	Critical,
+	High,
+	Normal,
+	Cosmetic
+};
+
+//Heap entry, one deferred spawn
+struct FSpawnRequest
+{
+	TFunction<void()> Spawn;
+	ESpawnPriority Priority = ESpawnPriority::Normal;
+	uint64 DeadlineFrame = 0;
+	uint64 QueueFrame = 0;
+	double QueueTime = 0.0;
+	uint32 Sequence = 0;
+};
+
+/**
+ * Spawns of actors, emitters and decals that do not have to happen where gameplay asks for them. Requests run at the end
+ * of the frame by priority and deadline until the frame's budget (TPS.SpawnQueue.BudgetMs) is spent, the rest waits.
+ * A request still waiting at its deadline frame runs over budget, unless it is Cosmetic, then it is dropped.
+ * Game thread only.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterSpawnQueue : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//MaxDelayFrames counts frames after this one, INDEX_NONE for TPS.SpawnQueue.MaxDelay
+	void QueueSpawn(ESpawnPriority Priority, int32 MaxDelayFrames, TFunction<void()>&& Spawn);
+
+	//queues in the world of WorldContextObject, runs Spawn right away when the queue is off (TPS.SpawnQueue) or there is no world
+	static void Queue(const UObject* WorldContextObject, ESpawnPriority Priority, int32 MaxDelayFrames, TFunction<void()>&& Spawn);
+
+	int32 GetNumPending() const { return Requests.Num(); }
+
+private:
+	void Run(FSpawnRequest& Request, uint64 Frame, double Now);
+	void Drop(FSpawnRequest& Request);
+
+	TArray<FSpawnRequest> Requests;
+	uint32 NextSequence = 0;
+
+	//per tick, for the stats
+	int32 RunNum = 0;
+	int32 DroppedNum = 0;
+	double MaxLatencyMs = 0.0;
+	int32 MaxLatencyFrames = 0;
+
+	//scratch
+	TArray<FSpawnRequest> DueRequests;
+};
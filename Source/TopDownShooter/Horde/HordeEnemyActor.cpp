@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HordeEnemyActor.h"
+#include "Horde/TopDownShooterHorde.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+
+AHordeEnemyActor::AHordeEnemyActor()
+{
+	//moved by the horde, never ticks itself
+	PrimaryActorTick.bCanEverTick = false;
+
+	CollisionCapsule = CreateDefaultSubobject<UCapsuleComponent>(TEXT("Collision Capsule"));
+	CollisionCapsule->InitCapsuleSize(42.0f, 96.0f);
+	CollisionCapsule->SetCollisionProfileName(TEXT("Pawn"));
+	CollisionCapsule->SetCanEverAffectNavigation(false);
+	RootComponent = CollisionCapsule;
+
+	Mesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Mesh"));
+	Mesh->SetupAttachment(RootComponent);
+	Mesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	Mesh->SetGenerateOverlapEvents(false);
+	Mesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+
+	bReplicates = true;
+	SetReplicatingMovement(true);
+}
+
+float AHordeEnemyActor::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float ActualDamage = Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser);
+
+	if (EntityId != 0)
+	{
+		if (UTopDownShooterHorde* myHorde = GetWorld()->GetSubsystem<UTopDownShooterHorde>())
+			myHorde->ApplyDamageToEntity(EntityId, ActualDamage, EventInstigator, DamageCauser);
+	}
+
+	return ActualDamage;
+}
+
+void AHordeEnemyActor::AssignEntity(uint32 NewEntityId, const FVector& Location, const FRotator& Rotation)
+{
+	EntityId = NewEntityId;
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+	EntityAssigned_BP();
+}
+
+void AHordeEnemyActor::ReleaseEntity()
+{
+	EntityId = 0;
+	Speed = 0.0f;
+	SetActorHiddenInGame(true);
+	SetActorEnableCollision(false);
+}
+
+void AHordeEnemyActor::UpdateFromEntity(const FVector& Location, const FRotator& Rotation, float NewSpeed)
+{
+	Speed = NewSpeed;
+	SetActorLocationAndRotation(Location, Rotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
@@ -0,0 +1,43 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "HordeEnemyActor.generated.h"
+
+/**
+ * Visible, hittable stand-in for one horde entity. A small pool of these is moved onto the entities nearest to the players,
+ * the entity itself lives in UTopDownShooterHorde. Damage taken by the actor goes to the entity it currently shows.
+ */
+UCLASS(Blueprintable)
+class TOPDOWNSHOOTER_API AHordeEnemyActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AHordeEnemyActor();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class UCapsuleComponent* CollisionCapsule = nullptr;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class USkeletalMeshComponent* Mesh = nullptr;
+
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
+	//0 while the actor sits in the pool
+	uint32 EntityId = 0;
+
+	//ground speed of the entity, for the animation blueprint
+	UPROPERTY(BlueprintReadOnly, Category = "Horde")
+	float Speed = 0.0f;
+
+	void AssignEntity(uint32 NewEntityId, const FVector& Location, const FRotator& Rotation);
+	void ReleaseEntity();
+	void UpdateFromEntity(const FVector& Location, const FRotator& Rotation, float NewSpeed);
+
+	UFUNCTION(BlueprintImplementableEvent)
+	void EntityAssigned_BP();
+	UFUNCTION(BlueprintImplementableEvent)
+	void EntityAttack_BP();
+};
@@ -0,0 +1,656 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterHorde.h"
+#include "Horde/HordeEnemyActor.h"
+#include "Game/TopDownShooterFlowField.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "Kismet/GameplayStatics.h"
+#include "Components/CapsuleComponent.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Horde Tick"), STAT_TPS_Horde, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Horde Simulate"), STAT_TPS_HordeSimulate, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Horde Entities"), STAT_TPS_HordeEntities, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Horde Proxies In Use"), STAT_TPS_HordeProxies, STATGROUP_TopDownShooter);
+
+float HordeSpeed = 300.0f;
+FAutoConsoleVariableRef CVARHordeSpeed(TEXT("TPS.Horde.Speed"), HordeSpeed, TEXT("Max ground speed of horde enemies"), ECVF_Default);
+
+float HordeAcceleration = 1200.0f;
+FAutoConsoleVariableRef CVARHordeAcceleration(TEXT("TPS.Horde.Acceleration"), HordeAcceleration, TEXT("How fast horde enemies reach their chase velocity"), ECVF_Default);
+
+float HordeAttackRange = 120.0f;
+FAutoConsoleVariableRef CVARHordeAttackRange(TEXT("TPS.Horde.AttackRange"), HordeAttackRange, TEXT("Distance to the target at which horde enemies stop and attack"), ECVF_Default);
+
+float HordeAttackDamage = 10.0f;
+FAutoConsoleVariableRef CVARHordeAttackDamage(TEXT("TPS.Horde.AttackDamage"), HordeAttackDamage, TEXT("Damage of one horde attack"), ECVF_Default);
+
+float HordeAttackInterval = 1.0f;
+FAutoConsoleVariableRef CVARHordeAttackInterval(TEXT("TPS.Horde.AttackInterval"), HordeAttackInterval, TEXT("Seconds between attacks of one horde enemy"), ECVF_Default);
+
+int32 HordeProxyCount = 64;
+FAutoConsoleVariableRef CVARHordeProxyCount(TEXT("TPS.Horde.ProxyCount"), HordeProxyCount, TEXT("Max horde enemies shown by actors at once"), ECVF_Default);
+
+float HordeProxyRadius = 2500.0f;
+FAutoConsoleVariableRef CVARHordeProxyRadius(TEXT("TPS.Horde.ProxyRadius"), HordeProxyRadius, TEXT("Horde enemies closer than this to a player get an actor"), ECVF_Default);
+
+float HordeProxyAssignInterval = 0.2f;
+FAutoConsoleVariableRef CVARHordeProxyAssignInterval(TEXT("TPS.Horde.ProxyAssignInterval"), HordeProxyAssignInterval, TEXT("Seconds between reassignments of the proxy actors"), ECVF_Default);
+
+float HordeFlowFieldMinDistance = 300.0f;
+FAutoConsoleVariableRef CVARHordeFlowFieldMinDistance(TEXT("TPS.Horde.FlowFieldMinDistance"), HordeFlowFieldMinDistance, TEXT("Horde enemies farther than this from their target follow the flow field, closer ones walk straight at it"), ECVF_Default);
+
+float HordeSeparation = 80.0f;
+FAutoConsoleVariableRef CVARHordeSeparation(TEXT("TPS.Horde.Separation"), HordeSeparation, TEXT("Distance horde enemies keep from each other, 0 lets them stack"), ECVF_Default);
+
+int32 HordeSeparationMaxNeighbours = 12;
+FAutoConsoleVariableRef CVARHordeSeparationMaxNeighbours(TEXT("TPS.Horde.SeparationMaxNeighbours"), HordeSeparationMaxNeighbours, TEXT("Neighbours one horde enemy is pushed away from per frame at most"), ECVF_Default);
+
+int32 HordeParallelMin = 512;
+FAutoConsoleVariableRef CVARHordeParallelMin(TEXT("TPS.Horde.ParallelMin"), HordeParallelMin, TEXT("Entities needed before the simulation is split over worker threads"), ECVF_Default);
+
+static const int32 HordeChunkSize = 256;
+
+static uint32 GetSeparationBucket(int32 CellX, int32 CellY, uint32 BucketMask)
+{
+	return ((uint32(CellX) * 73856093u) ^ (uint32(CellY) * 19349663u)) & BucketMask;
+}
+
+static APawn* GetFirstPlayerPawn(UWorld* World)
+{
+	APlayerController* myPC = World ? UGameplayStatics::GetPlayerController(World, 0) : nullptr;
+	return myPC ? myPC->GetPawn() : nullptr;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHordeSpawn(TEXT("TPS.Horde.Spawn"), TEXT("TPS.Horde.Spawn [Count] [MinRadius] [MaxRadius] - add horde enemies around the first player"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		UTopDownShooterHorde* myHorde = World ? World->GetSubsystem<UTopDownShooterHorde>() : nullptr;
+		APawn* myPawn = GetFirstPlayerPawn(World);
+		if (!myHorde || !myPawn)
+			return;
+
+		const int32 Count = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+		const float MinRadius = Args.Num() > 1 ? FCString::Atof(*Args[1]) : 1500.0f;
+		const float MaxRadius = Args.Num() > 2 ? FCString::Atof(*Args[2]) : 6000.0f;
+		myHorde->SpawnEntities(Count, myPawn->GetActorLocation(), MinRadius, MaxRadius);
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs CmdHordeClear(TEXT("TPS.Horde.Clear"), TEXT("Remove all horde enemies"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UTopDownShooterHorde* myHorde = World ? World->GetSubsystem<UTopDownShooterHorde>() : nullptr)
+			myHorde->ClearEntities();
+	}));
+
+void FHordeEntities::Add(uint32 Id, const FVector& Location, float InHealth)
+{
+	Ids.Add(Id);
+	PosX.Add(Location.X);
+	PosY.Add(Location.Y);
+	PosZ.Add(Location.Z);
+	VelX.Add(0.0f);
+	VelY.Add(0.0f);
+	Health.Add(InHealth);
+	AttackCooldown.Add(0.0f);
+	Target.Add(INDEX_NONE);
+	TargetDistSq.Add(MAX_flt);
+	State.Add(EHordeEntityState::Idle);
+	Proxy.Add(INDEX_NONE);
+	bAttackThisFrame.Add(0);
+}
+
+void FHordeEntities::RemoveAtSwap(int32 Index)
+{
+	Ids.RemoveAtSwap(Index, 1, false);
+	PosX.RemoveAtSwap(Index, 1, false);
+	PosY.RemoveAtSwap(Index, 1, false);
+	PosZ.RemoveAtSwap(Index, 1, false);
+	VelX.RemoveAtSwap(Index, 1, false);
+	VelY.RemoveAtSwap(Index, 1, false);
+	Health.RemoveAtSwap(Index, 1, false);
+	AttackCooldown.RemoveAtSwap(Index, 1, false);
+	Target.RemoveAtSwap(Index, 1, false);
+	TargetDistSq.RemoveAtSwap(Index, 1, false);
+	State.RemoveAtSwap(Index, 1, false);
+	Proxy.RemoveAtSwap(Index, 1, false);
+	bAttackThisFrame.RemoveAtSwap(Index, 1, false);
+}
+
+void FHordeEntities::Empty()
+{
+	Ids.Empty();
+	PosX.Empty();
+	PosY.Empty();
+	PosZ.Empty();
+	VelX.Empty();
+	VelY.Empty();
+	Health.Empty();
+	AttackCooldown.Empty();
+	Target.Empty();
+	TargetDistSq.Empty();
+	State.Empty();
+	Proxy.Empty();
+	bAttackThisFrame.Empty();
+}
+
+void UTopDownShooterHorde::Deinitialize()
+{
+	Entities.Empty();
+	IndexById.Empty();
+	Targets.Empty();
+	TargetLocations.Empty();
+	Proxies.Empty();
+	FreeProxies.Empty();
+	SeparationBucketStart.Empty();
+	SeparationEntries.Empty();
+	HordeController = nullptr;
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterHorde::IsTickable() const
+{
+	//the server owns the horde, clients only see the replicated proxies
+	const UWorld* World = GetWorld();
+	return Entities.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject) && World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+TStatId UTopDownShooterHorde::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterHorde, STATGROUP_Tickables);
+}
+
+void UTopDownShooterHorde::SetProxyClass(TSubclassOf<AHordeEnemyActor> NewProxyClass)
+{
+	if (Proxies.Num() > 0)
+		UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterHorde::SetProxyClass - proxies already spawned, new class applies to new ones only"));
+	ProxyClass = NewProxyClass;
+}
+
+int32 UTopDownShooterHorde::SpawnEntities(int32 Count, FVector Center, float MinRadius, float MaxRadius, float Health)
+{
+	if (Count <= 0 || GetWorld()->GetNetMode() == NM_Client)
+		return 0;
+
+	if (Entities.Num() == 0)
+		SpawnStream.Initialize(int32(GetTypeHash(GetWorld()->GetTimeSeconds())));
+
+	//uniform over the ring area
+	const float MinRadiusSq = FMath::Square(FMath::Max(MinRadius, 0.0f));
+	const float MaxRadiusSq = FMath::Square(FMath::Max(MaxRadius, MinRadius));
+	for (int32 i = 0; i < Count; i++)
+	{
+		const float Angle = SpawnStream.FRandRange(0.0f, 2.0f * PI);
+		const float Radius = FMath::Sqrt(FMath::Lerp(MinRadiusSq, MaxRadiusSq, SpawnStream.FRand()));
+
+		const uint32 Id = NextEntityId++;
+		if (NextEntityId == 0)
+			NextEntityId = 1;
+		IndexById.Add(Id, Entities.Num());
+		Entities.Add(Id, Center + FVector(FMath::Cos(Angle) * Radius, FMath::Sin(Angle) * Radius, 0.0f), Health);
+	}
+
+	return Count;
+}
+
+void UTopDownShooterHorde::ClearEntities()
+{
+	for (int32 i = 0; i < Entities.Num(); i++)
+		ReleaseProxy(i);
+	Entities.Empty();
+	IndexById.Empty();
+}
+
+void UTopDownShooterHorde::ApplyDamageToEntity(uint32 EntityId, float Damage, AController* EventInstigator, AActor* DamageCauser)
+{
+	const int32* Index = IndexById.Find(EntityId);
+	if (!Index || Entities.State[*Index] == EHordeEntityState::Dead)
+		return;
+
+	const int32 i = *Index;
+	Entities.Health[i] -= Damage;
+	if (Entities.Health[i] <= 0.0f)
+	{
+		Entities.Health[i] = 0.0f;
+		Entities.State[i] = EHordeEntityState::Dead;
+		ReleaseProxy(i);
+		OnEntityKilled.Broadcast(Entities.GetLocation(i), EventInstigator);
+	}
+}
+
+bool UTopDownShooterHorde::GetEntityLocation(uint32 EntityId, FVector& OutLocation) const
+{
+	const int32* Index = IndexById.Find(EntityId);
+	if (!Index)
+		return false;
+	OutLocation = Entities.GetLocation(*Index);
+	return true;
+}
+
+AHordeEnemyActor* UTopDownShooterHorde::GetEntityProxy(int32 Index) const
+{
+	const int32 ProxyIndex = Entities.Proxy[Index];
+	return ProxyIndex != INDEX_NONE ? Proxies[ProxyIndex] : nullptr;
+}
+
+void UTopDownShooterHorde::GetEntityCapsuleSize(float& OutRadius, float& OutHalfHeight) const
+{
+	const AHordeEnemyActor* myDefaults = ProxyClass ? ProxyClass->GetDefaultObject<AHordeEnemyActor>() : GetDefault<AHordeEnemyActor>();
+	OutRadius = myDefaults->CollisionCapsule->GetScaledCapsuleRadius();
+	OutHalfHeight = myDefaults->CollisionCapsule->GetScaledCapsuleHalfHeight();
+}
+
+AController* UTopDownShooterHorde::GetHordeController()
+{
+	if (!HordeController || HordeController->IsPendingKill())
+	{
+		FActorSpawnParameters SpawnParams;
+		SpawnParams.Name = TEXT("HordeController");
+		SpawnParams.NameMode = FActorSpawnParameters::ESpawnActorNameMode::Requested;
+		HordeController = GetWorld()->SpawnActor<AController>(AController::StaticClass(), FTransform::Identity, SpawnParams);
+	}
+	return HordeController;
+}
+
+void UTopDownShooterHorde::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_Horde);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, Horde);
+
+	RemoveDead();
+	GatherTargets();
+	Simulate(DeltaTime);
+	ApplyAttacks();
+
+	ProxyAssignTimer -= DeltaTime;
+	if (ProxyAssignTimer <= 0.0f)
+	{
+		AssignProxies();
+		ProxyAssignTimer = HordeProxyAssignInterval;
+	}
+	UpdateProxies();
+
+	SET_DWORD_STAT(STAT_TPS_HordeEntities, Entities.Num());
+	SET_DWORD_STAT(STAT_TPS_HordeProxies, Proxies.Num() - FreeProxies.Num());
+	CSV_CUSTOM_STAT(TopDownShooter, HordeEntities, Entities.Num(), ECsvCustomStatOp::Set);
+}
+
+void UTopDownShooterHorde::GatherTargets()
+{
+	Targets.Reset();
+	TargetLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* myPC = It->Get();
+		APawn* myPawn = myPC ? myPC->GetPawn() : nullptr;
+		if (myPawn && !myPawn->IsPendingKill())
+		{
+			Targets.Add(myPawn);
+			TargetLocations.Add(myPawn->GetActorLocation());
+		}
+	}
+}
+
+void UTopDownShooterHorde::BuildSeparationGrid(float CellSize)
+{
+	//counting sort of the positions by bucket, cells that share a bucket only cost a few extra distance checks
+	const int32 Num = Entities.Num();
+	const int32 NumBuckets = int32(FMath::RoundUpToPowerOfTwo(uint32(FMath::Max(Num, 64))));
+	const uint32 BucketMask = uint32(NumBuckets - 1);
+	const float InvCellSize = 1.0f / CellSize;
+
+	SeparationBucketStart.Reset();
+	SeparationBucketStart.AddZeroed(NumBuckets + 1);
+	SeparationEntityBucket.SetNumUninitialized(Num, false);
+	for (int32 i = 0; i < Num; i++)
+	{
+		const uint32 Bucket = GetSeparationBucket(FMath::FloorToInt(Entities.PosX[i] * InvCellSize), FMath::FloorToInt(Entities.PosY[i] * InvCellSize), BucketMask);
+		SeparationEntityBucket[i] = int32(Bucket);
+		SeparationBucketStart[Bucket]++;
+	}
+	//end of each bucket, filled backwards so each ends up at its start
+	for (int32 b = 1; b < NumBuckets; b++)
+		SeparationBucketStart[b] += SeparationBucketStart[b - 1];
+	SeparationBucketStart[NumBuckets] = Num;
+
+	SeparationEntries.SetNumUninitialized(Num, false);
+	for (int32 i = Num - 1; i >= 0; i--)
+	{
+		FHordeSeparationEntry& myEntry = SeparationEntries[--SeparationBucketStart[SeparationEntityBucket[i]]];
+		myEntry.X = Entities.PosX[i];
+		myEntry.Y = Entities.PosY[i];
+		myEntry.Index = i;
+	}
+}
+
+void UTopDownShooterHorde::Simulate(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_HordeSimulate);
+
+	const int32 Num = Entities.Num();
+	const int32 NumChunks = FMath::DivideAndRoundUp(Num, HordeChunkSize);
+	FHordeEntities& myEntities = Entities;
+	const TArray<FVector>& myTargets = TargetLocations;
+	const float Speed = HordeSpeed;
+	const float MaxDeltaV = HordeAcceleration * DeltaTime;
+	const float AttackRangeSq = FMath::Square(HordeAttackRange);
+	const float AttackInterval = HordeAttackInterval;
+	const float FlowMinDistSq = FMath::Square(HordeFlowFieldMinDistance);
+
+	//held for the whole simulation, a newer field may be swapped in meanwhile
+	UTopDownShooterFlowField* myFlowFieldService = GetWorld()->GetSubsystem<UTopDownShooterFlowField>();
+	const FFlowFieldPtr myFlowField = myFlowFieldService ? myFlowFieldService->GetField() : nullptr;
+	const FFlowField* Flow = myFlowField.Get();
+
+	//positions of the frame start, workers read neighbours from here while they move their own entities
+	const float Separation = FMath::Max(HordeSeparation, 0.0f);
+	const bool bSeparate = Separation > 0.0f && Num > 1;
+	if (bSeparate)
+		BuildSeparationGrid(Separation);
+	const TArray<int32>& BucketStart = SeparationBucketStart;
+	const TArray<FHordeSeparationEntry>& SeparationGrid = SeparationEntries;
+	const uint32 BucketMask = uint32(FMath::Max(BucketStart.Num() - 2, 0));
+	const int32 MaxNeighbours = FMath::Max(HordeSeparationMaxNeighbours, 1);
+	const float InvSeparation = bSeparate ? 1.0f / Separation : 0.0f;
+
+	auto SimulateChunk = [&myEntities, &myTargets, &BucketStart, &SeparationGrid, Flow, Num, DeltaTime, Speed, MaxDeltaV, AttackRangeSq, AttackInterval, FlowMinDistSq, bSeparate, Separation, InvSeparation, BucketMask, MaxNeighbours](int32 ChunkIndex)
+	{
+		const int32 First = ChunkIndex * HordeChunkSize;
+		const int32 Last = FMath::Min(First + HordeChunkSize, Num);
+		for (int32 i = First; i < Last; i++)
+		{
+			myEntities.bAttackThisFrame[i] = 0;
+			if (myEntities.State[i] == EHordeEntityState::Dead)
+				continue;
+
+			//nearest player, there are only a handful
+			int32 BestTarget = INDEX_NONE;
+			float BestDistSq = MAX_flt;
+			float BestDX = 0.0f;
+			float BestDY = 0.0f;
+			for (int32 t = 0; t < myTargets.Num(); t++)
+			{
+				const float DX = myTargets[t].X - myEntities.PosX[i];
+				const float DY = myTargets[t].Y - myEntities.PosY[i];
+				const float DistSq = DX * DX + DY * DY;
+				if (DistSq < BestDistSq)
+				{
+					BestTarget = t;
+					BestDistSq = DistSq;
+					BestDX = DX;
+					BestDY = DY;
+				}
+			}
+			myEntities.Target[i] = BestTarget;
+			myEntities.TargetDistSq[i] = BestDistSq;
+
+			float WantX = 0.0f;
+			float WantY = 0.0f;
+			if (BestTarget == INDEX_NONE)
+			{
+				myEntities.State[i] = EHordeEntityState::Idle;
+			}
+			else if (BestDistSq > AttackRangeSq)
+			{
+				myEntities.State[i] = EHordeEntityState::Chasing;
+				//around walls by the flow field, straight on when close or off the field
+				const FVector2D FlowDir = Flow && BestDistSq > FlowMinDistSq ? Flow->SampleDirection(myEntities.GetLocation(i)) : FVector2D::ZeroVector;
+				if (!FlowDir.IsZero())
+				{
+					WantX = FlowDir.X * Speed;
+					WantY = FlowDir.Y * Speed;
+				}
+				else
+				{
+					const float InvDist = FMath::InvSqrt(BestDistSq);
+					WantX = BestDX * InvDist * Speed;
+					WantY = BestDY * InvDist * Speed;
+				}
+			}
+			else
+			{
+				myEntities.State[i] = EHordeEntityState::Attacking;
+			}
+
+			//pushed apart by the neighbours inside the separation distance, the closer the harder
+			if (bSeparate)
+			{
+				const float SeparationSq = Separation * Separation;
+				const int32 CellX = FMath::FloorToInt(myEntities.PosX[i] * InvSeparation);
+				const int32 CellY = FMath::FloorToInt(myEntities.PosY[i] * InvSeparation);
+				uint32 VisitedBuckets[9];
+				int32 NumVisited = 0;
+				int32 NumNeighbours = 0;
+				float PushX = 0.0f;
+				float PushY = 0.0f;
+				for (int32 Cell = 0; Cell < 9 && NumNeighbours < MaxNeighbours; Cell++)
+				{
+					const uint32 Bucket = GetSeparationBucket(CellX + Cell % 3 - 1, CellY + Cell / 3 - 1, BucketMask);
+					bool bVisited = false;
+					for (int32 v = 0; v < NumVisited; v++)
+						bVisited |= VisitedBuckets[v] == Bucket;
+					if (bVisited)
+						continue;
+					VisitedBuckets[NumVisited++] = Bucket;
+
+					for (int32 k = BucketStart[Bucket]; k < BucketStart[Bucket + 1] && NumNeighbours < MaxNeighbours; k++)
+					{
+						const FHordeSeparationEntry& Other = SeparationGrid[k];
+						if (Other.Index == i)
+							continue;
+						const float OX = myEntities.PosX[i] - Other.X;
+						const float OY = myEntities.PosY[i] - Other.Y;
+						const float DistSq = OX * OX + OY * OY;
+						if (DistSq >= SeparationSq)
+							continue;
+
+						NumNeighbours++;
+						if (DistSq < KINDA_SMALL_NUMBER)
+						{
+							//exactly on top of each other, split along X by index
+							PushX += Other.Index < i ? 1.0f : -1.0f;
+							continue;
+						}
+						const float Dist = FMath::Sqrt(DistSq);
+						const float Weight = (1.0f - Dist / Separation) / Dist;
+						PushX += OX * Weight;
+						PushY += OY * Weight;
+					}
+				}
+
+				WantX += PushX * Speed;
+				WantY += PushY * Speed;
+				const float WantSq = WantX * WantX + WantY * WantY;
+				if (WantSq > Speed * Speed)
+				{
+					const float Scale = Speed * FMath::InvSqrt(WantSq);
+					WantX *= Scale;
+					WantY *= Scale;
+				}
+			}
+
+			//steer toward the wanted velocity, limited by acceleration
+			float DVX = WantX - myEntities.VelX[i];
+			float DVY = WantY - myEntities.VelY[i];
+			const float DVSq = DVX * DVX + DVY * DVY;
+			if (DVSq > MaxDeltaV * MaxDeltaV)
+			{
+				const float Scale = MaxDeltaV * FMath::InvSqrt(DVSq);
+				DVX *= Scale;
+				DVY *= Scale;
+			}
+			myEntities.VelX[i] += DVX;
+			myEntities.VelY[i] += DVY;
+			myEntities.PosX[i] += myEntities.VelX[i] * DeltaTime;
+			myEntities.PosY[i] += myEntities.VelY[i] * DeltaTime;
+
+			myEntities.AttackCooldown[i] = FMath::Max(myEntities.AttackCooldown[i] - DeltaTime, 0.0f);
+			//only entities the players can see and shoot attack, the others wait in range for an actor
+			if (myEntities.State[i] == EHordeEntityState::Attacking && myEntities.Proxy[i] != INDEX_NONE && myEntities.AttackCooldown[i] <= 0.0f)
+			{
+				myEntities.bAttackThisFrame[i] = 1;
+				myEntities.AttackCooldown[i] = AttackInterval;
+			}
+		}
+	};
+
+	if (Num >= HordeParallelMin && NumChunks > 1)
+	{
+		ParallelFor(NumChunks, SimulateChunk);
+	}
+	else
+	{
+		for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+			SimulateChunk(ChunkIndex);
+	}
+}
+
+void UTopDownShooterHorde::ApplyAttacks()
+{
+	AController* myInstigator = nullptr;
+	for (int32 i = 0; i < Entities.Num(); i++)
+	{
+		if (!Entities.bAttackThisFrame[i] || !Targets.IsValidIndex(Entities.Target[i]))
+			continue;
+
+		AHordeEnemyActor* myProxy = Entities.Proxy[i] != INDEX_NONE ? Proxies[Entities.Proxy[i]] : nullptr;
+		if (!myProxy || myProxy->IsPendingKill())
+			continue;
+
+		if (!myInstigator)
+			myInstigator = GetHordeController();
+		myProxy->EntityAttack_BP();
+		UGameplayStatics::ApplyDamage(Targets[Entities.Target[i]], HordeAttackDamage, myInstigator, myProxy, NULL);
+	}
+}
+
+void UTopDownShooterHorde::RemoveDead()
+{
+	for (int32 i = Entities.Num() - 1; i >= 0; i--)
+	{
+		if (Entities.State[i] != EHordeEntityState::Dead)
+			continue;
+
+		IndexById.Remove(Entities.Ids[i]);
+		Entities.RemoveAtSwap(i);
+		if (i < Entities.Num())
+			IndexById.Add(Entities.Ids[i], i);
+	}
+}
+
+void UTopDownShooterHorde::AssignProxies()
+{
+	const int32 PoolSize = FMath::Max(HordeProxyCount, 0);
+	const float RadiusSq = FMath::Square(HordeProxyRadius);
+
+	ProxyCandidates.Reset();
+	for (int32 i = 0; i < Entities.Num(); i++)
+	{
+		if (Entities.State[i] != EHordeEntityState::Dead && Entities.TargetDistSq[i] <= RadiusSq)
+			ProxyCandidates.Add(i);
+	}
+
+	//only the nearest ones when more are in range than there are actors
+	if (ProxyCandidates.Num() > PoolSize)
+	{
+		const TArray<float>& DistSq = Entities.TargetDistSq;
+		ProxyCandidates.Sort([&DistSq](int32 A, int32 B) { return DistSq[A] < DistSq[B]; });
+		ProxyCandidates.SetNum(PoolSize, false);
+	}
+
+	bProxyWanted.Reset();
+	bProxyWanted.AddZeroed(Entities.Num());
+	for (int32 Candidate : ProxyCandidates)
+		bProxyWanted[Candidate] = 1;
+
+	//free actors of entities that left the range first, so the newcomers can take them
+	for (int32 i = 0; i < Entities.Num(); i++)
+	{
+		if (Entities.Proxy[i] != INDEX_NONE && !bProxyWanted[i])
+			ReleaseProxy(i);
+	}
+
+	for (int32 Candidate : ProxyCandidates)
+	{
+		if (Entities.Proxy[Candidate] != INDEX_NONE)
+			continue;
+
+		int32 ProxyIndex = INDEX_NONE;
+		if (FreeProxies.Num() > 0)
+		{
+			ProxyIndex = FreeProxies.Pop(false);
+			//destroyed from outside (level streaming, Blueprint), spawn a replacement in its slot
+			if (!Proxies[ProxyIndex] || Proxies[ProxyIndex]->IsPendingKill())
+				Proxies[ProxyIndex] = SpawnProxy();
+			if (!Proxies[ProxyIndex])
+			{
+				FreeProxies.Add(ProxyIndex);
+				break;
+			}
+		}
+		else if (Proxies.Num() < PoolSize)
+		{
+			if (AHordeEnemyActor* myProxy = SpawnProxy())
+				ProxyIndex = Proxies.Add(myProxy);
+		}
+		if (ProxyIndex == INDEX_NONE)
+			break;
+
+		Entities.Proxy[Candidate] = ProxyIndex;
+		Proxies[ProxyIndex]->AssignEntity(Entities.Ids[Candidate], Entities.GetLocation(Candidate), FRotator(0.0f, FMath::RadiansToDegrees(FMath::Atan2(Entities.VelY[Candidate], Entities.VelX[Candidate])), 0.0f));
+	}
+}
+
+void UTopDownShooterHorde::UpdateProxies()
+{
+	for (int32 i = 0; i < Entities.Num(); i++)
+	{
+		const int32 ProxyIndex = Entities.Proxy[i];
+		if (ProxyIndex == INDEX_NONE)
+			continue;
+
+		AHordeEnemyActor* myProxy = Proxies[ProxyIndex];
+		if (!myProxy || myProxy->IsPendingKill())
+		{
+			Entities.Proxy[i] = INDEX_NONE;
+			FreeProxies.Add(ProxyIndex);
+			continue;
+		}
+
+		//standing enemies keep facing where they went last
+		const float SpeedSq = FMath::Square(Entities.VelX[i]) + FMath::Square(Entities.VelY[i]);
+		const FRotator myRotation = SpeedSq > 1.0f ? FRotator(0.0f, FMath::RadiansToDegrees(FMath::Atan2(Entities.VelY[i], Entities.VelX[i])), 0.0f) : myProxy->GetActorRotation();
+		myProxy->UpdateFromEntity(Entities.GetLocation(i), myRotation, FMath::Sqrt(SpeedSq));
+	}
+}
+
+AHordeEnemyActor* UTopDownShooterHorde::SpawnProxy()
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	UClass* myClass = ProxyClass ? ProxyClass.Get() : AHordeEnemyActor::StaticClass();
+	AHordeEnemyActor* myProxy = GetWorld()->SpawnActor<AHordeEnemyActor>(myClass, FTransform::Identity, SpawnParams);
+	TPS_COUNT_SPAWNS(HordeProxySpawns, 1);
+	if (myProxy)
+		myProxy->ReleaseEntity();
+	return myProxy;
+}
+
+void UTopDownShooterHorde::ReleaseProxy(int32 EntityIndex)
+{
+	const int32 ProxyIndex = Entities.Proxy[EntityIndex];
+	if (ProxyIndex == INDEX_NONE)
+		return;
+
+	Entities.Proxy[EntityIndex] = INDEX_NONE;
+	if (Proxies[ProxyIndex])
+		Proxies[ProxyIndex]->ReleaseEntity();
+	FreeProxies.Add(ProxyIndex);
+}
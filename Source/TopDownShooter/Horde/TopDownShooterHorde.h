@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "TopDownShooterHorde.generated.h"
+
+class AHordeEnemyActor;
+class APawn;
+class AController;
+
+UENUM(BlueprintType)
+enum class EHordeEntityState : uint8
+{
+	Idle,
+	Chasing,
+	Attacking,
+	Dead
+};
+
+//All horde enemies as structure of arrays, one index per entity, dense (dead entities are swapped out at the end of the frame)
+struct FHordeEntities
+{
+	int32 Num() const { return Ids.Num(); }
+	void Add(uint32 Id, const FVector& Location, float InHealth);
+	void RemoveAtSwap(int32 Index);
+	void Empty();
+
+	FVector GetLocation(int32 Index) const { return FVector(PosX[Index], PosY[Index], PosZ[Index]); }
+
+	TArray<uint32> Ids;
+	TArray<float> PosX;
+	TArray<float> PosY;
+	TArray<float> PosZ;
+	TArray<float> VelX;
+	TArray<float> VelY;
+	TArray<float> Health;
+	TArray<float> AttackCooldown;
+	//index into the targets of the frame, INDEX_NONE without one
+	TArray<int32> Target;
+	TArray<float> TargetDistSq;
+	TArray<EHordeEntityState> State;
+	//pool actor showing the entity, INDEX_NONE when not shown
+	TArray<int32> Proxy;
+	//set by the simulation when the entity hits its target this frame
+	TArray<uint8> bAttackThisFrame;
+};
+
+//Position of one entity at the start of the frame, bucketed by separation cell
+struct FHordeSeparationEntry
+{
+	float X = 0.0f;
+	float Y = 0.0f;
+	int32 Index = INDEX_NONE;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FOnHordeEntityKilled, FVector, Location, AController*, Killer);
+
+/**
+ * Horde mode: thousands of enemies kept as plain arrays instead of one ACharacter each.
+ * Entities chase the nearest player pawn along UTopDownShooterFlowField, simulated in parallel chunks, and keep
+ * TPS.Horde.Separation from each other through a spatial hash rebuilt every frame.
+ * A pool of AHordeEnemyActor (TPS.Horde.ProxyCount) is moved onto the entities nearest to the players, those actors
+ * carry the collision weapon hits and ApplyDamage land on. Only entities shown by an actor attack, the actor is the damage
+ * causer and GetHordeController() the instigator. Runs on the server and in standalone, proxies replicate.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterHorde : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//class of the pooled actors, set before the first entities spawn (a Blueprint child with the enemy mesh)
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	void SetProxyClass(TSubclassOf<AHordeEnemyActor> NewProxyClass);
+
+	//Count entities scattered in a ring around Center, returns how many were added
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	int32 SpawnEntities(int32 Count, FVector Center, float MinRadius, float MaxRadius, float Health = 100.0f);
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	void ClearEntities();
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	int32 GetNumEntities() const { return Entities.Num(); }
+
+	//damage from a proxy actor or a pawn hit grid hit, the entity is removed at the start of the next frame
+	void ApplyDamageToEntity(uint32 EntityId, float Damage, AController* EventInstigator, AActor* DamageCauser);
+	bool GetEntityLocation(uint32 EntityId, FVector& OutLocation) const;
+
+	const FHordeEntities& GetEntities() const { return Entities; }
+	//actor showing the entity at Index, null when it has none
+	AHordeEnemyActor* GetEntityProxy(int32 Index) const;
+	//collision size of an entity, taken from the proxy class
+	void GetEntityCapsuleSize(float& OutRadius, float& OutHalfHeight) const;
+
+	//instigator of every horde attack, so damage handlers can tell horde hits apart
+	UFUNCTION(BlueprintCallable, Category = "Horde")
+	AController* GetHordeController();
+
+	UPROPERTY(BlueprintAssignable, Category = "Horde")
+	FOnHordeEntityKilled OnEntityKilled;
+
+private:
+	void GatherTargets();
+	void BuildSeparationGrid(float CellSize);
+	void Simulate(float DeltaTime);
+	void ApplyAttacks();
+	void RemoveDead();
+	void AssignProxies();
+	void UpdateProxies();
+
+	AHordeEnemyActor* SpawnProxy();
+	void ReleaseProxy(int32 EntityIndex);
+
+	FHordeEntities Entities;
+	TMap<uint32, int32> IndexById;
+	uint32 NextEntityId = 1;
+	FRandomStream SpawnStream;
+
+	//player pawns of this frame, flat copies for the worker threads
+	TArray<APawn*> Targets;
+	TArray<FVector> TargetLocations;
+
+	UPROPERTY()
+	TSubclassOf<AHordeEnemyActor> ProxyClass;
+	UPROPERTY()
+	AController* HordeController = nullptr;
+	UPROPERTY()
+	TArray<AHordeEnemyActor*> Proxies;
+	TArray<int32> FreeProxies;
+	float ProxyAssignTimer = 0.0f;
+
+	//scratch
+	TArray<int32> ProxyCandidates;
+	TArray<uint8> bProxyWanted;
+	TArray<int32> SeparationBucketStart;
+	TArray<int32> SeparationEntityBucket;
+	TArray<FHordeSeparationEntry> SeparationEntries;
+};
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DropItemActor.h"
+#include "Pickup/TopDownShooterDropSpawner.h"
+#include "Components/StaticMeshComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "Net/UnrealNetwork.h"
+#include "Engine/World.h"
+
+ADropItemActor::ADropItemActor()
+{
+	//static until picked up or recycled, never ticks
+	PrimaryActorTick.bCanEverTick = false;
+
+	SceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Scene"));
+	RootComponent = SceneComponent;
+
+	StaticMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Static Mesh"));
+	StaticMesh->SetupAttachment(RootComponent);
+	StaticMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	StaticMesh->SetGenerateOverlapEvents(false);
+	StaticMesh->SetCanEverAffectNavigation(false);
+
+	SkeletalMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Skeletal Mesh"));
+	SkeletalMesh->SetupAttachment(RootComponent);
+	SkeletalMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SkeletalMesh->SetGenerateOverlapEvents(false);
+	SkeletalMesh->SetCanEverAffectNavigation(false);
+	SkeletalMesh->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+
+	ParticleSystem = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("Particle System"));
+	ParticleSystem->SetupAttachment(RootComponent);
+	ParticleSystem->bAutoActivate = false;
+
+	bReplicates = true;
+	SetReplicatingMovement(true);
+}
+
+void ADropItemActor::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ADropItemActor, DropItem);
+}
+
+void ADropItemActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWorld* myWorld = GetWorld())
+	{
+		if (UTopDownShooterDropSpawner* mySpawner = myWorld->GetSubsystem<UTopDownShooterDropSpawner>())
+			mySpawner->ForgetDrop(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADropItemActor::ShowDrop(const FDropItem& NewDropItem, const FTransform& Transform)
+{
+	DropItem = NewDropItem;
+	ApplyVisuals();
+	SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+}
+
+void ADropItemActor::HideDrop()
+{
+	PickupId = 0;
+	SetActorHiddenInGame(true);
+	ParticleSystem->DeactivateImmediate();
+}
+
+void ADropItemActor::OnRep_DropItem()
+{
+	ApplyVisuals();
+}
+
+void ADropItemActor::ApplyVisuals()
+{
+	//a drop reused for its own row keeps its assets, only rows changing pay for the mesh setup
+	if (StaticMesh->GetStaticMesh() != DropItem.WeaponStaticMesh)
+	{
+		StaticMesh->SetStaticMesh(DropItem.WeaponStaticMesh);
+		StaticMesh->SetVisibility(DropItem.WeaponStaticMesh != nullptr);
+	}
+	if (SkeletalMesh->SkeletalMesh != DropItem.WeaponSkeletMesh)
+	{
+		SkeletalMesh->SetSkeletalMesh(DropItem.WeaponSkeletMesh, false);
+		SkeletalMesh->SetVisibility(DropItem.WeaponSkeletMesh != nullptr);
+	}
+	StaticMesh->SetRelativeTransform(DropItem.Offset);
+	SkeletalMesh->SetRelativeTransform(DropItem.Offset);
+
+	if (ParticleSystem->Template != DropItem.ParticleSystem)
+		ParticleSystem->SetTemplate(DropItem.ParticleSystem);
+	if (DropItem.ParticleSystem)
+		ParticleSystem->Activate(true);
+	else
+		ParticleSystem->DeactivateImmediate();
+}
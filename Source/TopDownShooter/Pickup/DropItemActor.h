@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "FuncLibrary/Types.h"
+#include "DropItemActor.generated.h"
+
+/**
+ * Weapon lying on the ground after a swap or a death, owned and recycled by UTopDownShooterDropSpawner.
+ * Has no collision, taking it goes through UTopDownShooterPickupManager. Meshes and FX are only reassigned
+ * when the actor is reused for another drop row.
+ */
+UCLASS(NotBlueprintable)
+class TOPDOWNSHOOTER_API ADropItemActor : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ADropItemActor();
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class USceneComponent* SceneComponent = nullptr;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class UStaticMeshComponent* StaticMesh = nullptr;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class USkeletalMeshComponent* SkeletalMesh = nullptr;
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Components)
+	class UParticleSystemComponent* ParticleSystem = nullptr;
+
+	//replicated so clients build the same visuals
+	UPROPERTY(ReplicatedUsing = OnRep_DropItem, BlueprintReadOnly, Category = "Drop")
+	FDropItem DropItem;
+
+	//pool the actor sits in, the weapon name of its drop row
+	FName PoolKey = NAME_None;
+	//record in the pickup manager while shown, 0 in the pool
+	int32 PickupId = 0;
+
+	void ShowDrop(const FDropItem& NewDropItem, const FTransform& Transform);
+	void HideDrop();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	UFUNCTION()
+	void OnRep_DropItem();
+
+	void ApplyVisuals();
+};
@@ -0,0 +1,168 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterDropSpawner.h"
+#include "Pickup/DropItemActor.h"
+#include "Pickup/TopDownShooterPickupManager.h"
+#include "Game/TopDownShooterGameInstance.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Drop Spawner"), STAT_TPS_DropSpawner, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Drop Actors"), STAT_TPS_DropActors, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Drops Pending"), STAT_TPS_DropsPending, STATGROUP_TopDownShooter);
+
+int32 DropMaxActors = 48;
+FAutoConsoleVariableRef CVARDropMaxActors(TEXT("TPS.Drop.MaxActors"), DropMaxActors, TEXT("Max weapon drop actors in the world, past it the oldest drop is recycled"), ECVF_Default);
+
+int32 DropsPerFrame = 4;
+FAutoConsoleVariableRef CVARDropsPerFrame(TEXT("TPS.Drop.PerFrame"), DropsPerFrame, TEXT("Queued weapon drops shown per frame, bursts are spread over the next frames"), ECVF_Default);
+
+void UTopDownShooterDropSpawner::Deinitialize()
+{
+	Drops.Empty();
+	ActiveDrops.Empty();
+	FreeDrops.Empty();
+	PendingDrops.Empty();
+	DropRowCache.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterDropSpawner::IsTickable() const
+{
+	const UWorld* World = GetWorld();
+	return PendingDrops.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject) && World && World->IsGameWorld() && World->GetNetMode() != NM_Client;
+}
+
+TStatId UTopDownShooterDropSpawner::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterDropSpawner, STATGROUP_Tickables);
+}
+
+void UTopDownShooterDropSpawner::QueueDrop(const FDropItem& DropItem, FVector Location, FRotator Rotation)
+{
+	if (GetWorld()->GetNetMode() == NM_Client || DropItem.WeaponInfo.NameItem.IsNone())
+		return;
+
+	PendingDrops.AddDefaulted();
+	FDropRequest& myRequest = PendingDrops.Last();
+	myRequest.DropItem = DropItem;
+	myRequest.Transform = FTransform(Rotation, Location);
+}
+
+bool UTopDownShooterDropSpawner::QueueDropByWeaponName(FName WeaponName, FVector Location, FRotator Rotation)
+{
+	const FDropItem* myDropItem = DropRowCache.Find(WeaponName);
+	if (!myDropItem)
+	{
+		UTopDownShooterGameInstance* myGI = Cast<UTopDownShooterGameInstance>(GetWorld()->GetGameInstance());
+		FDropItem myInfo;
+		if (!myGI || !myGI->GetDropItemInfoByWeaponName(WeaponName, myInfo))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UTopDownShooterDropSpawner::QueueDropByWeaponName - No drop row for weapon - %s"), *WeaponName.ToString());
+			return false;
+		}
+		myDropItem = &DropRowCache.Add(WeaponName, myInfo);
+	}
+
+	QueueDrop(*myDropItem, Location, Rotation);
+	return true;
+}
+
+void UTopDownShooterDropSpawner::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_DropSpawner);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, DropSpawner);
+
+	//requests past the cap would only recycle drops shown this same burst, the oldest ones are skipped
+	const int32 MaxActors = FMath::Max(DropMaxActors, 0);
+	if (PendingDrops.Num() > MaxActors)
+		PendingDrops.RemoveAt(0, PendingDrops.Num() - MaxActors, false);
+
+	const int32 ShowNum = FMath::Min(PendingDrops.Num(), FMath::Max(DropsPerFrame, 1));
+	for (int32 i = 0; i < ShowNum; i++)
+		ShowDrop(PendingDrops[i]);
+	PendingDrops.RemoveAt(0, ShowNum, false);
+
+	SET_DWORD_STAT(STAT_TPS_DropActors, Drops.Num());
+	SET_DWORD_STAT(STAT_TPS_DropsPending, PendingDrops.Num());
+}
+
+void UTopDownShooterDropSpawner::ShowDrop(const FDropRequest& Request)
+{
+	const FName PoolKey = Request.DropItem.WeaponInfo.NameItem;
+	ADropItemActor* myDrop = TakeFreeDrop(PoolKey);
+	if (!myDrop && Drops.Num() < DropMaxActors)
+		myDrop = SpawnDrop();
+	if (!myDrop)
+	{
+		//another row's free drop is reassigned before anything on the ground goes
+		for (TPair<FName, TArray<ADropItemActor*>>& myFree : FreeDrops)
+		{
+			if (myFree.Value.Num() > 0)
+			{
+				myDrop = myFree.Value.Pop(false);
+				break;
+			}
+		}
+	}
+	if (!myDrop && ActiveDrops.Num() > 0)
+	{
+		ADropItemActor* myOldest = ActiveDrops[0];
+		ReleaseDrop(myOldest);
+		myDrop = TakeFreeDrop(myOldest->PoolKey);
+	}
+	if (!myDrop)
+		return;
+
+	myDrop->PoolKey = PoolKey;
+	myDrop->ShowDrop(Request.DropItem, Request.Transform);
+	ActiveDrops.Add(myDrop);
+
+	if (UTopDownShooterPickupManager* myPickups = GetWorld()->GetSubsystem<UTopDownShooterPickupManager>())
+		myDrop->PickupId = myPickups->AddWeaponPickup(Request.Transform.GetLocation(), Request.DropItem.WeaponInfo, myDrop);
+}
+
+ADropItemActor* UTopDownShooterDropSpawner::TakeFreeDrop(FName PoolKey)
+{
+	TArray<ADropItemActor*>* myFree = FreeDrops.Find(PoolKey);
+	return myFree && myFree->Num() > 0 ? myFree->Pop(false) : nullptr;
+}
+
+ADropItemActor* UTopDownShooterDropSpawner::SpawnDrop()
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ADropItemActor* myDrop = GetWorld()->SpawnActor<ADropItemActor>(ADropItemActor::StaticClass(), FTransform::Identity, SpawnParams);
+	TPS_COUNT_SPAWNS(DropSpawns, 1);
+	if (myDrop)
+		Drops.Add(myDrop);
+	return myDrop;
+}
+
+void UTopDownShooterDropSpawner::ReleaseDrop(ADropItemActor* Drop)
+{
+	if (!Drop || ActiveDrops.RemoveSingle(Drop) == 0)
+		return;
+
+	//recycled while still on the ground, nobody may take it anymore
+	if (Drop->PickupId != 0)
+	{
+		if (UTopDownShooterPickupManager* myPickups = GetWorld()->GetSubsystem<UTopDownShooterPickupManager>())
+			myPickups->RemovePickup(Drop->PickupId);
+	}
+
+	Drop->HideDrop();
+	FreeDrops.FindOrAdd(Drop->PoolKey).Add(Drop);
+}
+
+void UTopDownShooterDropSpawner::ForgetDrop(ADropItemActor* Drop)
+{
+	Drops.RemoveSingleSwap(Drop, false);
+	ActiveDrops.RemoveSingle(Drop);
+	if (TArray<ADropItemActor*>* myFree = FreeDrops.Find(Drop->PoolKey))
+		myFree->RemoveSingleSwap(Drop, false);
+}
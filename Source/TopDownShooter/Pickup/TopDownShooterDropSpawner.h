@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FuncLibrary/Types.h"
+#include "TopDownShooterDropSpawner.generated.h"
+
+class ADropItemActor;
+
+//One drop waiting for its frame
+struct FDropRequest
+{
+	FDropItem DropItem;
+	FTransform Transform;
+};
+
+/**
+ * Weapon drops of swaps and deaths. Requests are queued and shown a few per frame, on ADropItemActor taken from a pool
+ * keyed by the drop row (its weapon name) so the assets usually stay assigned. The number of drop actors in the world
+ * is capped, past it the oldest drop on the ground is recycled. Shown drops are registered in UTopDownShooterPickupManager,
+ * which hands them back here when taken. Server and standalone only, the actors replicate.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterDropSpawner : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//DropItem as filled by SwitchWeaponToInventory or GetDropItemInfoFromInventory, Offset is applied to the meshes
+	UFUNCTION(BlueprintCallable, Category = "Drop")
+	void QueueDrop(const FDropItem& DropItem, FVector Location, FRotator Rotation);
+	//drop row looked up once per weapon and cached, for drops not coming from an inventory (death loot)
+	UFUNCTION(BlueprintCallable, Category = "Drop")
+	bool QueueDropByWeaponName(FName WeaponName, FVector Location, FRotator Rotation);
+
+	UFUNCTION(BlueprintCallable, Category = "Drop")
+	void ReleaseDrop(ADropItemActor* Drop);
+	UFUNCTION(BlueprintCallable, Category = "Drop")
+	int32 GetNumActiveDrops() const { return ActiveDrops.Num(); }
+
+	//the actor is leaving the world without going through the pool
+	void ForgetDrop(ADropItemActor* Drop);
+
+private:
+	void ShowDrop(const FDropRequest& Request);
+	ADropItemActor* TakeFreeDrop(FName PoolKey);
+	ADropItemActor* SpawnDrop();
+
+	//every drop actor, shown or pooled, for GC and the cap
+	UPROPERTY()
+	TArray<ADropItemActor*> Drops;
+	//shown drops, oldest first
+	TArray<ADropItemActor*> ActiveDrops;
+	TMap<FName, TArray<ADropItemActor*>> FreeDrops;
+	TArray<FDropRequest> PendingDrops;
+	TMap<FName, FDropItem> DropRowCache;
+};
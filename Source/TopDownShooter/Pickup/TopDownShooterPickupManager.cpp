@@ -0,0 +1,216 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterPickupManager.h"
+#include "Character/TopDownShooterInventorComponent.h"
+#include "Pickup/DropItemActor.h"
+#include "Pickup/TopDownShooterDropSpawner.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Pickup Manager"), STAT_TPS_PickupManager, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickups"), STAT_TPS_Pickups, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pickups Tested"), STAT_TPS_PickupsTested, STATGROUP_TopDownShooter);
+
+float PickupRadius = 100.0f;
+FAutoConsoleVariableRef CVARPickupRadius(TEXT("TPS.Pickup.Radius"), PickupRadius, TEXT("Distance from a player at which a pickup is taken"), ECVF_Default);
+
+float PickupHeightTolerance = 150.0f;
+FAutoConsoleVariableRef CVARPickupHeightTolerance(TEXT("TPS.Pickup.HeightTolerance"), PickupHeightTolerance, TEXT("Height difference between a player's capsule centre and a pickup at which it is still taken"), ECVF_Default);
+
+float PickupCellSize = 500.0f;
+FAutoConsoleVariableRef CVARPickupCellSize(TEXT("TPS.Pickup.CellSize"), PickupCellSize, TEXT("Cell size of the pickup grid, read when the first pickup is added"), ECVF_Default);
+
+void UTopDownShooterPickupManager::Deinitialize()
+{
+	Records.Empty();
+	Cells.Empty();
+	Nearby.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UTopDownShooterPickupManager::IsTickable() const
+{
+	return Records.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UTopDownShooterPickupManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UTopDownShooterPickupManager, STATGROUP_Tickables);
+}
+
+int32 UTopDownShooterPickupManager::AddAmmoPickup(FVector Location, EWeaponType AmmoType, int32 Count, AActor* Visual)
+{
+	if (Count <= 0)
+		return 0;
+
+	FPickupRecord Record;
+	Record.Location = Location;
+	Record.Kind = EPickupKind::Ammo;
+	Record.AmmoType = AmmoType;
+	Record.AmmoCount = Count;
+	Record.Visual = Visual;
+	return AddRecord(Record);
+}
+
+int32 UTopDownShooterPickupManager::AddWeaponPickup(FVector Location, FWeaponSlot Weapon, AActor* Visual)
+{
+	if (Weapon.NameItem.IsNone())
+		return 0;
+
+	FPickupRecord Record;
+	Record.Location = Location;
+	Record.Kind = EPickupKind::Weapon;
+	Record.Weapon = Weapon;
+	Record.Visual = Visual;
+	return AddRecord(Record);
+}
+
+void UTopDownShooterPickupManager::RemovePickup(int32 PickupId)
+{
+	FPickupRecord Record;
+	RemoveRecord(PickupId, Record);
+}
+
+int32 UTopDownShooterPickupManager::AddRecord(FPickupRecord& Record)
+{
+	//the grid is rebuilt from nothing, so the cell size can only change while it is empty
+	if (Records.Num() == 0)
+	{
+		Cells.Reset();
+		GridCellSize = FMath::Max(PickupCellSize, 100.0f);
+	}
+
+	Record.Id = NextPickupId++;
+	if (NextPickupId == MAX_int32)
+		NextPickupId = 1;
+	Record.Cell = GetCell(Record.Location);
+
+	Cells.FindOrAdd(Record.Cell).Add(Record.Id);
+	Records.Add(Record.Id, Record);
+	return Record.Id;
+}
+
+void UTopDownShooterPickupManager::RemoveRecord(int32 PickupId, FPickupRecord& OutRecord)
+{
+	if (!Records.RemoveAndCopyValue(PickupId, OutRecord))
+		return;
+
+	if (TArray<int32>* myCell = Cells.Find(OutRecord.Cell))
+	{
+		myCell->RemoveSingleSwap(PickupId, false);
+		if (myCell->Num() == 0)
+			Cells.Remove(OutRecord.Cell);
+	}
+}
+
+FIntPoint UTopDownShooterPickupManager::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / GridCellSize), FMath::FloorToInt(Location.Y / GridCellSize));
+}
+
+void UTopDownShooterPickupManager::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_PickupManager);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, PickupManager);
+
+	//inventories are changed where they are authoritative, clients see the result through replication
+	UWorld* myWorld = GetWorld();
+	if (!myWorld || myWorld->GetNetMode() == NM_Client)
+		return;
+
+	Nearby.Reset();
+	int32 TestedNum = 0;
+	for (FConstPlayerControllerIterator It = myWorld->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* myController = It->Get();
+		APawn* myPawn = myController ? myController->GetPawn() : nullptr;
+		if (!myPawn)
+			continue;
+
+		UTopDownShooterInventorComponent* myInventory = myPawn->FindComponentByClass<UTopDownShooterInventorComponent>();
+		if (!myInventory)
+			continue;
+
+		CheckPawn(myPawn, myInventory);
+		TestedNum += Nearby.Num();
+		if (Records.Num() == 0)
+			break;
+	}
+
+	SET_DWORD_STAT(STAT_TPS_Pickups, Records.Num());
+	SET_DWORD_STAT(STAT_TPS_PickupsTested, TestedNum);
+}
+
+void UTopDownShooterPickupManager::CheckPawn(APawn* Pawn, UTopDownShooterInventorComponent* Inventory)
+{
+	//what this inventory can take, cached by the inventory until its slots change
+	uint32 AmmoMask = 0;
+	int32 FreeWeaponSlot = INDEX_NONE;
+	Inventory->GetPickupEligibility(AmmoMask, FreeWeaponSlot);
+	if (AmmoMask == 0 && FreeWeaponSlot == INDEX_NONE)
+	{
+		Nearby.Reset();
+		return;
+	}
+
+	const FVector PawnLocation = Pawn->GetActorLocation();
+	const float Radius = FMath::Max(PickupRadius, 0.0f);
+	const FIntPoint MinCell = GetCell(PawnLocation - FVector(Radius));
+	const FIntPoint MaxCell = GetCell(PawnLocation + FVector(Radius));
+
+	//ids are copied out, collecting edits the cells
+	Nearby.Reset();
+	for (int32 y = MinCell.Y; y <= MaxCell.Y; y++)
+	{
+		for (int32 x = MinCell.X; x <= MaxCell.X; x++)
+		{
+			if (const TArray<int32>* myCell = Cells.Find(FIntPoint(x, y)))
+				Nearby.Append(*myCell);
+		}
+	}
+
+	for (int32 PickupId : Nearby)
+	{
+		const FPickupRecord* Record = Records.Find(PickupId);
+		//pickups lie on the floor and the pawn location is the capsule centre, so the height gets its own tolerance
+		if (!Record || FVector::DistSquared2D(Record->Location, PawnLocation) > FMath::Square(Radius) || FMath::Abs(Record->Location.Z - PawnLocation.Z) > PickupHeightTolerance)
+			continue;
+		if (!TryCollect(*Record, Inventory, AmmoMask, FreeWeaponSlot))
+			continue;
+
+		FPickupRecord Collected;
+		RemoveRecord(PickupId, Collected);
+		OnPickupCollected.Broadcast(Pawn, PickupId, Collected.Visual.Get());
+		if (ADropItemActor* myDrop = Cast<ADropItemActor>(Collected.Visual.Get()))
+		{
+			//pooled weapon drops go back to their spawner instead of being destroyed
+			if (UTopDownShooterDropSpawner* mySpawner = GetWorld()->GetSubsystem<UTopDownShooterDropSpawner>())
+				mySpawner->ReleaseDrop(myDrop);
+		}
+		else if (AActor* myVisual = Collected.Visual.Get())
+			myVisual->Destroy();
+
+		Inventory->GetPickupEligibility(AmmoMask, FreeWeaponSlot);
+		if (AmmoMask == 0 && FreeWeaponSlot == INDEX_NONE)
+			break;
+	}
+}
+
+bool UTopDownShooterPickupManager::TryCollect(const FPickupRecord& Record, UTopDownShooterInventorComponent* Inventory, uint32 AmmoMask, int32 FreeWeaponSlot) const
+{
+	if (Record.Kind == EPickupKind::Ammo)
+	{
+		if ((AmmoMask & (1u << uint32(Record.AmmoType))) == 0)
+			return false;
+		//negative change adds, the inventory clamps to MaxCout
+		Inventory->AmmoSlotChangeValue(Record.AmmoType, -Record.AmmoCount);
+		return true;
+	}
+
+	return FreeWeaponSlot != INDEX_NONE && Inventory->TryGetWeaponToInventory(Record.Weapon);
+}
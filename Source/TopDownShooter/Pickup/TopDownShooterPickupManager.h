@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "FuncLibrary/Types.h"
+#include "TopDownShooterPickupManager.generated.h"
+
+class APawn;
+class UTopDownShooterInventorComponent;
+
+enum class EPickupKind : uint8
+{
+	Ammo,
+	Weapon
+};
+
+//One pickup lying in the world, the actor showing it is optional and has no collision of its own
+struct FPickupRecord
+{
+	int32 Id = 0;
+	FVector Location = FVector::ZeroVector;
+	EPickupKind Kind = EPickupKind::Ammo;
+	EWeaponType AmmoType = EWeaponType::RifleType;
+	int32 AmmoCount = 0;
+	FWeaponSlot Weapon;
+	TWeakObjectPtr<AActor> Visual;
+	FIntPoint Cell = FIntPoint::ZeroValue;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnPickupCollected, APawn*, Pawn, int32, PickupId, AActor*, Visual);
+
+/**
+ * Ammo and weapon pickups as plain records in a uniform grid, instead of one overlap volume per pickup actor.
+ * Each player is tested only against the cells around it, with what its inventory can take cached by the inventory
+ * until its slots change (ammo types that are not full, first free weapon slot). Weapons are only taken into a free
+ * slot, swapping stays on the pickup Blueprint. Runs where the inventory is authoritative (server, standalone).
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UTopDownShooterPickupManager : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//Visual is hidden with the pickup, leave its own overlap volume off. Returns the pickup id
+	UFUNCTION(BlueprintCallable, Category = "Pickup")
+	int32 AddAmmoPickup(FVector Location, EWeaponType AmmoType, int32 Count, AActor* Visual);
+	UFUNCTION(BlueprintCallable, Category = "Pickup")
+	int32 AddWeaponPickup(FVector Location, FWeaponSlot Weapon, AActor* Visual);
+	UFUNCTION(BlueprintCallable, Category = "Pickup")
+	void RemovePickup(int32 PickupId);
+	UFUNCTION(BlueprintCallable, Category = "Pickup")
+	int32 GetNumPickups() const { return Records.Num(); }
+
+	//the inventory already took the pickup, Visual is destroyed (or returned to the drop pool) after the broadcast
+	UPROPERTY(BlueprintAssignable, Category = "Pickup")
+	FOnPickupCollected OnPickupCollected;
+
+private:
+	int32 AddRecord(FPickupRecord& Record);
+	FIntPoint GetCell(const FVector& Location) const;
+	void CheckPawn(APawn* Pawn, UTopDownShooterInventorComponent* Inventory);
+	bool TryCollect(const FPickupRecord& Record, UTopDownShooterInventorComponent* Inventory, uint32 AmmoMask, int32 FreeWeaponSlot) const;
+	void RemoveRecord(int32 PickupId, FPickupRecord& OutRecord);
+
+	TMap<int32, FPickupRecord> Records;
+	TMap<FIntPoint, TArray<int32>> Cells;
+	float GridCellSize = 0.0f;
+	int32 NextPickupId = 1;
+
+	//scratch
+	TArray<int32> Nearby;
+};
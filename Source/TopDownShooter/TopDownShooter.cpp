@@ -6,4 +6,16 @@
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, TopDownShooter, "TopDownShooter" );
 
 DEFINE_LOG_CATEGORY(LogTopDownShooter)
- 
\ No newline at end of file
+
+DEFINE_STAT(STAT_TPS_LiveProjectiles);
+DEFINE_STAT(STAT_TPS_DebrisActors);
+DEFINE_STAT(STAT_TPS_TracesPerFrame);
+DEFINE_STAT(STAT_TPS_SpawnsPerFrame);
+
+CSV_DEFINE_CATEGORY_MODULE(TOPDOWNSHOOTER_API, TopDownShooter, true);
+
+int32 FTopDownShooterCounters::ShotsFired = 0;
+int32 FTopDownShooterCounters::LiveProjectiles = 0;
+int32 FTopDownShooterCounters::DebrisActors = 0;
+int32 FTopDownShooterCounters::Traces = 0;
+int32 FTopDownShooterCounters::Spawns = 0;
@@ -3,5 +3,45 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "ProfilingDebugging/CsvProfiler.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTopDownShooter, Log, All);
+
+//"stat TopDownShooter", cycle counters are declared next to the code they measure
+DECLARE_STATS_GROUP(TEXT("TopDownShooter"), STATGROUP_TopDownShooter, STATCAT_Advanced);
+
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Projectiles"), STAT_TPS_LiveProjectiles, STATGROUP_TopDownShooter, TOPDOWNSHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Debris Actors"), STAT_TPS_DebrisActors, STATGROUP_TopDownShooter, TOPDOWNSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Per Frame"), STAT_TPS_TracesPerFrame, STATGROUP_TopDownShooter, TOPDOWNSHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Actors Spawned Per Frame"), STAT_TPS_SpawnsPerFrame, STATGROUP_TopDownShooter, TOPDOWNSHOOTER_API);
+
+//-csvCategories=TopDownShooter
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(TOPDOWNSHOOTER_API, TopDownShooter);
+
+//plain running totals next to the stats, readable in every build configuration (benchmark samples them)
+struct TOPDOWNSHOOTER_API FTopDownShooterCounters
+{
+	static int32 ShotsFired;
+	static int32 LiveProjectiles;
+	static int32 DebrisActors;
+	static int32 Traces;
+	static int32 Spawns;
+};
+
+//stat counter and csv column in one go, Name is the csv column
+#define TPS_COUNT_TRACES(Name, Num) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_TPS_TracesPerFrame, (Num)); \
+		CSV_CUSTOM_STAT(TopDownShooter, Name, (Num), ECsvCustomStatOp::Accumulate); \
+		FTopDownShooterCounters::Traces += (Num); \
+	} while (0)
+
+#define TPS_COUNT_SPAWNS(Name, Num) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_TPS_SpawnsPerFrame, (Num)); \
+		CSV_CUSTOM_STAT(TopDownShooter, Name, (Num), ECsvCustomStatOp::Accumulate); \
+		FTopDownShooterCounters::Spawns += (Num); \
+	} while (0)
@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "TopDownShooterMemory.h"
+#include "TopDownShooter.h"
+#include "EngineUtils.h"
+#include "Engine/World.h"
+#include "Components/DecalComponent.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Misc/OutputDevice.h"
+#include "Serialization/ArchiveCountMem.h"
+#include "UObject/UObjectIterator.h"
+#include "Weapons/WeaponDefault.h"
+#include "Weapons/DropMeshActor.h"
+#include "Weapons/Projectiles/ProjectileDefault.h"
+#include "Character/TopDownShooterInventorComponent.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER && STATS
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS Weapons"), STAT_TPS_WeaponsLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS Projectiles"), STAT_TPS_ProjectilesLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS Debris"), STAT_TPS_DebrisLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS Inventory"), STAT_TPS_InventoryLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS WeaponData"), STAT_TPS_WeaponDataLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TPS ImpactFX"), STAT_TPS_ImpactFXLLM, STATGROUP_LLMFULL);
+DECLARE_LLM_MEMORY_STAT(TEXT("TopDownShooter"), STAT_TPS_SummaryLLM, STATGROUP_LLM);
+#endif
+
+namespace TopDownShooterMemory
+{
+	static const TCHAR* TagNames[] = { TEXT("TPS_Weapons"), TEXT("TPS_Projectiles"), TEXT("TPS_Debris"), TEXT("TPS_Inventory"), TEXT("TPS_WeaponData"), TEXT("TPS_ImpactFX") };
+	static_assert(ARRAY_COUNT(TagNames) == int32(ETopDownShooterLLMTag::Count), "one name per tag");
+
+	struct FTagUsage
+	{
+		int32 Count = 0;
+		int64 Bytes = 0;
+	};
+
+	int64 CountObjectBytes(UObject* Object)
+	{
+		FArchiveCountMem CountMem(Object);
+		return int64(CountMem.GetMax());
+	}
+
+	//the actor with all of its components
+	int64 CountActorBytes(AActor* Actor)
+	{
+		int64 Bytes = CountObjectBytes(Actor);
+		for (UActorComponent* Component : Actor->GetComponents())
+		{
+			if (Component)
+				Bytes += CountObjectBytes(Component);
+		}
+		return Bytes;
+	}
+
+	int64 CountProjectileInfosBytes(const FProjectileInfos& Infos)
+	{
+		return Infos.HitDecals.GetAllocatedSize() + Infos.HitFXs.GetAllocatedSize();
+	}
+}
+
+const TCHAR* FTopDownShooterMemory::GetTagName(ETopDownShooterLLMTag Tag)
+{
+	return TopDownShooterMemory::TagNames[int32(Tag)];
+}
+
+int64 FTopDownShooterMemory::GetTrackedBytes(ETopDownShooterLLMTag Tag)
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	if (FLowLevelMemTracker::IsEnabled())
+		return FLowLevelMemTracker::Get().GetTagAmountForTracker(ELLMTracker::Default, ToLLMTag(Tag));
+#endif
+	return -1;
+}
+
+void FTopDownShooterMemory::DumpReport(UWorld* World, FOutputDevice& Ar)
+{
+	using namespace TopDownShooterMemory;
+
+	if (!World)
+		return;
+
+	FTagUsage Usage[int32(ETopDownShooterLLMTag::Count)];
+	FTagUsage& Weapons = Usage[int32(ETopDownShooterLLMTag::Weapons)];
+	FTagUsage& Projectiles = Usage[int32(ETopDownShooterLLMTag::Projectiles)];
+	FTagUsage& Debris = Usage[int32(ETopDownShooterLLMTag::Debris)];
+	FTagUsage& Inventory = Usage[int32(ETopDownShooterLLMTag::Inventory)];
+	FTagUsage& WeaponData = Usage[int32(ETopDownShooterLLMTag::WeaponData)];
+	FTagUsage& ImpactFX = Usage[int32(ETopDownShooterLLMTag::ImpactFX)];
+
+	for (TActorIterator<AWeaponDefault> It(World); It; ++It)
+	{
+		Weapons.Count++;
+		Weapons.Bytes += CountActorBytes(*It);
+		//the FWeaponInfos copy, its FProjectileInfos maps included
+		WeaponData.Count++;
+		WeaponData.Bytes += sizeof(FWeaponInfos) + CountProjectileInfosBytes(It->WeaponSetting.ProjectileSetting);
+	}
+
+	for (TActorIterator<AProjectileDefault> It(World); It; ++It)
+	{
+		Projectiles.Count++;
+		Projectiles.Bytes += CountActorBytes(*It);
+		WeaponData.Count++;
+		WeaponData.Bytes += sizeof(FProjectileInfos) + CountProjectileInfosBytes(It->ProjectileSetting);
+	}
+
+	for (TActorIterator<ADropMeshActor> It(World); It; ++It)
+	{
+		Debris.Count++;
+		Debris.Bytes += CountActorBytes(*It);
+	}
+
+	for (TObjectIterator<UTopDownShooterInventorComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World && !It->IsTemplate())
+		{
+			Inventory.Count++;
+			Inventory.Bytes += CountObjectBytes(*It);
+		}
+	}
+
+	//by class, impact emitters and decals end up on the world settings, the hit actor or a pool
+	for (TObjectIterator<UParticleSystemComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World && !It->IsTemplate())
+		{
+			ImpactFX.Count++;
+			ImpactFX.Bytes += CountObjectBytes(*It);
+		}
+	}
+	for (TObjectIterator<UDecalComponent> It; It; ++It)
+	{
+		if (It->GetWorld() == World && !It->IsTemplate())
+		{
+			ImpactFX.Count++;
+			ImpactFX.Bytes += CountObjectBytes(*It);
+		}
+	}
+
+	Ar.Logf(TEXT("TPS.MemReport - %s, LLM %s"), *World->GetMapName(), GetTrackedBytes(ETopDownShooterLLMTag::Weapons) >= 0 ? TEXT("on") : TEXT("off (run with -llm)"));
+	Ar.Logf(TEXT("%-18s %8s %12s %12s"), TEXT("Tag"), TEXT("Live"), TEXT("CountedKB"), TEXT("LLMKB"));
+	for (int32 i = 0; i < int32(ETopDownShooterLLMTag::Count); i++)
+	{
+		const int64 TrackedBytes = GetTrackedBytes(ETopDownShooterLLMTag(i));
+		Ar.Logf(TEXT("%-18s %8d %12.1f %12s"), TagNames[i], Usage[i].Count, Usage[i].Bytes / 1024.0,
+			TrackedBytes >= 0 ? *FString::Printf(TEXT("%.1f"), TrackedBytes / 1024.0) : TEXT("-"));
+	}
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice CmdMemReport(TEXT("TPS.MemReport"), TEXT("Live counts and bytes of weapons, projectiles, debris, inventory, weapon data and impact fx"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FTopDownShooterMemory::DumpReport(World, Ar);
+	}));
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+static FDelayedAutoRegisterHelper LLMTagRegistration(EDelayedRegisterRunPhase::EndOfEngineInit, []
+{
+#if STATS
+	const FName StatNames[] = { GET_STATFNAME(STAT_TPS_WeaponsLLM), GET_STATFNAME(STAT_TPS_ProjectilesLLM), GET_STATFNAME(STAT_TPS_DebrisLLM),
+		GET_STATFNAME(STAT_TPS_InventoryLLM), GET_STATFNAME(STAT_TPS_WeaponDataLLM), GET_STATFNAME(STAT_TPS_ImpactFXLLM) };
+	const FName SummaryStatName = GET_STATFNAME(STAT_TPS_SummaryLLM);
+#else
+	const FName StatNames[int32(ETopDownShooterLLMTag::Count)];
+	const FName SummaryStatName;
+#endif
+	for (int32 i = 0; i < int32(ETopDownShooterLLMTag::Count); i++)
+	{
+		FLowLevelMemTracker::Get().RegisterProjectTag(int32(FTopDownShooterMemory::ToLLMTag(ETopDownShooterLLMTag(i))), TopDownShooterMemory::TagNames[i], StatNames[i], SummaryStatName);
+	}
+});
+#endif
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+
+class UWorld;
+class FOutputDevice;
+
+//LLM tags of the gameplay code, they sit in the project tag range of the engine
+enum class ETopDownShooterLLMTag : uint8
+{
+	Weapons,
+	Projectiles,
+	Debris,
+	Inventory,
+	//FWeaponInfos / FProjectileInfos copies out of the data tables
+	WeaponData,
+	ImpactFX,
+	Count
+};
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+#define TPS_LLM_SCOPE(Tag) LLM_SCOPE(FTopDownShooterMemory::ToLLMTag(ETopDownShooterLLMTag::Tag))
+#else
+#define TPS_LLM_SCOPE(Tag)
+#endif
+
+/**
+ * Memory attribution for weapons, projectiles, debris, inventory, weapon data and impact effects.
+ * Run with -llm to get the tags (also in "stat LLM" / "stat LLMFULL" and the LLM csv).
+ * TPS.MemReport prints live counts and bytes per tag, the benchmark adds the tracked bytes to its csv.
+ */
+struct TOPDOWNSHOOTER_API FTopDownShooterMemory
+{
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+	static ELLMTag ToLLMTag(ETopDownShooterLLMTag Tag) { return ELLMTag(int32(ELLMTag::ProjectTagStart) + int32(Tag)); }
+#endif
+
+	static const TCHAR* GetTagName(ETopDownShooterLLMTag Tag);
+	//bytes LLM tracks under the tag, -1 when LLM is off
+	static int64 GetTrackedBytes(ETopDownShooterLLMTag Tag);
+
+	//live objects and their counted bytes per tag
+	static void DumpReport(UWorld* World, FOutputDevice& Ar);
+};
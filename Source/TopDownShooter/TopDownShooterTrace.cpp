@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TopDownShooterTrace.h"
+
+#if TOPDOWNSHOOTER_TRACE_ENABLED
+
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/CommandLine.h"
+#include "Misc/DelayedAutoRegister.h"
+#include "Misc/MiscTrace.h"
+#include "Misc/Parse.h"
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, ShotFired)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ShotId)
+	UE_TRACE_EVENT_FIELD(uint32, WeaponId)
+	UE_TRACE_EVENT_FIELD(int32, Seed)
+	UE_TRACE_EVENT_FIELD(uint16, PelletCount)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, ProjectileSpawned)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ProjectileId)
+	UE_TRACE_EVENT_FIELD(uint32, ShotId)
+	UE_TRACE_EVENT_FIELD(bool, bRecycled)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, Hit)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ShotId)
+	UE_TRACE_EVENT_FIELD(uint32, ProjectileId)
+	UE_TRACE_EVENT_FIELD(float, Damage)
+	UE_TRACE_EVENT_FIELD(uint8, SurfaceType)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, Grenade)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, ProjectileId)
+	UE_TRACE_EVENT_FIELD(float, MaxDamage)
+	UE_TRACE_EVENT_FIELD(bool, bExploded)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, Reload)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, WeaponId)
+	UE_TRACE_EVENT_FIELD(uint8, Phase)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(TopDownShooter, WeaponSwitched)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint32, CharacterId)
+	UE_TRACE_EVENT_FIELD(uint32, WeaponId)
+	UE_TRACE_EVENT_FIELD(int32, SlotIndex)
+UE_TRACE_EVENT_END()
+
+int32 TraceBookmarksEnabled = 0;
+FAutoConsoleVariableRef CVARTraceBookmarksEnabled(TEXT("TPS.Trace.Bookmarks"), TraceBookmarksEnabled, TEXT("Also emit Insights bookmarks for traced gameplay events"), ECVF_Default);
+
+static FAutoConsoleCommand CmdTraceToggle(TEXT("TPS.Trace"), TEXT("TPS.Trace <0/1> - toggle the TopDownShooter trace events"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args)
+	{
+		Trace::ToggleEvent(TEXT("TopDownShooter"), Args.Num() == 0 || Args[0] != TEXT("0"));
+	}));
+
+//events are off unless asked for, like the engine loggers
+static FDelayedAutoRegisterHelper TraceStartupToggle(EDelayedRegisterRunPhase::EndOfEngineInit, []
+{
+	if (FParse::Param(FCommandLine::Get(), TEXT("TPSTrace")))
+		Trace::ToggleEvent(TEXT("TopDownShooter"), true);
+});
+
+static uint32 GetTraceId(const AActor* Actor)
+{
+	return Actor ? Actor->GetUniqueID() : 0;
+}
+
+void FTopDownShooterTrace::ShotFired(uint32& OutShotId, const AActor* Weapon, int32 PelletCount, int32 Seed)
+{
+	static TAtomic<uint32> NextShotId(1);
+	OutShotId = NextShotId++;
+
+	UE_TRACE_LOG(TopDownShooter, ShotFired)
+		<< ShotFired.Cycle(FPlatformTime::Cycles64())
+		<< ShotFired.ShotId(OutShotId)
+		<< ShotFired.WeaponId(GetTraceId(Weapon))
+		<< ShotFired.Seed(Seed)
+		<< ShotFired.PelletCount(uint16(PelletCount));
+
+	if (TraceBookmarksEnabled)
+		TRACE_BOOKMARK(TEXT("TPS Shot %u weapon %u"), OutShotId, GetTraceId(Weapon));
+}
+
+void FTopDownShooterTrace::ProjectileSpawned(const AActor* Projectile, uint32 ShotId, bool bRecycled)
+{
+	UE_TRACE_LOG(TopDownShooter, ProjectileSpawned)
+		<< ProjectileSpawned.Cycle(FPlatformTime::Cycles64())
+		<< ProjectileSpawned.ProjectileId(GetTraceId(Projectile))
+		<< ProjectileSpawned.ShotId(ShotId)
+		<< ProjectileSpawned.bRecycled(bRecycled);
+}
+
+void FTopDownShooterTrace::Hit(uint32 ShotId, const AActor* Projectile, uint8 SurfaceType, float Damage)
+{
+	UE_TRACE_LOG(TopDownShooter, Hit)
+		<< Hit.Cycle(FPlatformTime::Cycles64())
+		<< Hit.ShotId(ShotId)
+		<< Hit.ProjectileId(GetTraceId(Projectile))
+		<< Hit.Damage(Damage)
+		<< Hit.SurfaceType(SurfaceType);
+
+	if (TraceBookmarksEnabled)
+		TRACE_BOOKMARK(TEXT("TPS Hit shot %u projectile %u surface %u"), ShotId, GetTraceId(Projectile), uint32(SurfaceType));
+}
+
+void FTopDownShooterTrace::GrenadeArmed(const AActor* Projectile)
+{
+	UE_TRACE_LOG(TopDownShooter, Grenade)
+		<< Grenade.Cycle(FPlatformTime::Cycles64())
+		<< Grenade.ProjectileId(GetTraceId(Projectile))
+		<< Grenade.MaxDamage(0.0f)
+		<< Grenade.bExploded(false);
+}
+
+void FTopDownShooterTrace::GrenadeExploded(const AActor* Projectile, float MaxDamage)
+{
+	UE_TRACE_LOG(TopDownShooter, Grenade)
+		<< Grenade.Cycle(FPlatformTime::Cycles64())
+		<< Grenade.ProjectileId(GetTraceId(Projectile))
+		<< Grenade.MaxDamage(MaxDamage)
+		<< Grenade.bExploded(true);
+
+	if (TraceBookmarksEnabled)
+		TRACE_BOOKMARK(TEXT("TPS Grenade %u exploded"), GetTraceId(Projectile));
+}
+
+void FTopDownShooterTrace::Reload(const AActor* Weapon, ETopDownShooterReloadTrace Phase)
+{
+	UE_TRACE_LOG(TopDownShooter, Reload)
+		<< Reload.Cycle(FPlatformTime::Cycles64())
+		<< Reload.WeaponId(GetTraceId(Weapon))
+		<< Reload.Phase(uint8(Phase));
+}
+
+void FTopDownShooterTrace::WeaponSwitched(const AActor* Character, const AActor* Weapon, int32 SlotIndex)
+{
+	UE_TRACE_LOG(TopDownShooter, WeaponSwitched)
+		<< WeaponSwitched.Cycle(FPlatformTime::Cycles64())
+		<< WeaponSwitched.CharacterId(GetTraceId(Character))
+		<< WeaponSwitched.WeaponId(GetTraceId(Weapon))
+		<< WeaponSwitched.SlotIndex(SlotIndex);
+
+	if (TraceBookmarksEnabled)
+		TRACE_BOOKMARK(TEXT("TPS Switch character %u to slot %d"), GetTraceId(Character), SlotIndex);
+}
+
+#endif
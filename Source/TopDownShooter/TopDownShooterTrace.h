@@ -0,0 +1,42 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+
+#define TOPDOWNSHOOTER_TRACE_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+
+#if TOPDOWNSHOOTER_TRACE_ENABLED
+
+enum class ETopDownShooterReloadTrace : uint8
+{
+	Started,
+	Finished,
+	Cancelled,
+};
+
+/**
+ * Gameplay events for Unreal Insights, logger "TopDownShooter" (enable with -TPSTrace or TPS.Trace 1).
+ * Shots get a fresh ShotId, actors are identified by GetUniqueID(), so a hit links back to its projectile,
+ * the projectile to its shot and the shot to its weapon. TPS.Trace.Bookmarks also drops bookmarks in the timing view.
+ */
+struct TOPDOWNSHOOTER_API FTopDownShooterTrace
+{
+	static void ShotFired(uint32& OutShotId, const AActor* Weapon, int32 PelletCount, int32 Seed);
+	static void ProjectileSpawned(const AActor* Projectile, uint32 ShotId, bool bRecycled);
+	//ShotId for hitscan hits, Projectile for projectile hits
+	static void Hit(uint32 ShotId, const AActor* Projectile, uint8 SurfaceType, float Damage);
+	static void GrenadeArmed(const AActor* Projectile);
+	static void GrenadeExploded(const AActor* Projectile, float MaxDamage);
+	static void Reload(const AActor* Weapon, ETopDownShooterReloadTrace Phase);
+	static void WeaponSwitched(const AActor* Character, const AActor* Weapon, int32 SlotIndex);
+};
+
+#define TPS_TRACE(Call) FTopDownShooterTrace::Call
+
+#else
+
+#define TPS_TRACE(Call)
+
+#endif
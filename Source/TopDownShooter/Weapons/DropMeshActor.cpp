@@ -0,0 +1,21 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DropMeshActor.h"
+#include "TopDownShooter.h"
+
+void ADropMeshActor::BeginPlay()
+{
+	Super::BeginPlay();
+
+	INC_DWORD_STAT(STAT_TPS_DebrisActors);
+	FTopDownShooterCounters::DebrisActors++;
+}
+
+void ADropMeshActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT(STAT_TPS_DebrisActors);
+	FTopDownShooterCounters::DebrisActors--;
+
+	Super::EndPlay(EndPlayReason);
+}
@@ -0,0 +1,18 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StaticMeshActor.h"
+#include "DropMeshActor.generated.h"
+
+//Shells and clips thrown out by weapons
+UCLASS(NotBlueprintable)
+class TOPDOWNSHOOTER_API ADropMeshActor : public AStaticMeshActor
+{
+	GENERATED_BODY()
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+};
@@ -0,0 +1,138 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileBatchMover.h"
+#include "Game/TopDownShooterPawnHitGrid.h"
+#include "Async/ParallelFor.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Batch Move"), STAT_TPS_ProjectileBatch, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectile Batch Sweep"), STAT_TPS_ProjectileBatchSweep, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Projectile Batch Apply"), STAT_TPS_ProjectileBatchApply, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batched Projectiles"), STAT_TPS_BatchedProjectiles, STATGROUP_TopDownShooter);
+
+int32 ProjectileBatchEnabled = 1;
+FAutoConsoleVariableRef CVARProjectileBatchEnabled(TEXT("TPS.ProjectileBatch"), ProjectileBatchEnabled, TEXT("Move non-bouncing projectiles in one parallel batch, applies to projectiles spawned afterwards"), ECVF_Default);
+
+int32 ProjectileBatchParallelMin = 32;
+FAutoConsoleVariableRef CVARProjectileBatchParallelMin(TEXT("TPS.ProjectileBatch.ParallelMin"), ProjectileBatchParallelMin, TEXT("Projectiles needed before the sweeps are split over worker threads"), ECVF_Default);
+
+//sweeps are heavy, small chunks keep the workers balanced
+static const int32 ProjectileBatchChunkSize = 16;
+
+void UProjectileBatchMover::Deinitialize()
+{
+	Projectiles.Empty();
+	Steps.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UProjectileBatchMover::IsEnabled()
+{
+	return ProjectileBatchEnabled != 0;
+}
+
+bool UProjectileBatchMover::IsTickable() const
+{
+	return Projectiles.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UProjectileBatchMover::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileBatchMover, STATGROUP_Tickables);
+}
+
+void UProjectileBatchMover::RegisterProjectile(UProjectileGridMovementComponent* Projectile)
+{
+	if (Projectile)
+		Projectiles.Add(Projectile);
+}
+
+void UProjectileBatchMover::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_ProjectileBatch);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, ProjectileBatch);
+
+	Gather(DeltaTime);
+	SET_DWORD_STAT(STAT_TPS_BatchedProjectiles, Steps.Num());
+	if (Steps.Num() == 0)
+		return;
+
+	Sweep();
+	Apply();
+}
+
+void UProjectileBatchMover::Gather(float DeltaTime)
+{
+	//stable compaction, hits are applied in the order the projectiles were fired
+	Steps.Reset();
+	int32 NumKept = 0;
+	for (int32 i = 0; i < Projectiles.Num(); i++)
+	{
+		UProjectileGridMovementComponent* myProjectile = Projectiles[i].Get();
+		if (!myProjectile || !myProjectile->IsBatched())
+			continue;
+
+		Steps.AddDefaulted();
+		if (!myProjectile->PrepareBatchStep(DeltaTime, Steps.Last()))
+		{
+			Steps.Pop(false);
+			continue;
+		}
+		Projectiles[NumKept++] = Projectiles[i];
+	}
+	Projectiles.SetNum(NumKept, false);
+}
+
+void UProjectileBatchMover::Sweep()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_ProjectileBatchSweep);
+
+	//built here, workers only read it
+	UTopDownShooterPawnHitGrid* PawnHitGrid = UTopDownShooterPawnHitGrid::IsEnabled() ? GetWorld()->GetSubsystem<UTopDownShooterPawnHitGrid>() : nullptr;
+	if (PawnHitGrid)
+	{
+		PawnHitGrid->EnsureBuilt();
+		TPS_COUNT_TRACES(PawnGridTraces, Steps.Num());
+	}
+	TPS_COUNT_TRACES(ProjectileBatchTraces, Steps.Num());
+
+	const UWorld* myWorld = GetWorld();
+	const UTopDownShooterPawnHitGrid* myPawnHitGrid = PawnHitGrid;
+	TArray<FProjectileBatchStep>& mySteps = Steps;
+	const int32 Num = Steps.Num();
+	const int32 NumChunks = FMath::DivideAndRoundUp(Num, ProjectileBatchChunkSize);
+
+	auto SweepChunk = [myWorld, myPawnHitGrid, &mySteps, Num](int32 ChunkIndex)
+	{
+		const int32 First = ChunkIndex * ProjectileBatchChunkSize;
+		const int32 Last = FMath::Min(First + ProjectileBatchChunkSize, Num);
+		for (int32 i = First; i < Last; i++)
+			UProjectileGridMovementComponent::SweepBatchStep(myWorld, myPawnHitGrid, mySteps[i]);
+	};
+
+	if (Num >= ProjectileBatchParallelMin && NumChunks > 1)
+	{
+		ParallelFor(NumChunks, SweepChunk);
+	}
+	else
+	{
+		for (int32 ChunkIndex = 0; ChunkIndex < NumChunks; ChunkIndex++)
+			SweepChunk(ChunkIndex);
+	}
+}
+
+void UProjectileBatchMover::Apply()
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_ProjectileBatchApply);
+
+	//hit events may spawn or destroy projectiles, new ones join the next frame
+	for (const FProjectileBatchStep& Step : Steps)
+	{
+		if (UProjectileGridMovementComponent* myProjectile = Step.Projectile.Get())
+			myProjectile->ApplyBatchStep(Step);
+	}
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "Weapons/Projectiles/ProjectileGridMovementComponent.h"
+#include "ProjectileBatchMover.generated.h"
+
+/**
+ * Moves every non-bouncing projectile of the world in one pass instead of one component tick each.
+ * Moves are gathered on the game thread, integrated and swept in parallel chunks (read only physics scene
+ * and pawn hit grid queries), then positions and hits are applied back on the game thread in registration order.
+ * Ticks with the tickable objects, after the physics scene finished simulating for the frame.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UProjectileBatchMover : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//TPS.ProjectileBatch, off means every projectile ticks its own movement
+	static bool IsEnabled();
+
+	//the component stops ticking itself while registered, it leaves the batch once it stops or ends play
+	void RegisterProjectile(UProjectileGridMovementComponent* Projectile);
+
+	int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+private:
+	void Gather(float DeltaTime);
+	void Sweep();
+	void Apply();
+
+	TArray<TWeakObjectPtr<UProjectileGridMovementComponent>> Projectiles;
+	//scratch, one per projectile moving this frame
+	TArray<FProjectileBatchStep> Steps;
+};
@@ -4,44 +4,45 @@
 #include "ProjectileDefault.h"
 #include "Components/StaticMeshComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "FuncLibrary/CosmeticLibrary.h"
+#include "Weapons/Projectiles/ProjectileGridMovementComponent.h"
+#include "Game/TopDownShooterPawnHitGrid.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterTrace.h"
+#include "TopDownShooterMemory.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Hit"), STAT_TPS_ProjectileHit, STATGROUP_TopDownShooter);
 
 // Sets default values
 AProjectileDefault::AProjectileDefault()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	//movement component moves it, grenade fuses run in UProjectileFuseScheduler, nothing to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	BulletCollisionSphere = CreateDefaultSubobject<USphereComponent>(TEXT("Collision Sphere"));
 
 	BulletCollisionSphere->SetSphereRadius(16.f);
 
-	BulletCollisionSphere->OnComponentHit.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereHit);
-	BulletCollisionSphere->OnComponentBeginOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereBeginOverlap);
-	BulletCollisionSphere->OnComponentEndOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereEndOverlap);
-
 	BulletCollisionSphere->bReturnMaterialOnMove = true;//hit event return physMaterial
 
 	BulletCollisionSphere->SetCanEverAffectNavigation(false);//collision not affect navigation (P keybord on editor)
 
 	RootComponent = BulletCollisionSphere;
 
-	BulletMesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Bullet Projectile Mesh"));
-	BulletMesh->SetupAttachment(RootComponent);
-	BulletMesh->SetCanEverAffectNavigation(false);
-
-	BulletFX = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("Bullet FX"));
-	BulletFX->SetupAttachment(RootComponent);
+	//mesh and trail fx are made in InitProjectile, most bullets have neither
 
 	//BulletSound = CreateDefaultSubobject<UAudioComponent>(TEXT("Bullet Audio"));
 	//BulletSound->SetupAttachment(RootComponent);
 
-	BulletProjectileMovement = CreateDefaultSubobject<UProjectileMovementComponent>(TEXT("Bullet ProjectileMovement"));
+	//pawns are found through the pawn hit grid, world geometry through physics
+	BulletProjectileMovement = CreateDefaultSubobject<UProjectileGridMovementComponent>(TEXT("Bullet ProjectileMovement"));
 	BulletProjectileMovement->UpdatedComponent = RootComponent;
 	BulletProjectileMovement->InitialSpeed = 1.f;
 	BulletProjectileMovement->MaxSpeed = 0.f;
 
 	BulletProjectileMovement->bRotationFollowsVelocity = true;
-	BulletProjectileMovement->bShouldBounce = true;
+	//bullets end on their first hit, which lets UProjectileBatchMover move them
+	BulletProjectileMovement->bShouldBounce = false;
 }
 
 // Called when the game starts or when spawned
@@ -49,49 +50,72 @@ void AProjectileDefault::BeginPlay()
 {
 	Super::BeginPlay();
 
-	BulletCollisionSphere->OnComponentHit.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereHit);
-	BulletCollisionSphere->OnComponentBeginOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereBeginOverlap);
-	BulletCollisionSphere->OnComponentEndOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereEndOverlap);
+	INC_DWORD_STAT(STAT_TPS_LiveProjectiles);
+	FTopDownShooterCounters::LiveProjectiles++;
 
+	BulletCollisionSphere->OnComponentHit.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereHit);
+	if (bBindOverlapEvents)
+	{
+		BulletCollisionSphere->OnComponentBeginOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereBeginOverlap);
+		BulletCollisionSphere->OnComponentEndOverlap.AddDynamic(this, &AProjectileDefault::BulletCollisionSphereEndOverlap);
+	}
 }
 
-// Called every frame
-void AProjectileDefault::Tick(float DeltaTime)
+void AProjectileDefault::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
+	DEC_DWORD_STAT(STAT_TPS_LiveProjectiles);
+	FTopDownShooterCounters::LiveProjectiles--;
 
+	Super::EndPlay(EndPlayReason);
 }
 
-void AProjectileDefault::InitProjectile(FProjectileInfos InitParam)
+void AProjectileDefault::InitProjectile(const FProjectileInfos& InitParam)
 {
 	BulletProjectileMovement->InitialSpeed = InitParam.ProjectileInitSpeed;
 	BulletProjectileMovement->MaxSpeed = InitParam.ProjectileInitSpeed;
 	this->SetLifeSpan(InitParam.ProjectileLifeTime);
-	if (InitParam.ProjectileStaticMesh)
+
+	//mesh and trail are visuals only, only the ones the row uses get created
+	const bool bCosmetics = UCosmeticLibrary::ShouldPlayCosmetics(this);
+	if (InitParam.ProjectileStaticMesh && bCosmetics)
 	{
+		if (!BulletMesh)
+		{
+			BulletMesh = NewObject<UStaticMeshComponent>(this, TEXT("Bullet Projectile Mesh"));
+			BulletMesh->SetCanEverAffectNavigation(false);
+			BulletMesh->SetupAttachment(RootComponent);
+		}
 		BulletMesh->SetStaticMesh(InitParam.ProjectileStaticMesh);
 		BulletMesh->SetRelativeTransform(InitParam.ProjectileStaticMeshOffset);
-	}
-	else
-	{
-		BulletMesh->DestroyComponent();
+		if (!BulletMesh->IsRegistered())
+			BulletMesh->RegisterComponent();
 	}
 
-	if (InitParam.ProjectileTrailFx)
+	if (InitParam.ProjectileTrailFx && bCosmetics)
 	{
+		if (!BulletFX)
+		{
+			BulletFX = NewObject<UParticleSystemComponent>(this, TEXT("Bullet FX"));
+			BulletFX->SetupAttachment(RootComponent);
+		}
 		BulletFX->SetTemplate(InitParam.ProjectileTrailFx);
 		BulletFX->SetRelativeTransform(InitParam.ProjectileTrailFxOffset);
+		if (!BulletFX->IsRegistered())
+			BulletFX->RegisterComponent();
 	}
-	else
+
 	{
-		BulletFX->DestroyComponent();
+		//the hit maps are copied into every projectile
+		TPS_LLM_SCOPE(WeaponData);
+		ProjectileSetting = InitParam;
 	}
-
-	ProjectileSetting = InitParam;
 }
 
 void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
+	SCOPE_CYCLE_COUNTER(STAT_TPS_ProjectileHit);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, ProjectileHit);
+
 	if (OtherActor && Hit.PhysMaterial.IsValid())
 	{
 		EPhysicalSurface mySurfacetype = UGameplayStatics::GetSurfaceType(Hit);
@@ -102,7 +126,7 @@ void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp,
 
 			if (myMaterial && OtherComp)
 			{
-				UGameplayStatics::SpawnDecalAttached(myMaterial, FVector(20.0f), OtherComp, NAME_None, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition, 10.0f);
+				UCosmeticLibrary::QueueDecalAttached(myMaterial, FVector(20.0f), OtherComp, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), 10.0f);
 			}
 		}
 		if (ProjectileSetting.HitFXs.Contains(mySurfacetype))
@@ -110,17 +134,19 @@ void AProjectileDefault::BulletCollisionSphereHit(UPrimitiveComponent* HitComp,
 			UParticleSystem* myParticle = ProjectileSetting.HitFXs[mySurfacetype];
 			if (myParticle)
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), myParticle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
+				UCosmeticLibrary::QueueEmitterAtLocation(this, myParticle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
 			}
 		}
 
 		if (ProjectileSetting.HitSound)
 		{
-			UGameplayStatics::PlaySoundAtLocation(GetWorld(), ProjectileSetting.HitSound, Hit.ImpactPoint);
+			UCosmeticLibrary::PlaySoundAtLocation(this, ProjectileSetting.HitSound, Hit.ImpactPoint);
 		}
 
 	}
-	UGameplayStatics::ApplyDamage(OtherActor, ProjectileSetting.ProjectileDamage, GetInstigatorController(), this, NULL);
+	TPS_TRACE(Hit(0, this, Hit.PhysMaterial.IsValid() ? uint8(UGameplayStatics::GetSurfaceType(Hit)) : 0, ProjectileSetting.ProjectileDamage));
+	const UProjectileGridMovementComponent* myGridMovement = Cast<UProjectileGridMovementComponent>(BulletProjectileMovement);
+	UTopDownShooterPawnHitGrid::ApplyHitDamage(GetWorld(), Hit, myGridMovement ? myGridMovement->GetHitHordeEntity() : 0, ProjectileSetting.ProjectileDamage, GetInstigatorController(), this);
 	ImpactProjectile();
 	//UGameplayStatics::ApplyRadialDamageWithFalloff()
 	//Apply damage cast to if char like bp? //OnAnyTakeDmage delegate
@@ -3,40 +3,48 @@
 
 #include "ProjectileDefault_Grenade.h"
 #include "Kismet/GameplayStatics.h"
+#include "FuncLibrary/CosmeticLibrary.h"
 #include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "Weapons/Projectiles/ProjectileFuseScheduler.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterTrace.h"
+
+DECLARE_CYCLE_STAT(TEXT("Grenade Explose"), STAT_TPS_GrenadeExplose, STATGROUP_TopDownShooter);
 
 int32 DebugExplodeShow = 0;
 FAutoConsoleVariableRef CVARExplodeShow(TEXT("TPS.DebugExplode"), DebugExplodeShow, TEXT("Draw Debug for Explode"), ECVF_Cheat);
 
+AProjectileDefault_Grenade::AProjectileDefault_Grenade()
+{
+	//rolls on after the first hit until GrenadeStop, so it keeps its own ticked movement
+	BulletProjectileMovement->bShouldBounce = true;
+}
+
 void AProjectileDefault_Grenade::BeginPlay()
 {
 	Super::BeginPlay();
 
+	BulletProjectileMovement->OnProjectileStop.AddDynamic(this, &AProjectileDefault_Grenade::GrenadeStop);
 }
 
-void AProjectileDefault_Grenade::Tick(float DeltaTime)
+void AProjectileDefault_Grenade::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	Super::Tick(DeltaTime);
-	TimerExplose(DeltaTime);
-
+	if (FuseId != 0)
+	{
+		if (UProjectileFuseScheduler* myFuseScheduler = GetWorld()->GetSubsystem<UProjectileFuseScheduler>())
+			myFuseScheduler->CancelFuse(FuseId);
+		FuseId = 0;
+	}
 
+	Super::EndPlay(EndPlayReason);
 }
 
-void AProjectileDefault_Grenade::TimerExplose(float DeltaTime)
+void AProjectileDefault_Grenade::GrenadeStop(const FHitResult& ImpactResult)
 {
-	if (TimerEnabled)
-	{
-		if (TimerToExplose > TimeToExplose)
-		{
-			//Explose
-			Explose();
-
-		}
-		else
-		{
-			TimerToExplose += DeltaTime;
-		}
-	}
+	BulletProjectileMovement->Deactivate();
+	if (BulletCollisionSphere->IsSimulatingPhysics())
+		BulletCollisionSphere->PutAllRigidBodiesToSleep();
 }
 
 void AProjectileDefault_Grenade::BulletCollisionSphereHit(class UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
@@ -47,25 +55,33 @@ void AProjectileDefault_Grenade::BulletCollisionSphereHit(class UPrimitiveCompon
 void AProjectileDefault_Grenade::ImpactProjectile()
 {
 	//Init Grenade
-	TimerEnabled = true;
+	if (!TimerEnabled)
+	{
+		TPS_TRACE(GrenadeArmed(this));
+		TimerEnabled = true;
+		if (UProjectileFuseScheduler* myFuseScheduler = GetWorld()->GetSubsystem<UProjectileFuseScheduler>())
+			FuseId = myFuseScheduler->ScheduleFuse(this, TimeToExplose);
+		else
+			Explose();
+	}
 }
 
 void AProjectileDefault_Grenade::Explose()
 {
+	SCOPE_CYCLE_COUNTER(STAT_TPS_GrenadeExplose);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, GrenadeExplose);
+
 	if (DebugExplodeShow)
 	{
 		DrawDebugSphere(GetWorld(), GetActorLocation(), ProjectileSetting.ProjectileMaxRadiusDamage, 12, FColor::Green, false, 12.0f);
 		DrawDebugSphere(GetWorld(), GetActorLocation(), ProjectileSetting.ProjectileMaxRadiusDamage, 12, FColor::Red, false, 12.0f);
 	}
 	TimerEnabled = false;
-	if (ProjectileSetting.ExploseFX)
-	{
-		UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ProjectileSetting.ExploseFX, GetActorLocation(), GetActorRotation(), FVector(1.0f));
-	}
-	if (ProjectileSetting.ExploseSound)
-	{
-		UGameplayStatics::PlaySoundAtLocation(GetWorld(), ProjectileSetting.ExploseSound, GetActorLocation());
-	}
+	FuseId = 0;
+	TPS_TRACE(GrenadeExploded(this, ProjectileSetting.ExploseMaxDamage));
+	//the explosion is gameplay feedback that lines up with its damage, never deferred or dropped
+	UCosmeticLibrary::SpawnEmitterAtLocation(this, ProjectileSetting.ExploseFX, FTransform(GetActorRotation(), GetActorLocation()));
+	UCosmeticLibrary::PlaySoundAtLocation(this, ProjectileSetting.ExploseSound, GetActorLocation());
 
 	TArray<AActor*> IgnoredActor;
 	UGameplayStatics::ApplyRadialDamageWithFalloff(GetWorld(),
@@ -13,15 +13,18 @@ class TOPDOWNSHOOTER_API AProjectileDefault_Grenade : public AProjectileDefault
 {
 	GENERATED_BODY()
 
+public:
+	AProjectileDefault_Grenade();
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-
-	void TimerExplose(float DeltaTime);
+	//came to rest, keep it asleep until the fuse burns out
+	UFUNCTION()
+	void GrenadeStop(const FHitResult& ImpactResult);
 
 	virtual void BulletCollisionSphereHit(class UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit) override;
 
@@ -30,7 +33,8 @@ public:
 	void Explose();
 
 	bool TimerEnabled = false;
-	float TimerToExplose = 0.0f;
 	float TimeToExplose = 2.0f;
+	//UProjectileFuseScheduler fuse while armed
+	uint32 FuseId = 0;
 	
 };
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileFuseScheduler.h"
+#include "Weapons/Projectiles/ProjectileDefault_Grenade.h"
+#include "Engine/World.h"
+#include "Algo/BinarySearch.h"
+#include "TopDownShooter.h"
+
+DECLARE_CYCLE_STAT(TEXT("Projectile Fuses"), STAT_TPS_ProjectileFuses, STATGROUP_TopDownShooter);
+
+static const double FuseWheelSlotSeconds = 1.0 / 30.0;
+
+void UProjectileFuseScheduler::Deinitialize()
+{
+	for (TArray<FProjectileFuse>& Slot : Wheel)
+	{
+		Slot.Empty();
+	}
+	FuseSlots.Empty();
+	CurrentWheelTick = -1;
+
+	Super::Deinitialize();
+}
+
+int64 UProjectileFuseScheduler::GetWheelTick(float Time) const
+{
+	return int64(FMath::FloorToDouble(double(Time) / FuseWheelSlotSeconds));
+}
+
+void UProjectileFuseScheduler::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_ProjectileFuses);
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	const int64 NowWheelTick = GetWheelTick(Now);
+
+	//one turn visits every slot, a long hitch does not need more
+	const int64 FirstWheelTick = FMath::Max(CurrentWheelTick + 1, NowWheelTick - FuseWheelSlots + 1);
+	for (int64 WheelTick = FirstWheelTick; WheelTick <= NowWheelTick; WheelTick++)
+	{
+		TArray<FProjectileFuse>& Slot = Wheel[WheelTick % FuseWheelSlots];
+		int32 NumBurnt = 0;
+		while (NumBurnt < Slot.Num() && Slot[NumBurnt].Deadline <= Now)
+		{
+			FuseSlots.Remove(Slot[NumBurnt].Id);
+			BurntOut.Add(Slot[NumBurnt].Grenade);
+			NumBurnt++;
+		}
+		if (NumBurnt > 0)
+			Slot.RemoveAt(0, NumBurnt, false);
+	}
+	//the current slot is only partly over, fuses later in its window are walked again next frame
+	CurrentWheelTick = FMath::Max(CurrentWheelTick, NowWheelTick - 1);
+	checkSlow(Wheel[NowWheelTick % FuseWheelSlots].Num() == 0 || Wheel[NowWheelTick % FuseWheelSlots][0].Deadline > Now);
+
+	//explosions may arm or cancel other fuses, so they go off after the wheel is walked
+	for (const TWeakObjectPtr<AProjectileDefault_Grenade>& Grenade : BurntOut)
+	{
+		if (Grenade.IsValid())
+			Grenade->Explose();
+	}
+	BurntOut.Reset();
+}
+
+bool UProjectileFuseScheduler::IsTickable() const
+{
+	return FuseSlots.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UProjectileFuseScheduler::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UProjectileFuseScheduler, STATGROUP_Tickables);
+}
+
+uint32 UProjectileFuseScheduler::ScheduleFuse(AProjectileDefault_Grenade* Grenade, float Delay)
+{
+	if (!Grenade)
+		return 0;
+
+	const float Now = GetWorld()->GetTimeSeconds();
+	if (FuseSlots.Num() == 0)
+		CurrentWheelTick = GetWheelTick(Now) - 1;
+
+	FProjectileFuse Fuse;
+	Fuse.Id = NextFuseId++;
+	if (NextFuseId == 0)
+		NextFuseId = 1;
+	Fuse.Deadline = Now + FMath::Max(Delay, 0.0f);
+	Fuse.Grenade = Grenade;
+
+	//never into a slot that was already walked this turn, the current one is walked again
+	const int64 WheelTick = FMath::Max(GetWheelTick(Fuse.Deadline), CurrentWheelTick + 1);
+	const int32 SlotIndex = int32(WheelTick % FuseWheelSlots);
+
+	TArray<FProjectileFuse>& Slot = Wheel[SlotIndex];
+	const int32 InsertIndex = Algo::UpperBoundBy(Slot, Fuse.Deadline, [](const FProjectileFuse& Entry) { return Entry.Deadline; });
+	Slot.Insert(Fuse, InsertIndex);
+	FuseSlots.Add(Fuse.Id, SlotIndex);
+
+	return Fuse.Id;
+}
+
+void UProjectileFuseScheduler::CancelFuse(uint32 FuseId)
+{
+	int32 SlotIndex = INDEX_NONE;
+	if (!FuseSlots.RemoveAndCopyValue(FuseId, SlotIndex))
+		return;
+
+	TArray<FProjectileFuse>& Slot = Wheel[SlotIndex];
+	const int32 Index = Slot.IndexOfByPredicate([FuseId](const FProjectileFuse& Entry) { return Entry.Id == FuseId; });
+	if (Index != INDEX_NONE)
+		Slot.RemoveAt(Index, 1, false);
+}
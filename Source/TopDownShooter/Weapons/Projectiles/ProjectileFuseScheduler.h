@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "ProjectileFuseScheduler.generated.h"
+
+class AProjectileDefault_Grenade;
+
+struct FProjectileFuse
+{
+	uint32 Id = 0;
+	//world time the fuse burns out
+	float Deadline = 0.0f;
+	TWeakObjectPtr<AProjectileDefault_Grenade> Grenade;
+};
+
+/**
+ * Grenade fuses for the whole world, so projectiles never need to tick.
+ * Timer wheel of FuseWheelSlots buckets of 1/30 s, every bucket sorted by deadline.
+ * Fuses longer than one turn of the wheel wait in their bucket until the deadline is reached.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UProjectileFuseScheduler : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//returns the fuse id, Explose() is called on the grenade Delay seconds of world time from now
+	uint32 ScheduleFuse(AProjectileDefault_Grenade* Grenade, float Delay);
+	void CancelFuse(uint32 FuseId);
+
+	int32 GetNumFuses() const { return FuseSlots.Num(); }
+
+	static const int32 FuseWheelSlots = 64;
+
+private:
+	int64 GetWheelTick(float Time) const;
+
+	TArray<FProjectileFuse> Wheel[FuseWheelSlots];
+	//fuse id -> wheel slot
+	TMap<uint32, int32> FuseSlots;
+	//last wheel tick whose whole interval has passed and was processed
+	int64 CurrentWheelTick = -1;
+	uint32 NextFuseId = 1;
+
+	//scratch, fuses that burnt out this frame
+	TArray<TWeakObjectPtr<AProjectileDefault_Grenade>> BurntOut;
+};
@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectileGridMovementComponent.h"
+#include "Game/TopDownShooterPawnHitGrid.h"
+#include "Weapons/Projectiles/ProjectileBatchMover.h"
+#include "Components/SphereComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+void UProjectileGridMovementComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	UWorld* myWorld = GetWorld();
+	bUsePawnHitGrid = UTopDownShooterPawnHitGrid::IsEnabled() && UpdatedPrimitive && myWorld && myWorld->IsGameWorld();
+	if (!bUsePawnHitGrid)
+		return;
+
+	//pawns come from the grid, physics only sees world geometry
+	UpdatedPrimitive->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+
+	USphereComponent* mySphere = Cast<USphereComponent>(UpdatedPrimitive);
+	SweepRadius = mySphere ? mySphere->GetScaledSphereRadius() : UpdatedPrimitive->Bounds.SphereRadius;
+
+	IgnoredActors.Reset();
+	if (AActor* myOwner = GetOwner())
+	{
+		if (APawn* myInstigator = myOwner->GetInstigator())
+			IgnoredActors.Add(myInstigator);
+	}
+}
+
+void UProjectileGridMovementComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	//bounces and homing need the substeps of the ticked move
+	UWorld* myWorld = GetWorld();
+	UProjectileBatchMover* myBatchMover = UProjectileBatchMover::IsEnabled() && myWorld && myWorld->IsGameWorld() ? myWorld->GetSubsystem<UProjectileBatchMover>() : nullptr;
+	if (myBatchMover && UpdatedPrimitive && !bShouldBounce && !bIsHomingProjectile)
+	{
+		bBatched = true;
+		SetComponentTickEnabled(false);
+		myBatchMover->RegisterProjectile(this);
+	}
+}
+
+void UProjectileGridMovementComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	//the batch mover drops it on its next gather
+	bBatched = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+bool UProjectileGridMovementComponent::PrepareBatchStep(float DeltaTime, FProjectileBatchStep& OutStep)
+{
+	if (!bBatched || HasStoppedSimulation() || !UpdatedPrimitive || IsPendingKill())
+	{
+		bBatched = false;
+		return false;
+	}
+
+	OutStep.Projectile = this;
+	OutStep.DeltaTime = DeltaTime;
+	OutStep.Start = UpdatedComponent->GetComponentLocation();
+	OutStep.Rotation = UpdatedComponent->GetComponentQuat();
+	OutStep.Velocity = Velocity;
+	OutStep.Acceleration = ComputeAcceleration(Velocity, DeltaTime);
+	OutStep.MaxSpeed = GetMaxSpeed();
+	OutStep.Shape = UpdatedPrimitive->GetCollisionShape();
+	OutStep.PawnSweepRadius = SweepRadius;
+	OutStep.Channel = UpdatedPrimitive->GetCollisionObjectType();
+	//the same ignores MoveComponent uses: own actor plus the component's move ignore lists
+	OutStep.QueryParams = FCollisionQueryParams(SCENE_QUERY_STAT(ProjectileBatchMove), false, GetOwner());
+	UpdatedPrimitive->InitSweepCollisionParams(OutStep.QueryParams, OutStep.ResponseParams);
+	OutStep.PawnIgnoredActors = bUsePawnHitGrid ? &IgnoredActors : nullptr;
+	OutStep.Hit = FHitResult(1.0f);
+	return true;
+}
+
+void UProjectileGridMovementComponent::SweepBatchStep(const UWorld* World, const UTopDownShooterPawnHitGrid* PawnHitGrid, FProjectileBatchStep& Step)
+{
+	//same integration as UProjectileMovementComponent::ComputeMoveDelta
+	const float DeltaTime = Step.DeltaTime;
+	Step.NewVelocity = Step.Velocity + Step.Acceleration * DeltaTime;
+	if (Step.MaxSpeed > 0.0f)
+		Step.NewVelocity = Step.NewVelocity.GetClampedToMaxSize(Step.MaxSpeed);
+	Step.Delta = Step.Velocity * DeltaTime + (Step.NewVelocity - Step.Velocity) * (0.5f * DeltaTime);
+	Step.Hit = FHitResult(1.0f);
+	Step.HitHordeEntity = 0;
+	if (Step.Delta.IsNearlyZero())
+		return;
+
+	const FVector End = Step.Start + Step.Delta;
+	FHitResult WorldHit;
+	if (World->SweepSingleByChannel(WorldHit, Step.Start, End, Step.Rotation, Step.Channel, Step.Shape, Step.QueryParams, Step.ResponseParams) && WorldHit.bBlockingHit)
+		Step.Hit = WorldHit;
+
+	FHitResult PawnHit;
+	uint32 PawnHordeEntity = 0;
+	if (PawnHitGrid && Step.PawnIgnoredActors && PawnHitGrid->SweepPawns(Step.Start, End, Step.PawnSweepRadius, *Step.PawnIgnoredActors, PawnHit, PawnHordeEntity))
+	{
+		if (!Step.Hit.bBlockingHit || PawnHit.Time < Step.Hit.Time)
+		{
+			Step.Hit = PawnHit;
+			Step.HitHordeEntity = PawnHordeEntity;
+		}
+	}
+}
+
+void UProjectileGridMovementComponent::ApplyBatchStep(const FProjectileBatchStep& Step)
+{
+	//an earlier hit of the batch may have destroyed or stopped it
+	if (!bBatched || HasStoppedSimulation() || !UpdatedPrimitive || IsPendingKill())
+		return;
+
+	const FHitResult& Hit = Step.Hit;
+	Velocity = Step.NewVelocity;
+	const FVector NewLocation = Hit.bBlockingHit ? Hit.Location : Step.Start + Step.Delta;
+	const FQuat NewRotation = bRotationFollowsVelocity && !Velocity.IsNearlyZero() ? Velocity.ToOrientationQuat() : Step.Rotation;
+	UpdatedComponent->SetWorldLocationAndRotation(NewLocation, NewRotation, false, nullptr, ETeleportType::None);
+
+	if (!Hit.bBlockingHit)
+	{
+		UpdateComponentVelocity();
+		return;
+	}
+
+	//reported like a swept move would, then stopped like the ticked non-bouncing projectile
+	if (AActor* myOwner = GetOwner())
+	{
+		if (Hit.Component.IsValid())
+			UpdatedPrimitive->DispatchBlockingHit(*myOwner, Hit);
+		else
+		{
+			HitHordeEntity = Step.HitHordeEntity;
+			UpdatedPrimitive->OnComponentHit.Broadcast(UpdatedPrimitive, nullptr, nullptr, FVector::ZeroVector, Hit);
+			HitHordeEntity = 0;
+		}
+	}
+	if (!IsPendingKill() && !HasStoppedSimulation())
+		HandleImpact(Hit, Step.DeltaTime * (1.0f - Hit.Time), Step.Delta);
+}
+
+bool UProjectileGridMovementComponent::MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit, ETeleportType Teleport)
+{
+	UTopDownShooterPawnHitGrid* PawnHitGrid = bUsePawnHitGrid && bSweep && UpdatedComponent && !Delta.IsNearlyZero() ? GetWorld()->GetSubsystem<UTopDownShooterPawnHitGrid>() : nullptr;
+	if (!PawnHitGrid)
+		return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+
+	PawnHitGrid->EnsureBuilt();
+	const FVector Start = UpdatedComponent->GetComponentLocation();
+	FHitResult PawnHit;
+	uint32 PawnHordeEntity = 0;
+	const bool bPawnHit = PawnHitGrid->SweepPawns(Start, Start + Delta, SweepRadius, IgnoredActors, PawnHit, PawnHordeEntity);
+	TPS_COUNT_TRACES(PawnGridTraces, 1);
+	if (!bPawnHit)
+		return Super::MoveUpdatedComponentImpl(Delta, NewRotation, bSweep, OutHit, Teleport);
+
+	//world geometry in front of the pawn still wins
+	FHitResult WorldHit(1.0f);
+	const bool bMoved = Super::MoveUpdatedComponentImpl(Delta * PawnHit.Time, NewRotation, true, &WorldHit, Teleport);
+	if (WorldHit.bBlockingHit || IsPendingKill() || !UpdatedPrimitive)
+	{
+		WorldHit.Time *= PawnHit.Time;
+		if (OutHit)
+			*OutHit = WorldHit;
+		return bMoved;
+	}
+
+	//stopped at the pawn like a physics sweep would, report it the same way
+	if (OutHit)
+		*OutHit = PawnHit;
+
+	if (AActor* myOwner = GetOwner())
+	{
+		if (PawnHit.Component.IsValid())
+			UpdatedPrimitive->DispatchBlockingHit(*myOwner, PawnHit);
+		else
+		{
+			HitHordeEntity = PawnHordeEntity;
+			UpdatedPrimitive->OnComponentHit.Broadcast(UpdatedPrimitive, nullptr, nullptr, FVector::ZeroVector, PawnHit);
+			HitHordeEntity = 0;
+		}
+	}
+	return bMoved;
+}
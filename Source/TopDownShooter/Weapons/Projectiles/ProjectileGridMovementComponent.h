@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "ProjectileGridMovementComponent.generated.h"
+
+class UProjectileGridMovementComponent;
+class UTopDownShooterPawnHitGrid;
+
+//One batched move of a projectile: filled on the game thread, swept on a worker, applied on the game thread
+struct FProjectileBatchStep
+{
+	TWeakObjectPtr<UProjectileGridMovementComponent> Projectile;
+	float DeltaTime = 0.0f;
+	FVector Start = FVector::ZeroVector;
+	FQuat Rotation = FQuat::Identity;
+	FVector Velocity = FVector::ZeroVector;
+	FVector Acceleration = FVector::ZeroVector;
+	float MaxSpeed = 0.0f;
+	FCollisionShape Shape;
+	float PawnSweepRadius = 0.0f;
+	ECollisionChannel Channel = ECC_WorldDynamic;
+	FCollisionQueryParams QueryParams;
+	FCollisionResponseParams ResponseParams;
+	//null when pawns come from physics
+	const TArray<AActor*>* PawnIgnoredActors = nullptr;
+
+	//results
+	FVector Delta = FVector::ZeroVector;
+	FVector NewVelocity = FVector::ZeroVector;
+	FHitResult Hit;
+	//horde entity without an actor that Hit is on, 0 otherwise
+	uint32 HitHordeEntity = 0;
+};
+
+/**
+ * Projectile movement that finds pawns through UTopDownShooterPawnHitGrid instead of the physics sweep.
+ * The collision ignores pawns, each move sweeps the grid first and physics only up to the pawn that was found,
+ * a pawn hit is reported through the same hit events and bounce handling as a physics one.
+ * Non-bouncing, non-homing projectiles are moved by UProjectileBatchMover instead of ticking (TPS.ProjectileBatch).
+ */
+UCLASS(ClassGroup = Movement, meta = (BlueprintSpawnableComponent))
+class TOPDOWNSHOOTER_API UProjectileGridMovementComponent : public UProjectileMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitializeComponent() override;
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	//moved by UProjectileBatchMover instead of its own tick
+	bool IsBatched() const { return bBatched; }
+
+	//game thread, false when the projectile has stopped and leaves the batch
+	bool PrepareBatchStep(float DeltaTime, FProjectileBatchStep& OutStep);
+	//any thread, integrates and sweeps without touching the component
+	static void SweepBatchStep(const UWorld* World, const UTopDownShooterPawnHitGrid* PawnHitGrid, FProjectileBatchStep& Step);
+	//game thread, moves the component and reports the hit the way a ticked move would
+	void ApplyBatchStep(const FProjectileBatchStep& Step);
+
+	//horde entity of the hit being reported to OnComponentHit, 0 outside of it or for any other hit
+	uint32 GetHitHordeEntity() const { return HitHordeEntity; }
+
+protected:
+	virtual bool MoveUpdatedComponentImpl(const FVector& Delta, const FQuat& NewRotation, bool bSweep, FHitResult* OutHit = nullptr, ETeleportType Teleport = ETeleportType::None) override;
+
+	bool bUsePawnHitGrid = false;
+	bool bBatched = false;
+	float SweepRadius = 0.0f;
+	TArray<AActor*> IgnoredActors;
+	uint32 HitHordeEntity = 0;
+};
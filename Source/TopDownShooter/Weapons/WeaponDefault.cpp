@@ -6,12 +6,39 @@
 #include "Components/SceneComponent.h"
 #include "Components/ArrowComponent.h"
 #include "FuncLibrary/Types.h"
-//#include "DrawDebugHelpers.h"
+#include "DrawDebugHelpers.h"
 #include "Kismet/KismetMathLibrary.h"
 #include "Kismet/GameplayStatics.h"
 #include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Character/TopDownShooterInventorComponent.h"
+#include "FuncLibrary/CosmeticLibrary.h"
+#include "Game/TopDownShooterLagCompensation.h"
+#include "Game/TopDownShooterPawnHitGrid.h"
+#include "Character/TopDownShooterCharacter.h"
+#include "GameFramework/GameStateBase.h"
+#include "Weapons/DropMeshActor.h"
+#include "Game/TopDownShooterSpawnQueue.h"
+#include "Weapons/WeaponFireAudio.h"
+#include "Components/AudioComponent.h"
+#include "Sound/SoundBase.h"
+#include "Particles/ParticleSystemComponent.h"
+#include "TopDownShooter.h"
+#include "TopDownShooterTrace.h"
+#include "TopDownShooterMemory.h"
+#include "FuncLibrary/WeaponLogic.h"
+#include "Curves/CurveFloat.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("Weapon Fire"), STAT_TPS_WeaponFire, STATGROUP_TopDownShooter);
+DECLARE_CYCLE_STAT(TEXT("Weapon InitDropMesh"), STAT_TPS_InitDropMesh, STATGROUP_TopDownShooter);
+
+float DispersionReferenceFPS = 60.0f;
+FAutoConsoleVariableRef CVARDispersionReferenceFPS(TEXT("TPS.Dispersion.ReferenceFPS"), DispersionReferenceFPS, TEXT("Frame rate the per frame dispersion Reduction values were authored at"), ECVF_Cheat);
+
+int32 MuzzleFlashPersistent = 1;
+FAutoConsoleVariableRef CVARMuzzleFlashPersistent(TEXT("TPS.MuzzleFlash.Persistent"), MuzzleFlashPersistent, TEXT("Restart one muzzle flash component per weapon on each shot, off spawns an emitter per shot"), ECVF_Default);
 
 // Sets default values
 AWeaponDefault::AWeaponDefault()
@@ -25,6 +52,7 @@ AWeaponDefault::AWeaponDefault()
 	SkeletalMeshWeapon = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("Skeletal Mesh"));
 	SkeletalMeshWeapon->SetGenerateOverlapEvents(false);
 	SkeletalMeshWeapon->SetCollisionProfileName(TEXT("NoCollision"));
+	SkeletalMeshWeapon->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
 	SkeletalMeshWeapon->SetupAttachment(RootComponent);
 
 	StaticMeshWeapon = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Static Mesh "));
@@ -34,6 +62,16 @@ AWeaponDefault::AWeaponDefault()
 
 	ShootLocation = CreateDefaultSubobject<UArrowComponent>(TEXT("ShootLocation"));
 	ShootLocation->SetupAttachment(RootComponent);
+
+	FireAudio = CreateDefaultSubobject<UAudioComponent>(TEXT("Fire Audio"));
+	FireAudio->SetupAttachment(ShootLocation);
+	FireAudio->bAutoActivate = false;
+	FireAudio->bAutoDestroy = false;
+
+	MuzzleFlash = CreateDefaultSubobject<UParticleSystemComponent>(TEXT("Muzzle Flash"));
+	MuzzleFlash->SetupAttachment(ShootLocation);
+	MuzzleFlash->bAutoActivate = false;
+	MuzzleFlash->bAutoDestroy = false;
 }
 
 // Called when the game starts or when spawned
@@ -44,6 +82,14 @@ void AWeaponDefault::BeginPlay()
 	WeaponInit();
 }
 
+void AWeaponDefault::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UWeaponFireAudio* myFireAudio = GetWorld()->GetSubsystem<UWeaponFireAudio>())
+		myFireAudio->ReleaseVoice(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AWeaponDefault::Tick(float DeltaTime)
 {
@@ -51,9 +97,11 @@ void AWeaponDefault::Tick(float DeltaTime)
 
 	FireTick(DeltaTime);
 	ReloadTick(DeltaTime);
-	DispersionTick(DeltaTime);
 	ClipDropTick(DeltaTime);
 	ShellDropTick(DeltaTime);
+
+	if (ShowDebug)
+		UE_LOG(LogTemp, Warning, TEXT("Dispersion: MAX = %f. MIN = %f. Current = %f"), CurrentDispersionMax, CurrentDispersionMin, GetCurrentDispersion());
 }
 
 void AWeaponDefault::FireTick(float DeltaTime)
@@ -86,36 +134,6 @@ void AWeaponDefault::ReloadTick(float DeltaTime)
 	}
 }
 
-void AWeaponDefault::DispersionTick(float DeltaTime)
-{
-	if (!WeaponReloading)
-	{
-		if (!WeaponFiring)
-		{
-			if (ShouldReduceDispersion)
-				CurrentDispersion = CurrentDispersion - CurrentDispersionReduction;
-			else
-				CurrentDispersion = CurrentDispersion + CurrentDispersionReduction;
-		}
-
-		if (CurrentDispersion < CurrentDispersionMin)
-		{
-
-			CurrentDispersion = CurrentDispersionMin;
-
-		}
-		else
-		{
-			if (CurrentDispersion > CurrentDispersionMax)
-			{
-				CurrentDispersion = CurrentDispersionMax;
-			}
-		}
-	}
-	if (ShowDebug)
-		UE_LOG(LogTemp, Warning, TEXT("Dispersion: MAX = %f. MIN = %f. Current = %f"), CurrentDispersionMax, CurrentDispersionMin, CurrentDispersion);
-}
-
 void AWeaponDefault::ClipDropTick(float DeltaTime)
 {
 	if (DropClipFlag)
@@ -159,10 +177,15 @@ void AWeaponDefault::WeaponInit()
 	}
 
 	UpdateStateWeapon(EMovementState::Run_State);
+
+	SpreadGenerator::BuildPattern(WeaponSetting.SpreadPattern, SpreadPatternTable);
+
+	WeaponRandomStream.GenerateNewSeed();
 }
 
 void AWeaponDefault::SetWeaponStateFire(bool bIsFire)
 {
+	AnchorDispersion();
 	if (CheckWeaponCanFire())
 		WeaponFiring = bIsFire;
 	else
@@ -182,6 +205,10 @@ FProjectileInfos AWeaponDefault::GetProjectile()
 
 void AWeaponDefault::Fire()
 {
+	SCOPE_CYCLE_COUNTER(STAT_TPS_WeaponFire);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, WeaponFire);
+	FTopDownShooterCounters::ShotsFired++;
+
 	UAnimMontage* AnimToPlay = nullptr;
 	if (WeaponAiming)
 	{
@@ -193,10 +220,7 @@ void AWeaponDefault::Fire()
 	}
 
 
-	if (WeaponSetting.AnimWeaponInfos.AnimWeaponFire && SkeletalMeshWeapon && SkeletalMeshWeapon->GetAnimInstance())
-	{
-		SkeletalMeshWeapon->GetAnimInstance()->Montage_Play(WeaponSetting.AnimWeaponInfos.AnimWeaponFire);
-	}
+	UCosmeticLibrary::PlayMontage(SkeletalMeshWeapon, WeaponSetting.AnimWeaponInfos.AnimWeaponFire);
 
 	if (WeaponSetting.ShellBullets.DropMesh)
 	{
@@ -217,106 +241,323 @@ void AWeaponDefault::Fire()
 		}
 	}
 
-	FireTimer = WeaponSetting.RateOfFire;
+	FireTimer = WeaponSetting.RateOfFire * StatusModifiers.FireInterval;
 
 	WeaponAdditionalInfos.Round = WeaponAdditionalInfos.Round - 1;
 	ChangeDispersionByShot();
 
-	UGameplayStatics::SpawnSoundAtLocation(GetWorld(), WeaponSetting.SoundFireWeapon, ShootLocation->GetComponentLocation());
-	UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), WeaponSetting.EffectFireWeapon, ShootLocation->GetComponentTransform());
+	if (ShootLocation)
+	{
+		FWeaponFireEvent FireEvent;
+		BuildFireEvent(FireEvent);
 
-	int8 NumberProjectile = GetNumberProjectileByShot();
+		PlayFireCosmetics(FireEvent);
+		//net client only predicts visuals, the server resolves damage from the replicated event
+		ResolveFireEvent(FireEvent, GetNetMode() != NM_Client, false);
+		ReplicateFireEvent(FireEvent);
+	}
 
+	if (GetWeaponRound() <= 0 && !WeaponReloading)
+	{
+		//Init Reload
+		if (CheckCanWeaponReload())
+			InitReload();
+	}
+}
 
-	if (ShootLocation)
+void AWeaponDefault::BuildFireEvent(FWeaponFireEvent& OutFireEvent)
+{
+	OutFireEvent.WeaponSlot = (uint8)WeaponSlotIndex;
+	OutFireEvent.ShotIndex = ShotCounter++;
+	OutFireEvent.Seed = WeaponRandomStream.RandHelper(MAX_int32);
+
+	const AGameStateBase* myGameState = GetWorld()->GetGameState();
+	OutFireEvent.Timestamp = myGameState ? myGameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds();
+
+	OutFireEvent.MuzzleLocation = ShootLocation->GetComponentLocation();
+	OutFireEvent.MuzzleRotation = ShootLocation->GetComponentRotation();
+	OutFireEvent.AimPoint = ShootEndLocation;
+	OutFireEvent.Dispersion = GetCurrentDispersion();
+	OutFireEvent.Quantize();
+}
+
+void AWeaponDefault::PlayFireCosmetics(const FWeaponFireEvent& FireEvent)
+{
+	PlayFireSound(FireEvent);
+	PlayMuzzleFlash(FireEvent);
+}
+
+void AWeaponDefault::PlayMuzzleFlash(const FWeaponFireEvent& FireEvent)
+{
+	if (!MuzzleFlashPersistent || !MuzzleFlash)
 	{
-		FVector SpawnLocation = ShootLocation->GetComponentLocation();
-		FRotator SpawnRotation = ShootLocation->GetComponentRotation();
-		FProjectileInfos ProjectileInfo;
-		ProjectileInfo = GetProjectile();
+		UCosmeticLibrary::SpawnEmitterAtLocation(this, WeaponSetting.EffectFireWeapon, FTransform(FireEvent.MuzzleRotation, FireEvent.MuzzleLocation));
+		return;
+	}
 
-		FVector EndLocation;
-		for (int8 i = 0; i < NumberProjectile; i++)//Shotgun
-		{
-			EndLocation = GetFireEndLocation();
+	if (!WeaponSetting.EffectFireWeapon || !UCosmeticLibrary::ShouldPlayCosmetics(this) || MuzzleFlashFrame == GFrameCounter)
+		return;
+	MuzzleFlashFrame = GFrameCounter;
+
+	//template comes with WeaponSetting after spawn, it is set on the first shot
+	if (MuzzleFlash->Template != WeaponSetting.EffectFireWeapon)
+		MuzzleFlash->SetTemplate(WeaponSetting.EffectFireWeapon);
+	MuzzleFlash->ActivateSystem(true);
+}
+
+void AWeaponDefault::PlayFireSound(const FWeaponFireEvent& FireEvent)
+{
+	UWeaponFireAudio* myFireAudio = UWeaponFireAudio::IsEnabled() ? GetWorld()->GetSubsystem<UWeaponFireAudio>() : nullptr;
+	if (!myFireAudio || !FireAudio)
+	{
+		UCosmeticLibrary::SpawnSoundAtLocation(this, WeaponSetting.SoundFireWeapon, FireEvent.MuzzleLocation);
+		return;
+	}
+
+	USoundBase* myLoop = WeaponSetting.SoundFireWeaponLoop;
+	USoundBase* mySound = myLoop ? myLoop : WeaponSetting.SoundFireWeapon;
+	if (!mySound || !UCosmeticLibrary::ShouldPlayCosmetics(this))
+		return;
+
+	if (!myFireAudio->AcquireVoice(this, FireEvent.MuzzleLocation, mySound->GetMaxDistance(), WeaponSetting.RateOfFire * StatusModifiers.FireInterval))
+		return;
 
-			FVector Dir = EndLocation - SpawnLocation;
+	if (FireAudio->Sound != mySound)
+		FireAudio->SetSound(mySound);
+	//the loop keeps running through the burst, a one-shot restarts on the same voice
+	if (!myLoop || !FireAudio->IsPlaying())
+		FireAudio->Play(0.0f);
+}
+
+void AWeaponDefault::StopFireSound(bool bCut)
+{
+	if (FireAudio && FireAudio->IsPlaying() && (bCut || FireAudio->Sound == WeaponSetting.SoundFireWeaponLoop))
+		FireAudio->Stop();
+}
+
+void AWeaponDefault::ResolveFireEvent(const FWeaponFireEvent& FireEvent, bool bApplyDamage, bool bRewindTargets)
+{
+	int8 NumberProjectile = GetNumberProjectileByShot();
+
+	const FVector SpawnLocation = FireEvent.MuzzleLocation;
+	FProjectileInfos ProjectileInfo;
+	ProjectileInfo = GetProjectile();
+	if (!bApplyDamage)
+	{
+		ProjectileInfo.ProjectileDamage = 0.0f;
+		ProjectileInfo.ExploseMaxDamage = 0.0f;
+	}
 
-			Dir.Normalize();
+#if TOPDOWNSHOOTER_TRACE_ENABLED
+	uint32 ShotTraceId = 0;
+#endif
+	TPS_TRACE(ShotFired(ShotTraceId, this, NumberProjectile, FireEvent.Seed));
 
-			FMatrix myMatrix(Dir, FVector(0, 1, 0), FVector(0, 0, 1), FVector::ZeroVector);
-			SpawnRotation = myMatrix.Rotator();
+	UTopDownShooterPawnHitGrid* PawnHitGrid = UTopDownShooterPawnHitGrid::IsEnabled() ? GetWorld()->GetSubsystem<UTopDownShooterPawnHitGrid>() : nullptr;
+	if (PawnHitGrid && !ProjectileInfo.Projectile)
+		PawnHitGrid->EnsureBuilt();
 
-			if (ProjectileInfo.Projectile)
+	//same seed -> same pellets on every machine
+	FRandomStream ShotStream(FireEvent.Seed);
+	BuildShotSpread(FireEvent, ShotStream);
+
+	for (int8 i = 0; i < NumberProjectile; i++)//Shotgun
+	{
+		const FVector Dir = ShotSpread.GetDirection(i);
+		const FRotator SpawnRotation = ShotSpread.GetRotation(i);
+
+		if (ProjectileInfo.Projectile)
+		{
+			//Projectile Init ballistic fire
+			TPS_LLM_SCOPE(Projectiles);
+
+			//deferred, so the projectile builds only the components its infos need before it starts moving
+			const FTransform SpawnTransform(SpawnRotation, SpawnLocation);
+			AProjectileDefault* myProjectile = GetWorld()->SpawnActorDeferred<AProjectileDefault>(ProjectileInfo.Projectile, SpawnTransform, GetOwner(), GetInstigator(), ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+			TPS_COUNT_SPAWNS(ProjectileSpawns, 1);
+			if (myProjectile)
+			{
+				myProjectile->InitProjectile(ProjectileInfo);
+				myProjectile->FinishSpawning(SpawnTransform);
+				TPS_TRACE(ProjectileSpawned(myProjectile, ShotTraceId, false));
+			}
+		}
+		else
+		{
+			FHitResult Hit;
+			TArray<AActor*> Actors;
+			FVector TraceEnd = SpawnLocation + Dir * WeaponSetting.DistacneTrace;
+
+			//remote shooter on server: characters are tested where the shooter saw them, physics only gives world geometry
+			UTopDownShooterLagCompensation* LagCompensation = GetWorld()->GetSubsystem<UTopDownShooterLagCompensation>();
+			bool bRewind = bRewindTargets && LagCompensation && LagCompensation->ShouldRewindFor(GetInstigatorController());
+			if (bRewind)
+				LagCompensation->GetTrackedActors(Actors);
+
+			//pawns from the capsule grid first, then physics for world geometry up to the pawn
+			FHitResult PawnHit;
+			bool bPawnHit = false;
+			uint32 PawnHordeEntity = 0;
+			uint32 HitHordeEntity = 0;
+			FVector WorldTraceEnd = TraceEnd;
+			if (PawnHitGrid)
 			{
-				//Projectile Init ballistic fire
+				TArray<AActor*> PawnIgnoredActors = Actors;
+				PawnIgnoredActors.Add(GetInstigator());
+				bPawnHit = PawnHitGrid->SweepPawns(SpawnLocation, TraceEnd, 0.0f, PawnIgnoredActors, PawnHit, PawnHordeEntity);
+				TPS_COUNT_TRACES(PawnGridTraces, 1);
+				if (bPawnHit)
+					WorldTraceEnd = PawnHit.ImpactPoint;
+			}
 
-				FActorSpawnParameters SpawnParams;
-				SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-				SpawnParams.Owner = GetOwner();
-				SpawnParams.Instigator = GetInstigator();
+			FCollisionQueryParams TraceParams(SCENE_QUERY_STAT(WeaponTrace), false, this);
+			TraceParams.bReturnPhysicalMaterial = true;
+			TraceParams.AddIgnoredActors(Actors);
+			FCollisionResponseParams TraceResponse;
+			if (PawnHitGrid)
+				TraceResponse.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+			GetWorld()->LineTraceSingleByChannel(Hit, SpawnLocation, WorldTraceEnd, UEngineTypes::ConvertToCollisionChannel(ETraceTypeQuery::TraceTypeQuery4), TraceParams, TraceResponse);
+			TPS_COUNT_TRACES(WeaponTraces, 1);
+			if (!Hit.bBlockingHit && bPawnHit)
+			{
+				Hit = PawnHit;
+				HitHordeEntity = PawnHordeEntity;
+			}
 
-				AProjectileDefault* myProjectile = Cast<AProjectileDefault>(GetWorld()->SpawnActor(ProjectileInfo.Projectile, &SpawnLocation, &SpawnRotation, SpawnParams));
-				if (myProjectile)
+#if ENABLE_DRAW_DEBUG
+			if (ShowDebug)
+			{
+				DrawDebugLine(GetWorld(), SpawnLocation, Hit.bBlockingHit ? Hit.ImpactPoint : TraceEnd, FColor::Red, false, 5.0f);
+				if (Hit.bBlockingHit)
 				{
-					myProjectile->InitProjectile(WeaponSetting.ProjectileSetting);
+					DrawDebugLine(GetWorld(), Hit.ImpactPoint, TraceEnd, FColor::Green, false, 5.0f);
+					DrawDebugPoint(GetWorld(), Hit.ImpactPoint, 16.0f, FColor::Red, false, 5.0f);
 				}
 			}
-			else
+#endif
+
+			if (bRewind)
 			{
-				FHitResult Hit;
-				TArray<AActor*> Actors;
-				UKismetSystemLibrary::LineTraceSingle(GetWorld(), SpawnLocation, EndLocation * WeaponSetting.DistacneTrace, ETraceTypeQuery::TraceTypeQuery4, false, Actors, EDrawDebugTrace::ForDuration, Hit, true, FLinearColor::Red, FLinearColor::Green, 5.0f);
+				FHitResult RewindHit;
+				if (LagCompensation->RewindLineTrace(LagCompensation->ClampShooterViewTime(FireEvent.Timestamp), SpawnLocation, Hit.bBlockingHit ? Hit.Location : TraceEnd, GetInstigator(), RewindHit))
+				{
+					Hit = RewindHit;
+					HitHordeEntity = 0;
+				}
+			}
 
-				//GetWorld()->LineTraceSingleByChannel(Hit, SpawnLocation, SpawnLocation + ShootLocation->GetForwardVector()*WeaponSetting.DistacneTrace, ECollisionChannel::ECC_GameTraceChannel2);
+			//GetWorld()->LineTraceSingleByChannel(Hit, SpawnLocation, SpawnLocation + ShootLocation->GetForwardVector()*WeaponSetting.DistacneTrace, ECollisionChannel::ECC_GameTraceChannel2);
 
-				//if (ShowDebug)
-					//DrawDebugLine(GetWorld(), SpawnLocation, SpawnLocation + ShootLocation->GetForwardVector()*WeaponSetting.DistacneTrace, FColor::Black, false, 5.f, (uint8)'\000', 0.5f);
+			//if (ShowDebug)
+				//DrawDebugLine(GetWorld(), SpawnLocation, SpawnLocation + ShootLocation->GetForwardVector()*WeaponSetting.DistacneTrace, FColor::Black, false, 5.f, (uint8)'\000', 0.5f);
 
-				if (Hit.GetActor() && Hit.PhysMaterial.IsValid())
+			if (Hit.GetActor() && Hit.PhysMaterial.IsValid())
+			{
+				EPhysicalSurface mySurfacetype = UGameplayStatics::GetSurfaceType(Hit);
+
+				if (WeaponSetting.ProjectileSetting.HitDecals.Contains(mySurfacetype))
 				{
-					EPhysicalSurface mySurfacetype = UGameplayStatics::GetSurfaceType(Hit);
+					UMaterialInterface* myMaterial = WeaponSetting.ProjectileSetting.HitDecals[mySurfacetype];
 
-					if (WeaponSetting.ProjectileSetting.HitDecals.Contains(mySurfacetype))
+					if (myMaterial && Hit.GetComponent())
 					{
-						UMaterialInterface* myMaterial = WeaponSetting.ProjectileSetting.HitDecals[mySurfacetype];
-
-						if (myMaterial && Hit.GetComponent())
-						{
-							UGameplayStatics::SpawnDecalAttached(myMaterial, FVector(20.0f), Hit.GetComponent(), NAME_None, Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), EAttachLocation::KeepWorldPosition, 10.0f);
-						}
+						UCosmeticLibrary::QueueDecalAttached(myMaterial, FVector(20.0f), Hit.GetComponent(), Hit.ImpactPoint, Hit.ImpactNormal.Rotation(), 10.0f);
 					}
-					if (WeaponSetting.ProjectileSetting.HitFXs.Contains(mySurfacetype))
+				}
+				if (WeaponSetting.ProjectileSetting.HitFXs.Contains(mySurfacetype))
+				{
+					UParticleSystem* myParticle = WeaponSetting.ProjectileSetting.HitFXs[mySurfacetype];
+					if (myParticle)
 					{
-						UParticleSystem* myParticle = WeaponSetting.ProjectileSetting.HitFXs[mySurfacetype];
-						if (myParticle)
-						{
-							UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), myParticle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
-						}
+						UCosmeticLibrary::QueueEmitterAtLocation(this, myParticle, FTransform(Hit.ImpactNormal.Rotation(), Hit.ImpactPoint, FVector(1.0f)));
 					}
+				}
 
-					if (WeaponSetting.ProjectileSetting.HitSound)
-					{
-						UGameplayStatics::PlaySoundAtLocation(GetWorld(), WeaponSetting.ProjectileSetting.HitSound, Hit.ImpactPoint);
-					}
+				if (WeaponSetting.ProjectileSetting.HitSound)
+				{
+					UCosmeticLibrary::PlaySoundAtLocation(this, WeaponSetting.ProjectileSetting.HitSound, Hit.ImpactPoint);
+				}
 
+				TPS_TRACE(Hit(ShotTraceId, nullptr, uint8(mySurfacetype), bApplyDamage ? WeaponSetting.ProjectileSetting.ProjectileDamage : 0.0f));
+				if (bApplyDamage)
 					UGameplayStatics::ApplyDamage(Hit.GetActor(), WeaponSetting.ProjectileSetting.ProjectileDamage, GetInstigatorController(), this, NULL);
-				}
 			}
-		}			
+			else if (HitHordeEntity != 0)
+			{
+				//horde enemy without an actor, out of sight so no impact effects
+				TPS_TRACE(Hit(ShotTraceId, nullptr, 0, bApplyDamage ? WeaponSetting.ProjectileSetting.ProjectileDamage : 0.0f));
+				if (bApplyDamage)
+					UTopDownShooterPawnHitGrid::ApplyHitDamage(GetWorld(), Hit, HitHordeEntity, WeaponSetting.ProjectileSetting.ProjectileDamage, GetInstigatorController(), this);
+			}
+		}
+	}
+}
+
+void AWeaponDefault::ReplicateFireEvent(const FWeaponFireEvent& FireEvent)
+{
+	const ENetMode NetMode = GetNetMode();
+	if (NetMode == NM_Standalone)
+		return;
+
+	ATopDownShooterCharacter* myChar = Cast<ATopDownShooterCharacter>(GetInstigator());
+	if (myChar)
+	{
+		if (NetMode == NM_Client)
+			myChar->ServerWeaponFire(FireEvent);
+		else
+			myChar->MulticastWeaponFire(FireEvent);
 	}
+}
+
+bool AWeaponDefault::FireFromRemoteEvent(const FWeaponFireEvent& FireEvent, FWeaponFireEvent& OutAcceptedEvent)
+{
+	//server side checks, the client can only pick the seed, dispersion is tracked here
+	const float Now = GetWorld()->GetTimeSeconds();
+	const float FireInterval = WeaponSetting.RateOfFire * StatusModifiers.FireInterval;
+	if (GetWeaponRound() <= 0 || WeaponReloading || BlockFire)
+		return false;
+	//unreliable events may be lost but never replayed or reordered, wraps around with the uint16
+	if (LastRemoteShotIndex != INDEX_NONE && int16(FireEvent.ShotIndex - uint16(LastRemoteShotIndex)) <= 0)
+		return false;
+	if (LastRemoteFireTime >= 0.0f && Now - LastRemoteFireTime < FireInterval * 0.5f)
+		return false;
+	if (!ShootLocation || FVector::DistSquared(FireEvent.MuzzleLocation, ShootLocation->GetComponentLocation()) > FMath::Square(200.0f))
+		return false;
+
+	//the trigger is not seen here, shots within two intervals are one burst and dispersion does not recover in between
+	if (LastRemoteFireTime >= 0.0f && Now - LastRemoteFireTime <= FireInterval * 2.0f)
+		DispersionAnchorTime = Now;
+	LastRemoteFireTime = Now;
+	LastRemoteShotIndex = FireEvent.ShotIndex;
+
+	FWeaponFireEvent ServerFireEvent = FireEvent;
+	ServerFireEvent.Dispersion = GetCurrentDispersion();
+	ServerFireEvent.Quantize();
+
+	WeaponAdditionalInfos.Round = WeaponAdditionalInfos.Round - 1;
+	ChangeDispersionByShot();
+
+	PlayFireCosmetics(ServerFireEvent);
+	ResolveFireEvent(ServerFireEvent, true, true);
+	OutAcceptedEvent = ServerFireEvent;
 
 	if (GetWeaponRound() <= 0 && !WeaponReloading)
 	{
-		//Init Reload
 		if (CheckCanWeaponReload())
 			InitReload();
 	}
+	return true;
+}
+
+void AWeaponDefault::SimulateFireEvent(const FWeaponFireEvent& FireEvent)
+{
+	PlayFireCosmetics(FireEvent);
+	ResolveFireEvent(FireEvent, false, false);
 }
 
 void AWeaponDefault::UpdateStateWeapon(EMovementState NewMovementState)
 {
-	//ToDo Dispersion
+	AnchorDispersion();
 	BlockFire = false;
 
 	switch (NewMovementState)
@@ -357,61 +598,56 @@ void AWeaponDefault::UpdateStateWeapon(EMovementState NewMovementState)
 	default:
 		break;
 	}
+
+	CurrentDispersionMax *= StatusModifiers.Dispersion;
+	CurrentDispersionMin *= StatusModifiers.Dispersion;
 }
 
 void AWeaponDefault::ChangeDispersionByShot()
 {
-	CurrentDispersion = CurrentDispersion + CurrentDispersionRecoil;
+	AnchorDispersion();
+	DispersionAnchor += CurrentDispersionRecoil;
 }
 
-
 float AWeaponDefault::GetCurrentDispersion() const
 {
-	float Result = CurrentDispersion;
-	return Result;
+	const UWorld* World = GetWorld();
+	const float Elapsed = World ? FMath::Max(World->GetTimeSeconds() - DispersionAnchorTime, 0.0f) : 0.0f;
+
+	if (const UCurveFloat* RecoveryCurve = WeaponSetting.DispersionWeapon.DispersionRecoveryCurve)
+		return WeaponLogic::EvaluateDispersionCurve(DispersionAnchor, RecoveryCurve->GetFloatValue(Elapsed), CurrentDispersionMin, CurrentDispersionMax, WeaponReloading, WeaponFiring, ShouldReduceDispersion);
+
+	return WeaponLogic::EvaluateDispersion(DispersionAnchor, Elapsed, CurrentDispersionMin, CurrentDispersionMax, CurrentDispersionReduction * DispersionReferenceFPS, WeaponReloading, WeaponFiring, ShouldReduceDispersion);
 }
 
-FVector AWeaponDefault::ApplyDispersionToShoot(FVector DirectionShoot) const
+void AWeaponDefault::SetShouldReduceDispersion(bool bShouldReduce)
 {
-	return FMath::VRandCone(DirectionShoot, GetCurrentDispersion() * PI / 180.f);
+	if (ShouldReduceDispersion != bShouldReduce)
+	{
+		AnchorDispersion();
+		ShouldReduceDispersion = bShouldReduce;
+	}
 }
 
-FVector AWeaponDefault::GetFireEndLocation() const
+void AWeaponDefault::AnchorDispersion()
 {
-	bool bShootDirection = false;
-	FVector EndLocation = FVector(0.f);
+	DispersionAnchor = GetCurrentDispersion();
+	DispersionAnchorTime = GetWorld() ? GetWorld()->GetTimeSeconds() : 0.0f;
+}
 
-	FVector tmpV = (ShootLocation->GetComponentLocation() - ShootEndLocation);
-	//UE_LOG(LogTemp, Warning, TEXT("Vector: X = %f. Y = %f. Size = %f"), tmpV.X, tmpV.Y, tmpV.Size());
+FVector AWeaponDefault::ApplyDispersionToShoot(FVector DirectionShoot, float Dispersion, FRandomStream& Stream) const
+{
+	return WeaponLogic::ApplyDispersionToShoot(DirectionShoot, Dispersion, Stream);
+}
 
-	if (tmpV.Size() > SizeVectorToChangeShootDirectionLogic)
-	{
-		EndLocation = ShootLocation->GetComponentLocation() + ApplyDispersionToShoot((ShootLocation->GetComponentLocation() - ShootEndLocation).GetSafeNormal()) * -20000.0f;
-		/*if (ShowDebug)
-			DrawDebugCone(GetWorld(), ShootLocation->GetComponentLocation(), -(ShootLocation->GetComponentLocation() - ShootEndLocation), WeaponSetting.DistacneTrace, GetCurrentDispersion()* PI / 180.f, GetCurrentDispersion()* PI / 180.f, 32, FColor::Emerald, false, .1f, (uint8)'\000', 1.0f);
-	*/}
+void AWeaponDefault::BuildShotSpread(const FWeaponFireEvent& FireEvent, FRandomStream& Stream)
+{
+	//aim point far enough: spread around the line aim point -> muzzle, pointing away from it; else along the muzzle
+	const FVector tmpV = FVector(FireEvent.MuzzleLocation) - FVector(FireEvent.AimPoint);
+	if (tmpV.SizeSquared() > FMath::Square(SizeVectorToChangeShootDirectionLogic))
+		SpreadGenerator::Generate(tmpV.GetSafeNormal(), -1.0f, FireEvent.Dispersion, GetNumberProjectileByShot(), Stream, &SpreadPatternTable, ShotSpread);
 	else
-	{
-		EndLocation = ShootLocation->GetComponentLocation() + ApplyDispersionToShoot(ShootLocation->GetForwardVector()) * 20000.0f;
-		/*if (ShowDebug)
-			DrawDebugCone(GetWorld(), ShootLocation->GetComponentLocation(), ShootLocation->GetForwardVector(), WeaponSetting.DistacneTrace, GetCurrentDispersion()* PI / 180.f, GetCurrentDispersion()* PI / 180.f, 32, FColor::Emerald, false, .1f, (uint8)'\000', 1.0f);
-	*/}
-
-
-	//if (ShowDebug)
-	//{
-	//	//direction weapon look
-	//	DrawDebugLine(GetWorld(), ShootLocation->GetComponentLocation(), ShootLocation->GetComponentLocation() + ShootLocation->GetForwardVector() * 500.0f, FColor::Cyan, false, 5.f, (uint8)'\000', 0.5f);
-	//	//direction projectile must fly
-	//	DrawDebugLine(GetWorld(), ShootLocation->GetComponentLocation(), ShootEndLocation, FColor::Red, false, 5.f, (uint8)'\000', 0.5f);
-	//	//Direction Projectile Current fly
-	//	DrawDebugLine(GetWorld(), ShootLocation->GetComponentLocation(), EndLocation, FColor::Black, false, 5.f, (uint8)'\000', 0.5f);
-
-	//	//DrawDebugSphere(GetWorld(), ShootLocation->GetComponentLocation() + ShootLocation->GetForwardVector()*SizeVectorToChangeShootDirectionLogic, 10.f, 8, FColor::Red, false, 4.0f);
-	//}
-
-
-	return EndLocation;
+		SpreadGenerator::Generate(FireEvent.MuzzleRotation.Vector(), 1.0f, FireEvent.Dispersion, GetNumberProjectileByShot(), Stream, &SpreadPatternTable, ShotSpread);
 }
 
 int8 AWeaponDefault::GetNumberProjectileByShot() const
@@ -426,7 +662,9 @@ int32 AWeaponDefault::GetWeaponRound()
 
 void AWeaponDefault::InitReload()
 {
+	AnchorDispersion();
 	WeaponReloading = true;
+	TPS_TRACE(Reload(this, ETopDownShooterReloadTrace::Started));
 
 	ReloadTimer = WeaponSetting.ReloadTime;
 
@@ -453,9 +691,9 @@ void AWeaponDefault::InitReload()
 		AnimWeaponToPlay = WeaponSetting.AnimWeaponInfos.AnimWeaponReload;
 	}
 
-	if (WeaponSetting.AnimWeaponInfos.AnimWeaponReload && SkeletalMeshWeapon && SkeletalMeshWeapon->GetAnimInstance())
+	if (WeaponSetting.AnimWeaponInfos.AnimWeaponReload)
 	{
-		SkeletalMeshWeapon->GetAnimInstance()->Montage_Play(AnimWeaponToPlay);
+		UCosmeticLibrary::PlayMontage(SkeletalMeshWeapon, AnimWeaponToPlay);
 	}
 
 	if (WeaponSetting.ClipDropMesh.DropMesh)
@@ -467,32 +705,23 @@ void AWeaponDefault::InitReload()
 
 void AWeaponDefault::FinishReload()
 {
+	AnchorDispersion();
 	WeaponReloading = false;
+	TPS_TRACE(Reload(this, ETopDownShooterReloadTrace::Finished));
 
 	int8 AviableAmmoFromInventory = GetAviableAmmoForReload();
-	int8 AmmoNeedTakeFromInv;
-	int8 NeedToReload = WeaponSetting.MaxRound - WeaponAdditionalInfos.Round;
-
-	if (NeedToReload > AviableAmmoFromInventory)
-	{
-		WeaponAdditionalInfos.Round = AviableAmmoFromInventory;
-		AmmoNeedTakeFromInv = AviableAmmoFromInventory;
-	}
-	else
-	{
-		WeaponAdditionalInfos.Round += NeedToReload;
-		AmmoNeedTakeFromInv = NeedToReload;
-	}
+	int32 AmmoNeedTakeFromInv = 0;
+	WeaponLogic::ComputeReload(WeaponSetting.MaxRound, WeaponAdditionalInfos.Round, AviableAmmoFromInventory, WeaponAdditionalInfos.Round, AmmoNeedTakeFromInv);
 
 	OnWeaponReloadEnd.Broadcast(true, -AmmoNeedTakeFromInv);
 }
 
 void AWeaponDefault::CancelReload()
 {
-
+	AnchorDispersion();
 	WeaponReloading = false;
-	if (SkeletalMeshWeapon && SkeletalMeshWeapon->GetAnimInstance())
-		SkeletalMeshWeapon->GetAnimInstance()->StopAllMontages(0.15f);
+	TPS_TRACE(Reload(this, ETopDownShooterReloadTrace::Cancelled));
+	UCosmeticLibrary::StopAllMontages(SkeletalMeshWeapon, 0.15f);
 
 	OnWeaponReloadEnd.Broadcast(false, 0);
 	DropClipFlag = false;
@@ -549,7 +778,8 @@ void AWeaponDefault::InitDropMesh(UStaticMesh * DropMesh, FTransform Offset, FVe
 	//	}
 	//}
 
-	if (DropMesh)
+	//shells and clips are pure debris, servers never spawn them
+	if (DropMesh && UCosmeticLibrary::ShouldPlayCosmetics(this))
 	{
 		FTransform Transform;
 
@@ -559,54 +789,71 @@ void AWeaponDefault::InitDropMesh(UStaticMesh * DropMesh, FTransform Offset, FVe
 		Transform.SetScale3D(Offset.GetScale3D());
 
 		Transform.SetRotation((GetActorRotation() + Offset.Rotator()).Quaternion());
-		AStaticMeshActor* NewActor = nullptr;
 
+		//placed now, spawned when the spawn queue gets to it
+		TWeakObjectPtr<AWeaponDefault> WeakThis(this);
+		UTopDownShooterSpawnQueue::Queue(this, ESpawnPriority::Cosmetic, INDEX_NONE, [WeakThis, DropMesh, Transform, LocalDir, DropImpulseDirection, LifeTimeMesh, ImpulseRandomDispersion, PowerImpulse, CustomMass]()
+		{
+			if (WeakThis.IsValid())
+				WeakThis->SpawnDropMesh(DropMesh, Transform, LocalDir, DropImpulseDirection, LifeTimeMesh, ImpulseRandomDispersion, PowerImpulse, CustomMass);
+		});
+	}
+}
+
+void AWeaponDefault::SpawnDropMesh(UStaticMesh* DropMesh, FTransform Transform, FVector LocalDir, FVector DropImpulseDirection, float LifeTimeMesh, float ImpulseRandomDispersion, float PowerImpulse, float CustomMass)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TPS_InitDropMesh);
+	CSV_SCOPED_TIMING_STAT(TopDownShooter, InitDropMesh);
+	TPS_LLM_SCOPE(Debris);
 
-		FActorSpawnParameters Param;
-		Param.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		NewActor = GetWorld()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass(), Transform, Param);
+	AStaticMeshActor* NewActor = nullptr;
 
-		if (NewActor && NewActor->GetStaticMeshComponent())
-		{
-			NewActor->GetStaticMeshComponent()->SetCollisionProfileName(TEXT("IgnoreOnlyPawn"));
-			NewActor->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::PhysicsOnly);
-			//NewActor->SetActorEnableCollision(true);
 
-			//set parameter for new actor
-			NewActor->SetActorTickEnabled(false);
-			NewActor->InitialLifeSpan = LifeTimeMesh;
+	FActorSpawnParameters Param;
+	Param.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	NewActor = GetWorld()->SpawnActor<ADropMeshActor>(ADropMeshActor::StaticClass(), Transform, Param);
+	TPS_COUNT_SPAWNS(DebrisSpawns, 1);
 
-			NewActor->GetStaticMeshComponent()->Mobility = EComponentMobility::Movable;
-			NewActor->GetStaticMeshComponent()->SetSimulatePhysics(true);
-			NewActor->GetStaticMeshComponent()->SetStaticMesh(DropMesh);
-			//NewActor->GetStaticMeshComponent()->SetCollisionProfileName(TEXT("BlockAll"));
+	if (NewActor && NewActor->GetStaticMeshComponent())
+	{
+		NewActor->GetStaticMeshComponent()->SetCollisionProfileName(TEXT("IgnoreOnlyPawn"));
+		NewActor->GetStaticMeshComponent()->SetCollisionEnabled(ECollisionEnabled::PhysicsOnly);
+		//NewActor->SetActorEnableCollision(true);
 
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECollisionResponse::ECR_Ignore);
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel2, ECollisionResponse::ECR_Ignore);
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECollisionResponse::ECR_Ignore);
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECollisionResponse::ECR_Block);
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel2, ECollisionResponse::ECR_Block);
-			NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECollisionResponse::ECR_Block);
+		//set parameter for new actor
+		NewActor->SetActorTickEnabled(false);
+		NewActor->InitialLifeSpan = LifeTimeMesh;
 
+		NewActor->GetStaticMeshComponent()->Mobility = EComponentMobility::Movable;
+		NewActor->GetStaticMeshComponent()->SetSimulatePhysics(true);
+		NewActor->GetStaticMeshComponent()->SetStaticMesh(DropMesh);
+		//NewActor->GetStaticMeshComponent()->SetCollisionProfileName(TEXT("BlockAll"));
 
-			//NewActor->SetActorEnableCollision(true);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECollisionResponse::ECR_Ignore);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel2, ECollisionResponse::ECR_Ignore);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECollisionResponse::ECR_Ignore);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel1, ECollisionResponse::ECR_Block);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_GameTraceChannel2, ECollisionResponse::ECR_Block);
+		NewActor->GetStaticMeshComponent()->SetCollisionResponseToChannel(ECC_Pawn, ECollisionResponse::ECR_Block);
 
-			if (CustomMass > 0.0f)
-			{
-				NewActor->GetStaticMeshComponent()->SetMassOverrideInKg(NAME_None, CustomMass, true);
-			}
 
-			if (!DropImpulseDirection.IsNearlyZero())
-			{
-				FVector FinalDir;
-				LocalDir = LocalDir + (DropImpulseDirection * 1000.0f);
+		//NewActor->SetActorEnableCollision(true);
+
+		if (CustomMass > 0.0f)
+		{
+			NewActor->GetStaticMeshComponent()->SetMassOverrideInKg(NAME_None, CustomMass, true);
+		}
 
-				if (!FMath::IsNearlyZero(ImpulseRandomDispersion))
-					FinalDir += UKismetMathLibrary::RandomUnitVectorInConeInDegrees(LocalDir, ImpulseRandomDispersion);
-				FinalDir.GetSafeNormal(0.0001f);
+		if (!DropImpulseDirection.IsNearlyZero())
+		{
+			FVector FinalDir;
+			LocalDir = LocalDir + (DropImpulseDirection * 1000.0f);
 
-				NewActor->GetStaticMeshComponent()->AddImpulse(FinalDir* PowerImpulse);
-			}
+			if (!FMath::IsNearlyZero(ImpulseRandomDispersion))
+				FinalDir += UKismetMathLibrary::RandomUnitVectorInConeInDegrees(LocalDir, ImpulseRandomDispersion);
+			FinalDir.GetSafeNormal(0.0001f);
+
+			NewActor->GetStaticMeshComponent()->AddImpulse(FinalDir* PowerImpulse);
 		}
 	}
 }
@@ -7,6 +7,7 @@
 #include "Components/ArrowComponent.h"
 
 #include "FuncLibrary/Types.h"
+#include "FuncLibrary/SpreadGenerator.h"
 #include "Weapons/Projectiles/ProjectileDefault.h"
 #include "WeaponDefault.generated.h"
 
@@ -38,6 +39,12 @@ public:
 	class UStaticMeshComponent* StaticMeshWeapon = nullptr;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = Components)
 	class UArrowComponent* ShootLocation = nullptr;
+	//fire sound of this weapon, one voice retriggered per shot or looping through a burst
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = Components)
+	class UAudioComponent* FireAudio = nullptr;
+	//EffectFireWeapon, restarted per shot instead of spawning an emitter each time
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"), Category = Components)
+	class UParticleSystemComponent* MuzzleFlash = nullptr;
 
 	UPROPERTY()
 	FWeaponInfos WeaponSetting;
@@ -49,6 +56,7 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:	
 	// Tick func
@@ -56,7 +64,6 @@ public:
 
 	void FireTick(float DeltaTime);
 	void ReloadTick(float DeltaTime);
-	void DispersionTick(float DeltaTime);
 	void ClipDropTick(float DeltaTime);
 	void ShellDropTick(float DeltaTime);
 
@@ -76,12 +83,31 @@ public:
 
 	void Fire();
 
+	//Shots travel as compact fire events, pellets are regenerated from the seed on every machine
+	void BuildFireEvent(FWeaponFireEvent& OutFireEvent);
+	void PlayFireCosmetics(const FWeaponFireEvent& FireEvent);
+	void PlayFireSound(const FWeaponFireEvent& FireEvent);
+	void PlayMuzzleFlash(const FWeaponFireEvent& FireEvent);
+	//bCut also stops a one-shot sound still playing, UWeaponFireAudio cuts weapons whose voice it gives away
+	void StopFireSound(bool bCut);
+	void ResolveFireEvent(const FWeaponFireEvent& FireEvent, bool bApplyDamage, bool bRewindTargets);
+	void ReplicateFireEvent(const FWeaponFireEvent& FireEvent);
+	//server: shot requested by the owning client, false if rejected. OutAcceptedEvent is the shot as the server resolved it
+	bool FireFromRemoteEvent(const FWeaponFireEvent& FireEvent, FWeaponFireEvent& OutAcceptedEvent);
+	//client: shot of another player, cosmetic only
+	void SimulateFireEvent(const FWeaponFireEvent& FireEvent);
+
 	void UpdateStateWeapon(EMovementState NewMovementState);
 	void ChangeDispersionByShot();
+	//dispersion is evaluated from the last anchor when needed, nothing runs per frame
 	float GetCurrentDispersion() const;
-	FVector ApplyDispersionToShoot(FVector DirectionShoot)const;
+	void SetShouldReduceDispersion(bool bShouldReduce);
+	//freeze the current value as the new starting point, call before anything the evaluation depends on changes
+	void AnchorDispersion();
+	FVector ApplyDispersionToShoot(FVector DirectionShoot, float Dispersion, FRandomStream& Stream) const;
 
-	FVector GetFireEndLocation()const;
+	//all pellet directions of a shot into ShotSpread, muzzle and aim come from the event
+	void BuildShotSpread(const FWeaponFireEvent& FireEvent, FRandomStream& Stream);
 	int8 GetNumberProjectileByShot() const;
 
 	//Timers
@@ -96,14 +122,18 @@ public:
 
 	bool WeaponAiming = false;
 
-	//Dispersion
+	//Dispersion, Reduction is per frame at TPS.Dispersion.ReferenceFPS
 	bool ShouldReduceDispersion = false;
-	float CurrentDispersion = 0.0f;
+	float DispersionAnchor = 0.0f;
+	float DispersionAnchorTime = 0.0f;
 	float CurrentDispersionMax = 1.0f;
 	float CurrentDispersionMin = 0.1f;
 	float CurrentDispersionRecoil = 0.1f;
 	float CurrentDispersionReduction = 0.1f;
 
+	//status effects of the owning character, set by ATopDownShooterCharacter::SetStatusModifiers
+	FStatusEffectModifiers StatusModifiers;
+
 	//Timer Drop Magazine on reload
 	bool DropClipFlag = false;
 	float DropClipTimer = -1.0f;
@@ -114,6 +144,21 @@ public:
 
 	FVector ShootEndLocation = FVector(0);
 
+	//Pellets of the shot being resolved, kept to reuse the arrays
+	FShotSpread ShotSpread;
+	//WeaponSetting.SpreadPattern precomputed
+	FSpreadPattern SpreadPatternTable;
+
+	//Fire event
+	FRandomStream WeaponRandomStream;
+	uint16 ShotCounter = 0;
+	int32 WeaponSlotIndex = 0;
+	float LastRemoteFireTime = -1.0f;
+	//ShotIndex of the last accepted remote shot, INDEX_NONE before the first
+	int32 LastRemoteShotIndex = INDEX_NONE;
+	//several shots in one frame restart the muzzle flash once
+	uint64 MuzzleFlashFrame = MAX_uint64;
+
 	UFUNCTION(BlueprintCallable)
 	int32 GetWeaponRound();
 	void InitReload();
@@ -132,4 +177,6 @@ public:
 
 	UFUNCTION()
 	void InitDropMesh(UStaticMesh* DropMesh, FTransform Offset, FVector DropImpulseDirection, float LifeTimeMesh, float ImpulseRandomDispersion, float PowerImpulse, float CustomMass);
+	//deferred part of InitDropMesh, run by the spawn queue
+	void SpawnDropMesh(UStaticMesh* DropMesh, FTransform Transform, FVector LocalDir, FVector DropImpulseDirection, float LifeTimeMesh, float ImpulseRandomDispersion, float PowerImpulse, float CustomMass);
 };
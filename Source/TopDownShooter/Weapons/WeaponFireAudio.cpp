@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponFireAudio.h"
+#include "Weapons/WeaponDefault.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Engine/World.h"
+#include "TopDownShooter.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Audio Voices"), STAT_TPS_FireAudioVoices, STATGROUP_TopDownShooter);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Fire Audio Culled"), STAT_TPS_FireAudioCulled, STATGROUP_TopDownShooter);
+
+int32 FireAudioEnabled = 1;
+FAutoConsoleVariableRef CVARFireAudioEnabled(TEXT("TPS.FireAudio"), FireAudioEnabled, TEXT("Play fire sounds on one audio component per weapon under a shared voice budget, off spawns a sound per shot"), ECVF_Default);
+
+int32 FireAudioMaxVoices = 12;
+FAutoConsoleVariableRef CVARFireAudioMaxVoices(TEXT("TPS.FireAudio.MaxVoices"), FireAudioMaxVoices, TEXT("Weapons playing their fire sound at once"), ECVF_Default);
+
+float FireAudioMaxDistance = 6000.0f;
+FAutoConsoleVariableRef CVARFireAudioMaxDistance(TEXT("TPS.FireAudio.MaxDistance"), FireAudioMaxDistance, TEXT("Shots farther from the listener are not played, even if their attenuation reaches farther"), ECVF_Default);
+
+float FireAudioMinHoldTime = 0.25f;
+FAutoConsoleVariableRef CVARFireAudioMinHoldTime(TEXT("TPS.FireAudio.MinHoldTime"), FireAudioMinHoldTime, TEXT("Seconds a weapon keeps its voice after its last shot, at least"), ECVF_Default);
+
+bool UWeaponFireAudio::IsEnabled()
+{
+	return FireAudioEnabled != 0;
+}
+
+void UWeaponFireAudio::Deinitialize()
+{
+	Voices.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UWeaponFireAudio::IsTickable() const
+{
+	return Voices.Num() > 0 && !HasAnyFlags(RF_ClassDefaultObject);
+}
+
+TStatId UWeaponFireAudio::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UWeaponFireAudio, STATGROUP_Tickables);
+}
+
+bool UWeaponFireAudio::GetListenerDistanceSq(const FVector& Location, float& OutDistanceSq) const
+{
+	//split screen has one listener per local player, the shot is as loud as it is for the nearest one
+	bool bFound = false;
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* myController = It->Get();
+		if (!myController || !myController->IsLocalController())
+			continue;
+
+		FVector ListenerLocation;
+		FVector FrontDir;
+		FVector RightDir;
+		myController->GetAudioListenerPosition(ListenerLocation, FrontDir, RightDir);
+		const float DistanceSq = FVector::DistSquared(Location, ListenerLocation);
+		if (!bFound || DistanceSq < OutDistanceSq)
+			OutDistanceSq = DistanceSq;
+		bFound = true;
+	}
+	return bFound;
+}
+
+void UWeaponFireAudio::CountCulled()
+{
+	//per frame, Tick does not run while no voice is held
+	if (CulledFrame != GFrameCounter)
+	{
+		CulledFrame = GFrameCounter;
+		NumCulled = 0;
+	}
+	NumCulled++;
+	SET_DWORD_STAT(STAT_TPS_FireAudioCulled, NumCulled);
+}
+
+bool UWeaponFireAudio::AcquireVoice(AWeaponDefault* Weapon, const FVector& Location, float MaxDistance, float ShotInterval)
+{
+	float DistanceSq = 0.0f;
+	if (!Weapon || !GetListenerDistanceSq(Location, DistanceSq))
+		return false;
+
+	//culled before anything plays, not by the audio engine after the voice was started
+	if (DistanceSq > FMath::Square(FMath::Min(MaxDistance, FireAudioMaxDistance)))
+	{
+		CountCulled();
+		return false;
+	}
+
+	const float ReleaseTime = GetWorld()->GetTimeSeconds() + FMath::Max(ShotInterval * 2.0f, FireAudioMinHoldTime);
+	int32 FarthestIndex = INDEX_NONE;
+	for (int32 i = 0; i < Voices.Num(); i++)
+	{
+		if (Voices[i].Weapon == Weapon)
+		{
+			Voices[i].DistanceSq = DistanceSq;
+			Voices[i].ReleaseTime = ReleaseTime;
+			return true;
+		}
+		if (FarthestIndex == INDEX_NONE || Voices[i].DistanceSq > Voices[FarthestIndex].DistanceSq)
+			FarthestIndex = i;
+	}
+
+	if (Voices.Num() >= FireAudioMaxVoices)
+	{
+		if (FarthestIndex == INDEX_NONE || Voices[FarthestIndex].DistanceSq <= DistanceSq)
+		{
+			CountCulled();
+			return false;
+		}
+
+		//the farthest shooter goes silent mid burst, the closer one is what the player needs to hear
+		if (AWeaponDefault* myStolen = Voices[FarthestIndex].Weapon.Get())
+			myStolen->StopFireSound(true);
+		Voices.RemoveAtSwap(FarthestIndex, 1, false);
+	}
+
+	Voices.AddDefaulted();
+	FWeaponFireVoice& myVoice = Voices.Last();
+	myVoice.Weapon = Weapon;
+	myVoice.DistanceSq = DistanceSq;
+	myVoice.ReleaseTime = ReleaseTime;
+	return true;
+}
+
+void UWeaponFireAudio::ReleaseVoice(AWeaponDefault* Weapon)
+{
+	for (int32 i = 0; i < Voices.Num(); i++)
+	{
+		if (Voices[i].Weapon == Weapon)
+		{
+			Voices.RemoveAtSwap(i, 1, false);
+			return;
+		}
+	}
+}
+
+void UWeaponFireAudio::Tick(float DeltaTime)
+{
+	//bursts that stopped end their loop, one-shot sounds are left to finish
+	const float Now = GetWorld()->GetTimeSeconds();
+	for (int32 i = Voices.Num() - 1; i >= 0; i--)
+	{
+		AWeaponDefault* myWeapon = Voices[i].Weapon.Get();
+		if (myWeapon && Voices[i].ReleaseTime > Now)
+			continue;
+
+		Voices.RemoveAtSwap(i, 1, false);
+		if (myWeapon)
+			myWeapon->StopFireSound(false);
+	}
+
+	SET_DWORD_STAT(STAT_TPS_FireAudioVoices, Voices.Num());
+}
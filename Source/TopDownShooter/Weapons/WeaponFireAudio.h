@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Tickable.h"
+#include "WeaponFireAudio.generated.h"
+
+class AWeaponDefault;
+
+//One weapon allowed to play its fire sound, until ReleaseTime passes without another shot
+struct FWeaponFireVoice
+{
+	TWeakObjectPtr<AWeaponDefault> Weapon;
+	float DistanceSq = 0.0f;
+	float ReleaseTime = 0.0f;
+};
+
+/**
+ * Voice budget shared by the fire sounds of all weapons. A weapon plays its shots on its own FireAudio component
+ * (one voice per weapon, retriggered or looping), and only while it holds one of TPS.FireAudio.MaxVoices voices.
+ * Shots farther from the listener than the sound can be heard never take a voice; when all voices are taken,
+ * a closer shooter takes the voice of the farthest one.
+ */
+UCLASS()
+class TOPDOWNSHOOTER_API UWeaponFireAudio : public UWorldSubsystem, public FTickableGameObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	//FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	virtual UWorld* GetTickableGameObjectWorld() const override { return GetWorld(); }
+
+	//TPS.FireAudio, off means every shot spawns its own sound like before
+	static bool IsEnabled();
+
+	//true when Weapon may play this shot; the voice is kept until no shot came for twice ShotInterval
+	bool AcquireVoice(AWeaponDefault* Weapon, const FVector& Location, float MaxDistance, float ShotInterval);
+	void ReleaseVoice(AWeaponDefault* Weapon);
+
+	int32 GetNumVoices() const { return Voices.Num(); }
+
+private:
+	//to the nearest local player, false without one (dedicated server)
+	bool GetListenerDistanceSq(const FVector& Location, float& OutDistanceSq) const;
+	void CountCulled();
+
+	TArray<FWeaponFireVoice> Voices;
+	//shots culled during CulledFrame
+	int32 NumCulled = 0;
+	uint64 CulledFrame = 0;
+};